@@ -0,0 +1,75 @@
+#ifndef ACCESS_H
+#define ACCESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "trace.h"
+
+// Where and when a sort touches the array, built from its operation stream:
+// a compare reads its two elements, a swap reads and writes both, a write
+// writes one, a read reads one. The read and write totals count every
+// recorded op, so they are only as complete as the ops the sorts emit: a
+// key a sort already holds in a local is not read again, and a scratch
+// buffer's traffic shows up at the array index it stands for (radix passes)
+// or not at all (timsort's merge buffer). Three views of it:
+//  - heatmap: time (op number) x index, reads and writes counted apart.
+//    The time axis has a fixed number of columns; when the sort runs past
+//    the last one, columns are merged pairwise and each one covers twice
+//    as many ops.
+//  - stride: distance between consecutive indices touched (log2 bins).
+//  - reuse: ops since the same cache line (16 ints) was last touched
+//    (log2 bins), plus the first touches. A reuse far above the cache size
+//    in lines is a miss whatever the hardware.
+// Sampling keeps the cost flat at any N: the heatmap and the strides take
+// one op out of 'samplePeriod' (the period grows with the column width so
+// that a column holds at most ACCESS_SAMPLES_PER_COLUMN samples, each one
+// weighted by the period); the reuse distances follow every touch of a
+// fixed subset of the cache lines (chosen by hash, about
+// ACCESS_TRACKED_LINES of them), since a reuse needs both touches.
+// Kept SDL-free.
+
+#define ACCESS_TIME_BUCKETS 256  // heatmap columns
+#define ACCESS_INDEX_BUCKETS 128 // heatmap rows (fewer when the array is smaller)
+#define ACCESS_HISTOGRAM_BINS 32 // bin b: distances in [2^(b-1), 2^b), bin 0: distance 0
+#define ACCESS_SAMPLES_PER_COLUMN 4096
+#define ACCESS_TRACKED_LINES 4096
+#define ACCESS_LINE_SHIFT 4      // 16 ints per 64-byte cache line
+
+typedef struct {
+    int size; // length of the array
+    int rows; // index buckets used
+    uint64_t* reads;  // ACCESS_TIME_BUCKETS * rows, column-major (one column = rows counts)
+    uint64_t* writes;
+    int columns;           // columns with data
+    uint64_t opsPerColumn; // power of two
+    uint64_t samplePeriod; // power of two
+    uint64_t nextSample;   // op number of the next sampled op
+    uint64_t ops;          // ops seen
+    uint64_t readCount;    // every access of every op (not sampled)
+    uint64_t writeCount;
+    long long strides[ACCESS_HISTOGRAM_BINS];
+    long long reuses[ACCESS_HISTOGRAM_BINS];
+    long long coldLines; // first touches of the tracked lines
+    int lastIndex;       // last index touched by the previous op (-1: none)
+    uint32_t lineMask;   // tracked: hash(line) & lineMask == 0
+    uint64_t* lastTouch; // op number + 1 of the last touch per line (0: never), tracked lines only
+    int lineCount;
+} AccessMap;
+
+//return a pointer to an empty map, or NULL on failure.
+//implemented in access.c
+AccessMap* createAccessMap(void);
+
+//Empties the map for a sort of 'size' elements.
+//return 0, or -1 if memory ran out (the map then records nothing).
+//implemented in access.c
+int resetAccessMap(AccessMap* map, int size);
+
+//Adds the next 'count' ops of the sort, in order.
+//implemented in access.c
+void accessMapRecord(AccessMap* map, const TraceOp* ops, size_t count);
+
+//implemented in access.c
+void freeAccessMap(AccessMap* map);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include "arena.h"
+#include "stats.h"
+#include "trace.h"
+
+// Sorts that exploit the order already in the input: near-linear on sorted,
+// reversed, nearly sorted or run-structured arrays, O(n log n) otherwise.
+//  - TimSort: natural runs (strictly descending ones reversed) extended to
+//    minrun by binary insertion, merged under the run-stack invariants
+//    (with the 2015 fix); merges trim what is already in place and switch
+//    to galloping (exponential search) when one side keeps winning.
+//    Stable, needs n / 2 ints of scratch memory.
+//  - pdqsort (pattern-defeating quicksort): introsort with insertion sort
+//    on small ranges, a partition that reports when the range was already
+//    partitioned (then finished by a bounded insertion sort), a partition
+//    grouping the keys equal to the pivot, element shuffles on unbalanced
+//    partitions and heap sort after log2(n) of them. In place, not stable.
+// stats->naturalRuns counts the runs TimSort found, or the ranges pdqsort
+// found already sorted; stats->gallopHits counts the galloping searches of
+// TimSort that moved at least one element at once.
+// 'sink' (may be NULL) receives every op for the window.
+// Kept SDL-free.
+
+//The merge buffer comes from 'arena' (NULL: the heap).
+//return 0, or -1 if the merge buffer could not be allocated.
+//implemented in adaptive.c
+int tim_sort(int* tab, int size, Stats_t* stats, Arena* arena, OpSink* sink);
+
+//implemented in adaptive.c
+void pdq_sort(int* tab, int size, Stats_t* stats, OpSink* sink);
+
+//Same sorts with the counting and the trace compiled out (instrument.h).
+//tim_sort_raw takes its buffer from the heap: like tim_sort, it returns 0,
+//or -1 if the buffer could not be allocated (the array is left unsorted).
+//implemented in adaptive.c
+int tim_sort_raw(int* tab, int size);
+void pdq_sort_raw(int* tab, int size);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include "stats.h"
+
+// Scratch memory for the sorts that need a buffer (merge, radix, counting,
+// external, key-index). Owned by the caller like the Stats_t and handed to
+// the sort; the sort takes its buffers with arenaAlloc and the owner calls
+// arenaReset between runs instead of freeing anything.
+// A bump allocator over a list of blocks: when a run needs more than the
+// current block a new one is chained, and arenaReset folds the blocks into
+// one of the total size. From the second run of the same size on, the
+// arena never calls malloc again.
+// Not thread-safe: the sorts take their buffers on the calling thread
+// before handing the work to the pool.
+// Every allocation (arena or not) is counted in the stats: auxBytes in use,
+// auxPeakBytes (high-water mark of the run) and auxAllocations.
+// Kept SDL-free (used by the bench binary).
+
+#define ARENA_ALIGNMENT 64 // cache line: buffers never share a line
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next; // older blocks
+    size_t capacity;
+    size_t used;
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock* blocks;        // current block first (NULL: nothing yet)
+    size_t reserved;           // sum of the block capacities
+    long long heapAllocations; // blocks taken from malloc since the arena was created
+} Arena;
+
+//return a pointer to an empty arena holding 'capacity' bytes (0: first
+//block on the first allocation), or NULL if memory ran out.
+//implemented in arena.c
+Arena* createArena(size_t capacity);
+
+//'bytes' of scratch memory, 64-byte aligned, valid until arenaReset.
+//With arena == NULL it comes from the heap (arenaFree then frees it).
+//'stats' may be NULL.
+//return NULL if memory ran out.
+//implemented in arena.c
+void* arenaAlloc(Arena* arena, size_t bytes, Stats_t* stats);
+
+//Gives back an allocation of 'bytes'. Only the stats change with an arena
+//(the memory comes back on arenaReset); free() without one.
+//implemented in arena.c
+void arenaFree(Arena* arena, void* pointer, size_t bytes, Stats_t* stats);
+
+//Forgets every allocation; several blocks become a single one as large as
+//all of them, so the next run of the same size fits without malloc.
+//implemented in arena.c
+void arenaReset(Arena* arena);
+
+//implemented in arena.c
+void freeArena(Arena* arena);
+
+#endif
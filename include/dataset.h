@@ -0,0 +1,44 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <stdint.h>
+#include "pool.h"
+
+// Input arrays for the sorts.
+// Kept SDL-free so the bench binary can use the same inputs as the window.
+// Every array is a function of (distribution, size, maxValue, param, seed)
+// only: the same seed gives the same array on every machine and with any
+// number of threads. The work is cut into fixed chunks, each with its own
+// random stream (rng.h), and the chunks are spread over 'pool' when there
+// is one (NULL: all on the calling thread).
+
+// Input shapes
+#define DATASET_SHUFFLED      0 // random permutation of a ramp (the default)
+#define DATASET_SORTED        1
+#define DATASET_REVERSED      2
+#define DATASET_NEARLY_SORTED 3 // sorted, then 'param' random swaps (default size / 100)
+#define DATASET_FEW_UNIQUE    4 // 'param' distinct values in random order (default 8)
+#define DATASET_ORGAN_PIPE    5 // ascending to the middle, then descending
+#define DATASET_SAWTOOTH      6 // 'param' ascending ramps (default 8)
+#define DATASET_ZIPF          7 // value k with probability ~ 1 / k^s, s = param / 100 (default 1.0)
+#define DATASET_ALL_EQUAL     8
+#define DATASET_COUNT         9
+
+//array of 'size' values in [1, maxValue] shaped by 'distribution'
+//('param' <= 0 picks the default of the shape, see above).
+//return NULL if memory ran out.
+//implemented in dataset.c
+int* createDataset(int size, int maxValue, int distribution, int param, uint64_t seed, ThreadPool* pool);
+
+//random shuffled array with values spread over [1, maxValue]
+//(same as createDataset with DATASET_SHUFFLED)
+//implemented in dataset.c
+int* createRandomArray(int size, int maxValue, uint64_t seed);
+
+//Name of a distribution ("shuffled", "sorted", ...), and back.
+//datasetFromName returns -1 for an unknown name.
+//implemented in dataset.c
+const char* datasetName(int distribution);
+int datasetFromName(const char* name);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef EXTERNAL_H
+#define EXTERNAL_H
+
+#include <stddef.h>
+#include "arena.h"
+#include "pool.h"
+#include "stats.h"
+#include "trace.h"
+
+// External merge sort for files of native 32-bit ints larger than memory.
+//  1. run formation: the input is read in chunks that fit the memory budget,
+//     each chunk is sorted in memory and written to a temporary run file
+//  2. merge: up to 'fan-in' runs are merged at once through a loser tree
+//     (one comparison per tree level for every element), until one run is left
+// Files are read and written in large sequential blocks by two I/O threads
+// (one reading, one writing) with double buffering, so reading, sorting /
+// merging and writing overlap. The sort and merge buffers are counted as
+// scratch memory in the stats (auxPeakBytes, auxAllocations).
+// Kept SDL-free.
+
+// Called between blocks: 'phase' is "runs" or "merge", done/total in elements.
+typedef void (*ExternalProgressFn)(void* context, const char* phase, long long done, long long total);
+
+typedef struct {
+    size_t memoryBudget;         // bytes for the sort buffers and the merge buffers
+    const char* tempDir;         // where the runs go (NULL: current directory)
+    ThreadPool* pool;            // sorts the runs in parallel (NULL: intro_sort on this thread)
+    ExternalProgressFn progress; // may be NULL
+    void* progressContext;
+} ExternalConfig;
+
+//Sorts the ints of 'input' into 'output' (the two may not be the same file).
+//return 0, or -1 on an I/O error or if memory ran out (message on stderr).
+//implemented in external.c
+int external_sort_file(const char* input, const char* output, const ExternalConfig* config, Stats_t* stats);
+
+//Same algorithm on an array, for the window: runs of 'runSize' elements are
+//sorted one after another (TRACE_OWNER colors each run), then merged by the
+//loser tree, every output element showing up as a TRACE_WRITE.
+//The merge buffer and the tree come from 'arena' (NULL: the heap).
+//return 0, or -1 if the merge buffer could not be allocated.
+//implemented in external.c
+int external_sort(int* tab, int size, int runSize, Stats_t* stats, Arena* arena, OpSink* sink);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include "stats.h"
+
+// Counting policy of the sorting kernels.
+// Each algorithm is written once, as always-inline code that checks a
+// 'counted' flag known at compile time. Two entry points expand it: the
+// instrumented one (counted = 1) and the raw one (counted = 0), where the
+// compiler removes every count, leaving the plain sort.
+// The counts go to a local Counters (kept in registers once inlined) and
+// reach the Stats_t once per batch of work (a pass, a partition...) instead
+// of two pointer dereferences on every step.
+// Kept SDL-free.
+
+typedef struct {
+    long long comparisons;
+    long long memoryAccesses;
+} Counters;
+
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+
+// 'counted' must be a constant (or a const parameter of an inlined body)
+#define COUNT_COMPARISONS(counters, n) do { if (counted) (counters)->comparisons += (n); } while (0)
+#define COUNT_ACCESSES(counters, n)    do { if (counted) (counters)->memoryAccesses += (n); } while (0)
+
+// Adds the batch to the stats and starts a new one
+KERNEL_INLINE void flushCounters(Counters* counters, Stats_t* stats, const int counted) {
+    if (!counted) return;
+    stats->comparisons += counters->comparisons;
+    stats->memoryAccesses += counters->memoryAccesses;
+    counters->comparisons = 0;
+    counters->memoryAccesses = 0;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef INTROSORT_H
+#define INTROSORT_H
+
+#include "stats.h"
+#include "trace.h"
+
+// Hardened quick sort (introsort), next to the plain quick_sort:
+//  - pivot = median of three (ninther = median of three medians above 128 elements)
+//  - Hoare partition (fewer swaps than Lomuto, no O(n^2) on equal keys)
+//  - ranges of 32 elements or less finished by a sorting network (network.h),
+//    or ranges of 16 by insertion sort when the networks are turned off
+//  - heap sort fallback once 2*log2(n) partition levels are exceeded
+//  - no recursion: the smaller side is sorted first, the larger one waits on
+//    an explicit stack, so the stack never holds more than log2(n) ranges
+// 'sink' (may be NULL) receives every op for the window.
+// Kept SDL-free.
+
+//implemented in introsort.c
+void intro_sort(int* tab, int size, Stats_t* stats, OpSink* sink);
+
+//Same sort with the counting and the trace compiled out (instrument.h).
+//implemented in introsort.c
+void intro_sort_raw(int* tab, int size);
+
+// Selection, for when only the k smallest elements matter (k is clamped to
+// 1 .. size). Built on the same pivot and partition:
+//  - quick_select (nth_element): tab[k - 1] is the k-th smallest, nothing
+//    greater before it, nothing smaller after it. Introselect: the side
+//    without rank k is dropped, heap select once 2*log2(n) partition levels
+//    are exceeded. O(n) on average.
+//  - heap_top_k: the k smallest, sorted, in tab[0 .. k), through a max-heap
+//    of k elements. O(n log k), a single pass over the input: best for small k.
+//  - partial_sort: quick_select, then introsort of tab[0 .. k - 1).
+//    O(n + k log k).
+// The rest of the array is left in no particular order. The ranges they
+// drop are marked with owner SELECT_DISCARD_COLOR (TRACE_OWNER) for the window.
+#define SELECT_DISCARD_COLOR 12
+#define SELECT_DEFAULT_FRACTION 10 // k = size / 10 when none is given
+
+// k used on an array of 'size' elements ('k' = 0: size / SELECT_DEFAULT_FRACTION)
+static inline int selectRank(int k, int size) {
+    if (k <= 0) k = size / SELECT_DEFAULT_FRACTION;
+    return k < 1 ? 1 : (k > size ? size : k);
+}
+
+//implemented in introsort.c
+void quick_select(int* tab, int size, int k, Stats_t* stats, OpSink* sink);
+void heap_top_k(int* tab, int size, int k, Stats_t* stats, OpSink* sink);
+void partial_sort(int* tab, int size, int k, Stats_t* stats, OpSink* sink);
+
+//Same selections with the counting and the trace compiled out.
+//implemented in introsort.c
+void quick_select_raw(int* tab, int size, int k);
+void heap_top_k_raw(int* tab, int size, int k);
+void partial_sort_raw(int* tab, int size, int k);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "stats.h"
+
+// Headless versions of the sorting algorithms.
+// Same logic and same counters as sorting.c, but no window, no events
+// and no delays, so the timing measures the algorithm only.
+// Every kernel also has a _raw variant generated from the same code with
+// the counting compiled out (instrument.h), to measure what counting costs.
+// These files must stay SDL-free (used by the bench binary).
+
+//implemented in kernels.c
+void kernel_bubble_sort(int* tab, int size, Stats_t* stats);
+void kernel_bubble_sort_raw(int* tab, int size);
+
+//implemented in kernels.c
+void kernel_selection_sort(int* tab, int size, Stats_t* stats);
+void kernel_selection_sort_raw(int* tab, int size);
+
+//implemented in kernels.c
+void kernel_insertion_sort(int* tab, int size, Stats_t* stats);
+void kernel_insertion_sort_raw(int* tab, int size);
+
+//implemented in kernels.c
+void kernel_quick_sort(int* tab, int size, Stats_t* stats);
+void kernel_quick_sort_raw(int* tab, int size);
+
+#endif
@@ -4,31 +4,129 @@
 // include these here so the App_Window struct understands the types
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include <stdint.h> // For the array seed
 
 #include "stats.h" 
+#include "arena.h"
+#include "trace.h"
+#include "access.h"
+#include "worker.h"
+#include "text.h"
+
+// Buffers reused by drawArray from frame to frame
+typedef struct {
+    // batched path (size <= sort zone width)
+    SDL_FRect* rects;
+    SDL_FRect* sortedRects; // same bars grouped by owner color
+    int rectCapacity;
+
+    // per-column path (size > sort zone width)
+    SDL_Texture* texture; // streaming, one pixel column per array slice
+    int textureHeight;
+    int columns;          // 0 until the column buffers exist
+    int* colMin;          // bar heights in pixels (values scaled to the zone)
+    int* colMax;
+    unsigned char* dirty; // columns to rescan
+    int anyDirty;
+    int allDirty;
+} BarCache;
+
+// One algorithm of a race: its own copy of the input, sort thread and replay
+typedef struct {
+    int algorithm;          // registry id, 1 .. ALGO_MAX (plugins included)
+    int* array;             // replayed copy of the input
+    unsigned char* owners;  // worker colors (parallel sorts)
+    int size;               // elements in array / owners
+    BarCache* bars;
+    Stats_t* stats;
+    Arena* arena;           // scratch memory of this lane's sorts
+    SortWorker* worker;
+    Trace* trace;
+    size_t replayCursor;
+    int highlight1;
+    int highlight2;
+} RaceLane;
+
+#define RACE_MAX_LANES 8
+
+// Race mode: the same input sorted by several algorithms at once, each on its own thread
+typedef struct {
+    RaceLane lanes[RACE_MAX_LANES];
+    int laneCount;
+    int started; // 1 once 'S' started the lanes (until the next reset)
+} Race;
 
 // Main structure to hold all application components
 typedef struct {
     // SDL components
-    SDL_Window* window;
+    SDL_Window* window;     // NULL when headless
+    SDL_Surface* frame;     // headless: offscreen ARGB8888 surface the renderer draws into
     SDL_Renderer* renderer;
     TTF_Font* font;
+    GlyphAtlas* atlas; // text drawing (built once from font)
 
     // Application data
+    int size;     // number of elements ('N' multiplies it by 10, Shift+N divides)
+    int maxValue; // values are in [1, maxValue] (0: [1, size]), drawn scaled to the window height
     int* array;
+    unsigned char* owners; // worker owning each element (parallel sorts), 0 = none
+    BarCache* bars; // drawing buffers for the array
     
     // Application state
     int running;
     int selectedAlgorithm;
+    int selectK;      // k of the selections (M, K, L), 0: N / 10 whatever N
+    int distribution; // input shape (DATASET_*), 'D' cycles through them
+    uint64_t seed;    // seed of the current array ('R' moves to the next one)
 
     // Pointer to the statistics data
     Stats_t* stats;
 
+    // Scratch memory of the sorts, reset (not freed) between runs
+    Arena* arena;
+
+    // Sort running on its own thread
+    SortWorker* worker;
+
+    // Race mode ('C'): the number keys pick the lanes instead of one algorithm
+    int raceMode;
+    Race* race;
+
+    // Recorded operations of the sort and replay position
+    Trace* trace;
+    size_t replayCursor; // number of ops already shown
+    int replaySpeed;     // ops replayed per frame
+    int playing;         // 1 while the replay advances on its own
+    int highlight1;      // indices touched by the last replayed op
+    int highlight2;
+
+    // Where and when the sort touches the array ('H' shows it under the bars)
+    AccessMap* access;
+    SDL_Texture* accessTexture; // heatmap pixels, uploaded each frame it is shown
+    int showAccess;
+
+    // Current window size (the window is resizable)
+    int windowWidth;
+    int windowHeight;
+
 } App_Window;
 
-// Global constants (define in main.c)
-extern const int WINDOW_WIDTH;
-extern const int WINDOW_HEIGHT;
-extern const int N; // array size
+// Startup settings, from the command line (see main.c)
+typedef struct {
+    int windowWidth;
+    int windowHeight;
+    int size;
+    int maxValue; // 0: same as size (each value about once)
+    int headless; // 1: no window, frames drawn offscreen (recording)
+    int showAccess; // 1: access heatmap and histograms shown from the start
+    int selectK;    // k of the selections, 0: N / 10
+} AppConfig;
+
+#define MENU_WIDTH 200         // right-hand menu; the bars get the rest of the width
+#define LEGEND_ROWS_HEIGHT 330 // menu height for the algorithm rows (y = 20 to 350)
+#define MIN_WINDOW_WIDTH 500
+#define MIN_WINDOW_HEIGHT 600  // the menu needs the whole height
+#define MIN_ARRAY_SIZE 10
+#define MAX_ARRAY_SIZE 10000000 // 'N' goes from 10 to 10^7 and wraps around
 
 #endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include "stats.h"
+#include "trace.h"
+
+// Bitonic sorting networks for small blocks (8, 16, 32 or 64 elements).
+// A network is a fixed list of stages; every stage is a set of independent
+// compare-exchanges, so a whole stage runs as a few vector min/max.
+// Three implementations: AVX2 (8 lanes), SSE4.1 (4 lanes) and scalar
+// (branchless). The best one the CPU supports is picked at runtime (CPUID),
+// no special compiler flag is needed.
+// Used as the leaf case of intro_sort and of the parallel quick/merge sorts.
+// Kept SDL-free.
+
+#define NETWORK_MAX_BLOCK 64 // largest block a network sorts
+#define NETWORK_LEAF 32      // leaf ranges up to this size go to a network
+
+// Implementations (NETWORK_OFF: leaves use insertion sort again)
+#define NETWORK_OFF    0
+#define NETWORK_SCALAR 1
+#define NETWORK_SSE4   2
+#define NETWORK_AVX2   3
+
+// Owner colors the traced network alternates between, one per stage
+#define NETWORK_STAGE_COLOR 14
+
+//Picks the implementation: "auto" (best supported), "avx2", "sse4", "scalar" or "off".
+//return 0, or -1 if the name is unknown or the CPU lacks the instructions.
+//implemented in network.c
+int setNetworkMode(const char* name);
+
+//Current implementation (NETWORK_OFF .. NETWORK_AVX2) and its name.
+//implemented in network.c
+int networkMode(void);
+const char* networkModeName(void);
+
+//Sorts tab[0 .. size) with size <= NETWORK_MAX_BLOCK (padded to the next block size).
+//Uses the scalar network when the mode is NETWORK_OFF.
+//implemented in network.c
+void network_sort(int* tab, int size, Stats_t* stats);
+
+//Same network with the counting compiled out (instrument.h).
+//implemented in network.c
+void network_sort_raw(int* tab, int size);
+
+//Same network on tab[low .. low + size), one op per compare-exchange for 'sink'.
+//Each stage first recolors the block (TRACE_OWNER, alternating between
+//NETWORK_STAGE_COLOR and the next id) so that it shows as one parallel step;
+//the block is given back to 'owner' at the end (owner < 0: left as is).
+//implemented in network.c
+void network_sort_traced(int* tab, int low, int size, Stats_t* stats, OpSink* sink, int owner);
+
+//Leaf case of the quick and merge sorts: sorts tab[low .. low + size) with a
+//network when networks are enabled and size <= NETWORK_LEAF ('sink' may be NULL).
+//return 1 if the range was sorted, 0 if the caller must sort it itself.
+//implemented in network.c
+int network_leaf(int* tab, int low, int size, Stats_t* stats, OpSink* sink, int owner);
+
+//Leaf case of the raw sorts: network_sort_raw under the same conditions.
+//implemented in network.c
+int network_leaf_raw(int* tab, int low, int size);
+
+#endif
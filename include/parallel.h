@@ -0,0 +1,32 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "arena.h"
+#include "pool.h"
+#include "stats.h"
+#include "trace.h"
+
+// Parallel sorts run on the work-stealing pool.
+// Ranges longer than 'cutoff' are split into tasks; shorter ones are sorted
+// sequentially by the worker that owns them, down to leaves of NETWORK_LEAF
+// elements sorted by a sorting network (network.h). Every worker keeps its own
+// counters, summed into 'stats' at the end.
+// 'sink' (may be NULL) receives every op plus a TRACE_OWNER op each time a
+// worker takes a range, so the window can color the ranges by worker.
+// Kept SDL-free.
+
+//Quick sort: ninther Hoare partition, smaller side spawned as a task, larger side looped.
+//return 0 (same shape as parallel_merge_sort).
+//implemented in parallel.c
+int parallel_quick_sort(int* tab, int size, Stats_t* stats, ThreadPool* pool, int cutoff, OpSink* sink);
+
+//Merge sort: both halves sorted in parallel, then merged in parallel
+//(split at the median of the larger run, binary search in the other).
+//The merges keep equal keys in order, but the network leaves (network.h)
+//do not, so the sort is not stable unless the networks are off.
+//The buffer comes from 'arena' (NULL: the heap).
+//return 0, or -1 if the merge buffer could not be allocated.
+//implemented in parallel.c
+int parallel_merge_sort(int* tab, int size, Stats_t* stats, ThreadPool* pool, Arena* arena, int cutoff, OpSink* sink);
+
+#endif
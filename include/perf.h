@@ -0,0 +1,49 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include "pool.h"
+#include "stats.h"
+
+// Hardware performance counters around a sort (Linux perf_event_open):
+// cycles, instructions, branch misses, L1D / LLC misses and dTLB misses
+// (user space only). One set of counters per thread: the calling thread
+// plus every worker of the pool the sort runs on. A counter the CPU, the
+// kernel (perf_event_paranoid) or a virtual machine does not provide is
+// simply left out, and nothing is measured on other systems.
+// When there are more events than hardware counters the kernel multiplexes
+// them; values are scaled by the fraction of the time they were counting.
+// Kept SDL-free (used by the bench binary).
+
+typedef struct {
+    int fds[POOL_MAX_THREADS][HW_COUNTER_COUNT]; // -1: not open
+    int threadCount;
+    unsigned int opened; // bit i: counter i open on every thread
+} PerfCounters;
+
+//Opens the counters (stopped, at zero) on the calling thread and on the
+//workers of 'pool' (may be NULL).
+//return the bit mask of the counters that could be opened (0: none).
+//implemented in perf.c
+unsigned int perfOpen(PerfCounters* perf, ThreadPool* pool);
+
+//Starts / stops counting (cheap: an ioctl per counter).
+//implemented in perf.c
+void perfEnable(PerfCounters* perf);
+void perfDisable(PerfCounters* perf);
+
+//Adds the counts so far to stats->hardware and marks them valid.
+//implemented in perf.c
+void perfRead(PerfCounters* perf, Stats_t* stats);
+
+//implemented in perf.c
+void perfClose(PerfCounters* perf);
+
+//0 turns the counters off (perfOpen then opens nothing). Default on.
+//implemented in perf.c
+void setPerfEnabled(int enabled);
+
+//Short name of a counter ("cycles", "instructions", ...).
+//implemented in perf.c
+const char* perfCounterName(int counter);
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+// Work-stealing thread pool for the parallel sorts (fork/join).
+// Every worker owns a deque: it pushes and pops its own tasks at the bottom
+// (newest first, good locality) and idle workers steal the oldest task from
+// the top of another deque (largest pieces of work first).
+// Kept SDL-free (used by the bench binary).
+
+#define POOL_MAX_THREADS 64
+
+typedef void (*TaskFn)(void* arg);
+
+typedef struct {
+    TaskFn fn;
+    void* arg;
+    struct TaskGroup* group;
+} Task;
+
+// Tasks spawned together; poolWait() returns when all of them have run.
+typedef struct TaskGroup {
+    atomic_int pending;
+} TaskGroup;
+
+typedef struct {
+    pthread_mutex_t lock;
+    Task* tasks;
+    int capacity; // power of two
+    int top;      // steal end (oldest)
+    int bottom;   // owner end (newest)
+} TaskDeque;
+
+typedef struct ThreadPool {
+    int threadCount; // workers including the thread that calls poolRun()
+    pthread_t threads[POOL_MAX_THREADS];
+    TaskDeque deques[POOL_MAX_THREADS];
+
+    pthread_mutex_t sleepLock;
+    pthread_cond_t wake;
+    atomic_int running;  // 1 while poolRun() is in progress
+    atomic_int shutdown;
+
+    // kernel thread id of every worker (0 for worker 0, which is whoever
+    // calls poolRun, and everywhere but Linux), for the hardware counters
+    int systemIds[POOL_MAX_THREADS];
+    atomic_int started; // workers that have set their id
+
+    // called by a worker before a task it spawns can be stolen and after each
+    // task it runs (NULL: none), so work a worker buffered is published in
+    // fork/join order (worker.c flushes its per-worker op buffers there)
+    void (*syncHook)(void* context);
+    void* syncContext;
+} ThreadPool;
+
+//threads <= 0 means one per online core
+//return NULL on failure.
+//implemented in pool.c
+ThreadPool* createThreadPool(int threads);
+
+//implemented in pool.c
+void freeThreadPool(ThreadPool* pool);
+
+//Sets the hook called at the fork/join points (only while no poolRun is in progress).
+//implemented in pool.c
+void poolSetSyncHook(ThreadPool* pool, void (*hook)(void* context), void* context);
+
+//Runs fn(arg) on the calling thread as worker 0, with the other workers
+//stealing the tasks it spawns. fn must poolWait() every group it spawns into.
+//implemented in pool.c
+void poolRun(ThreadPool* pool, TaskFn fn, void* arg);
+
+//Queues fn(arg) on the current worker (only from inside poolRun).
+//implemented in pool.c
+void poolSpawn(ThreadPool* pool, TaskGroup* group, TaskFn fn, void* arg);
+
+//Runs queued and stolen tasks until every task of 'group' is done.
+//implemented in pool.c
+void poolWait(ThreadPool* pool, TaskGroup* group);
+
+//Index of the calling worker in [0, threadCount), or 0 outside the pool.
+//implemented in pool.c
+int poolWorkerId(void);
+
+//Kernel id of the calling thread (Linux), 0 elsewhere.
+//implemented in pool.c
+int poolSystemThreadId(void);
+
+//Keeps a thread on one core (cpu modulo the core count), so that timings
+//do not move with the scheduler. poolPinWorkers puts worker i on firstCpu + i
+//(worker 0, the caller of poolRun, is pinned by the caller itself).
+//return 0, or -1 if not supported (anywhere but Linux) or refused.
+//implemented in pool.c
+int poolPinThread(pthread_t thread, int cpu);
+int poolPinWorkers(ThreadPool* pool, int firstCpu);
+
+//Online cores (at least 1).
+//implemented in pool.c
+int poolCoreCount(void);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef RACE_H
+#define RACE_H
+
+#include "main.h"
+
+// Race mode: 2 to 8 algorithms sort copies of the same array at the same
+// time, each lane on its own sort thread (worker.h) with its own stats,
+// scratch arena and trace. The lanes are replayed at the same number of
+// operations per frame, and ranked by the time their sort thread measured
+// (waits on a full ring or on pause excluded), so the order does not depend
+// on the display.
+
+//return a pointer to an empty race (no lanes), or NULL on failure.
+//implemented in race.c
+Race* createRace(void);
+
+//Stops every lane and frees them.
+//implemented in race.c
+void freeRace(Race* race);
+
+//Adds 'algorithm' (a registry id, 1 .. ALGO_MAX, plugins included) as a new
+//lane, or removes it if it is already in the race. Stops a race in progress first.
+//return 0, or -1 if the race is full or memory ran out.
+//implemented in race.c
+int toggleRaceLane(Race* race, int algorithm);
+
+//1 if 'algorithm' has a lane.
+//implemented in race.c
+int hasRaceLane(const Race* race, int algorithm);
+
+//Starts every lane on a copy of 'array' ('k': rank of the selections).
+//return 0, or -1 if a lane could not start (the others are stopped).
+//implemented in race.c
+int startRace(Race* race, const int* array, int size, int k);
+
+//Stops the sort threads and forgets the traces (the lanes stay).
+//implemented in race.c
+void stopRace(Race* race);
+
+//implemented in race.c
+void pauseRace(Race* race, int paused);
+
+//One frame: collects what every sort thread produced and replays 'speed'
+//more operations in every lane (0: only collects, when paused).
+//return 1 while a lane still has operations to show, 0 once all are done.
+//implemented in race.c
+int updateRace(Race* race, int speed);
+
+//Moves every lane to 'position' ops (-1: the last recorded op), or by
+//'delta' ops from where it is when 'position' is -2.
+//implemented in race.c
+void seekRace(Race* race, long long position, long long delta);
+
+//1 when the sort of 'lane' is over and all its ops are in the trace.
+//implemented in race.c
+int raceLaneFinished(const RaceLane* lane);
+
+//Position of the lane in the finish order (1 = fastest sort), 0 while running.
+//implemented in race.c
+int raceLaneRank(const Race* race, int lane);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef RADIX_H
+#define RADIX_H
+
+#include <stdint.h>
+#include "arena.h"
+#include "pool.h"
+#include "stats.h"
+#include "trace.h"
+
+// Non-comparison sorts for bounded integer keys.
+// Both start with a histogram pass split into chunks over the pool (one
+// private histogram per chunk, summed afterwards); 'pool' may be NULL to
+// run it on the calling thread. Their buffers come from 'arena' (NULL: the
+// heap). Every element moved is one write in stats->memoryAccesses and one
+// TRACE_WRITE op for 'sink' (may be NULL).
+// Kept SDL-free.
+
+//Counting sort: one histogram of (value - min), then the array is rewritten
+//from the counts. Best when max - min is not much larger than size.
+//return 0, or -1 if the value range is too wide or memory ran out.
+//implemented in radix.c
+int counting_sort(int* tab, int size, Stats_t* stats, ThreadPool* pool, Arena* arena, OpSink* sink);
+
+//LSD radix sort, one byte per pass (4 passes), stable, ping-pong buffer.
+//The histograms of all the bytes are taken in a single read of the array;
+//a pass where every key has the same byte is skipped.
+//return 0, or -1 if the buffer could not be allocated.
+//implemented in radix.c
+int radix_sort(int* tab, int size, Stats_t* stats, ThreadPool* pool, Arena* arena, OpSink* sink);
+
+//Same on 64-bit keys (8 passes, most of them skipped on small values).
+//implemented in radix.c
+int radix_sort64(int64_t* tab, int size, Stats_t* stats, ThreadPool* pool, Arena* arena);
+
+#endif
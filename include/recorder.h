@@ -0,0 +1,63 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "pool.h"
+
+// Streams rendered frames to a file or a pipe as raw video:
+//  - Y4M (YUV4MPEG2, 4:2:0, BT.601 limited range): read directly by ffmpeg,
+//    mpv, x264... with the frame rate in the header
+//  - PPM: one binary P6 image per frame, back to back (ffmpeg -f image2pipe)
+// Frames come in as ARGB8888 pixels. The color conversion, the per-pixel
+// work, is split into bands of rows over a thread pool of its own, and a
+// writer thread sends the previous frame to the file meanwhile (two frame
+// buffers), so the caller only waits when the disk or the pipe is slower.
+// Kept SDL-free.
+
+#define FRAME_Y4M 0
+#define FRAME_PPM 1
+
+typedef struct {
+    FILE* file;
+    int format;
+    int width;  // even (4:2:0 chroma is one sample per 2x2 pixels)
+    int height;
+    ThreadPool* pool;
+    unsigned char* buffers[2];
+    size_t frameBytes; // one encoded frame, header included
+    size_t headerBytes;
+    int next; // buffer the next frame is converted into
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    int pending[2]; // 1 from the end of the conversion until written
+    int stop;
+    int failed;
+    long long frames;
+} FrameWriter;
+
+//Opens 'path' ("-": standard output, which is then moved to stderr so that
+//messages do not end up in the video) and writes the stream header.
+//'width' and 'height' are rounded down to even numbers.
+//return NULL on failure (message on stderr).
+//implemented in recorder.c
+FrameWriter* createFrameWriter(const char* path, int format, int width, int height, int fps);
+
+//Encodes one frame of ARGB8888 pixels ('pitch' bytes per row) and queues it.
+//return 0, or -1 if a write failed (the stream is then truncated).
+//implemented in recorder.c
+int writeFrame(FrameWriter* writer, const void* pixels, int pitch);
+
+//Writes what is queued and closes the file.
+//return 0, or -1 if any write failed.
+//implemented in recorder.c
+int closeFrameWriter(FrameWriter* writer);
+
+//FRAME_Y4M / FRAME_PPM from "y4m" / "ppm", -1 if unknown.
+//implemented in recorder.c
+int frameFormatFromName(const char* name);
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include "arena.h"
+#include "pool.h"
+#include "stats.h"
+#include "trace.h"
+
+// Every algorithm the window, the recorder and the bench know, as one
+// descriptor each: the menu rows, the keys, the race names and the bench
+// list are all built from this table. Ids are 1 .. algorithmCount(), the
+// built-ins first (1 to 18, the first 15 as the keys always were), then what was
+// registered at startup: shared-object plugins (--plugin) and the bench's
+// own element-type variants.
+// Kept SDL-free.
+
+#define ALGO_MAX 40 // ids stay below the window's other action codes (50 and up)
+
+// Extra memory of a run, besides the array itself
+#define ALGO_MEMORY_CONSTANT 0 // O(1)
+#define ALGO_MEMORY_LOG      1 // O(log n): recursion or range stack
+#define ALGO_MEMORY_LINEAR   2 // O(n) buffer
+#define ALGO_MEMORY_RANGE    3 // O(n + max - min): one counter per value
+
+// Key types the kernel family sorts (bit mask); the window and the entry
+// points below work on int, the other types are bench variants (typed.h)
+// or, for strings, keys built from the ints inside the run
+#define KEY_INT32   1
+#define KEY_INT64   2
+#define KEY_FLOAT64 4
+#define KEY_RECORD  8
+#define KEY_STRING  16 // strsort.h: the int values sorted as generated keys
+
+#define ALGO_QUADRATIC     1 // O(n^2): the bench caps its sizes
+#define ALGO_PARALLEL      2 // runs on context->pool (the bench sweeps the thread count)
+#define ALGO_SELECT_NTH    4 // selection: tab[k - 1] in place, smaller before, larger after
+#define ALGO_SELECT_PREFIX 8 // selection: the k smallest, sorted, in tab[0 .. k)
+#define ALGO_SELECTION (ALGO_SELECT_NTH | ALGO_SELECT_PREFIX)
+#define ALGO_ADVERSARIAL 16 // O(n^2) on ordered or repeated input: the bench caps those shapes like ALGO_QUADRATIC
+
+// Window control keys: never given to an algorithm
+#define ALGO_RESERVED_KEYS "SERDNCH"
+#define ALGO_NO_KEY '-' // not in the menu (bench only: --algo NAME)
+
+// What a run may use besides the array
+typedef struct {
+    ThreadPool* pool; // parallel sorts (may be NULL for some: then one thread)
+    Arena* arena;     // scratch memory (NULL: the heap)
+    int k;            // rank of the selections, 1 .. size
+    int cutoff;       // parallel sorts: ranges below this are sorted by one worker
+} SortContext;
+
+//Sorts tab[0 .. size), counting into 'stats' and sending every op to 'sink' (may be NULL).
+//return 0, or -1 on failure (out of memory...: see 'failure').
+typedef int (*SortEntry)(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink);
+//Same sort with the counting and the trace compiled out (instrument.h).
+//return 0, or -1 on failure (same meaning as for 'run').
+typedef int (*RawSortEntry)(int* tab, int size, const SortContext* context);
+
+typedef struct {
+    const char* name;    // command line / bench name, unique
+    const char* label;   // menu text (NULL: the name)
+    char key;            // menu key, '0' .. '9' or 'A' .. 'Z' (0: pick a free letter, ALGO_NO_KEY: none)
+    int machine;         // > 0: sorting.c state machine the window steps instead of 'run'
+    SortEntry run;
+    RawSortEntry raw;    // NULL: none
+    int stable;          // 1: equal keys keep their order
+    int memory;          // ALGO_MEMORY_*
+    unsigned keyTypes;   // KEY_*
+    unsigned flags;      // ALGO_*
+    const char* failure; // what run() returning -1 means (NULL: "failed")
+} AlgorithmInfo;
+
+/*
+----------------------------------------------------
+ PLUGINS
+----------------------------------------------------
+ A plugin is a shared object that includes this header and exports
+
+   const AlgorithmInfo* sortPluginAlgorithms(int abi, int* count);
+
+ returning its descriptors (kept alive by the plugin: it is never
+ unloaded) and their number, or NULL if it was built for another ABI.
+ Plugins give 'run' (and optionally 'raw'), never 'machine'. The ABI
+ changes whenever AlgorithmInfo, SortContext, Stats_t or TraceOp do.
+----------------------------------------------------
+*/
+#define SORT_PLUGIN_ABI 3
+#define SORT_PLUGIN_SYMBOL "sortPluginAlgorithms"
+typedef const AlgorithmInfo* (*SortPluginFn)(int abi, int* count);
+
+//implemented in registry.c
+int algorithmCount(void);
+
+//return the descriptor of 'id' (1 .. algorithmCount()), or NULL.
+//implemented in registry.c
+const AlgorithmInfo* algorithmInfo(int id);
+
+//return the id of the algorithm called 'name', or 0.
+//implemented in registry.c
+int findAlgorithm(const char* name);
+
+//return the id of the algorithm on 'key' (either case), or 0.
+//implemented in registry.c
+int findAlgorithmByKey(int key);
+
+//Adds a copy of 'info'. A key that is taken or reserved is replaced by a
+//free letter (no key at all once they are all taken).
+//return the new id, or -1 (message on stderr) if the name is taken,
+//there is no entry point or the table is full.
+//implemented in registry.c
+int registerAlgorithm(const AlgorithmInfo* info);
+
+//dlopen()s 'path' and registers its algorithms.
+//return how many were registered, or -1 (message on stderr).
+//implemented in registry.c
+int loadAlgorithmPlugin(const char* path);
+
+//"O(1)", "O(log n)"... for ALGO_MEMORY_*
+//implemented in registry.c
+const char* algorithmMemoryName(int memory);
+
+#endif
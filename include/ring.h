@@ -0,0 +1,51 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include "trace.h"
+
+// Single-producer / single-consumer lock-free queue of trace operations.
+// The sort worker pushes, the window thread pops; neither ever takes a lock.
+// Kept SDL-free.
+
+#define RING_CACHE_LINE 64
+
+typedef struct {
+    // written by the producer only
+    _Alignas(RING_CACHE_LINE) atomic_size_t head;
+    // written by the consumer only (own cache line: no false sharing with head)
+    _Alignas(RING_CACHE_LINE) atomic_size_t tail;
+
+    _Alignas(RING_CACHE_LINE) TraceOp* ops;
+    size_t capacity; // power of two
+    size_t mask;
+} OpRing;
+
+//capacity is rounded up to a power of two
+//return NULL on failure.
+//implemented in ring.c
+OpRing* createOpRing(size_t capacity);
+
+//implemented in ring.c
+void freeOpRing(OpRing* ring);
+
+//Producer side: copies up to 'count' ops.
+//return how many were pushed (less than count when the ring is full).
+//implemented in ring.c
+size_t ringPush(OpRing* ring, const TraceOp* ops, size_t count);
+
+//Consumer side: copies up to 'max' ops into 'out'.
+//return how many were popped (0 when empty).
+//implemented in ring.c
+size_t ringPop(OpRing* ring, TraceOp* out, size_t max);
+
+//Number of ops queued (exact on the consumer side)
+//implemented in ring.c
+size_t ringSize(OpRing* ring);
+
+//Consumer side: drops everything queued (only when the producer is stopped).
+//implemented in ring.c
+void ringClear(OpRing* ring);
+
+#endif
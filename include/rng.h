@@ -0,0 +1,66 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Small fast PRNG: xoshiro256** seeded through splitmix64.
+// Same seed, same sequence on every machine. Each thread or chunk of work
+// gets its own generator (rngSeed with a different stream number), so
+// parallel generation stays reproducible whatever the thread count.
+// Kept SDL-free, header only.
+
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+static inline uint64_t splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Generator number 'stream' of 'seed' (streams are independent sequences)
+static inline void rngSeed(Rng* rng, uint64_t seed, uint64_t stream) {
+    uint64_t state = seed ^ (stream * 0xD1B54A32D192ED03ull);
+    for (int i = 0; i < 4; i++) rng->s[i] = splitmix64(&state);
+}
+
+static inline uint64_t rngRotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rngNext(Rng* rng) {
+    uint64_t* s = rng->s;
+    uint64_t result = rngRotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rngRotl(s[3], 45);
+    return result;
+}
+
+// Uniform in [0, bound) without modulo bias (Lemire: multiply, reject the
+// few low products that would favor some values). bound must be > 0.
+static inline uint32_t rngBounded(Rng* rng, uint32_t bound) {
+    uint64_t product = (uint64_t)(uint32_t)(rngNext(rng) >> 32) * bound;
+    uint32_t low = (uint32_t)product;
+    if (low < bound) {
+        uint32_t threshold = (uint32_t)(-bound) % bound;
+        while (low < threshold) {
+            product = (uint64_t)(uint32_t)(rngNext(rng) >> 32) * bound;
+            low = (uint32_t)product;
+        }
+    }
+    return (uint32_t)(product >> 32);
+}
+
+// Uniform in [0, 1)
+static inline double rngDouble(Rng* rng) {
+    return (double)(rngNext(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+#endif
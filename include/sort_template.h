@@ -0,0 +1,215 @@
+// Sorts generated for one element type (no include guard: included once per type).
+//
+// Define before including:
+//   SORT_NAME        prefix of the generated functions (e.g. i64)
+//   SORT_TYPE        element type
+//   SORT_LESS(a, b)  strict weak order on two 'const SORT_TYPE*' (inlined, no function pointer)
+//   SORT_SCOPE       optional, e.g. 'static' for sorts private to one file
+// Generates:
+//   void SORT_NAME##_intro_sort(SORT_TYPE* tab, int size, Stats_t* stats);
+//   int  SORT_NAME##_merge_sort(SORT_TYPE* tab, int size, Stats_t* stats, Arena* arena);
+//        stable, buffer from 'arena' (NULL: the heap), -1 if out of memory
+// Same algorithms as introsort.c (median of 3 / ninther, Hoare partition,
+// heap sort fallback, insertion sort leaves) and a top-down merge sort with
+// insertion sort runs. An element move counts as one memory access whatever
+// its size. The macros are undefined at the end.
+// Needs instrument.h, arena.h and <string.h>.
+
+#if !defined(SORT_NAME) || !defined(SORT_TYPE) || !defined(SORT_LESS)
+#error "define SORT_NAME, SORT_TYPE and SORT_LESS before including sort_template.h"
+#endif
+
+#ifndef SORT_SCOPE
+#define SORT_SCOPE
+#endif
+
+#define SORT_CONCAT_(a, b) a##_##b
+#define SORT_CONCAT(a, b) SORT_CONCAT_(a, b)
+#define SORT_FN(suffix) SORT_CONCAT(SORT_NAME, suffix)
+
+#define SORT_INSERTION_CUTOFF 16
+#define SORT_NINTHER_CUTOFF 128
+#define SORT_STACK_SIZE 64
+
+KERNEL_INLINE int SORT_FN(less)(const SORT_TYPE* a, const SORT_TYPE* b, Counters* counters) {
+    counters->comparisons++;
+    counters->memoryAccesses += 2;
+    return SORT_LESS(a, b);
+}
+
+KERNEL_INLINE void SORT_FN(swap)(SORT_TYPE* a, SORT_TYPE* b, Counters* counters) {
+    counters->memoryAccesses += 4; // 2 reads + 2 writes
+    SORT_TYPE tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+// Sorts tab[low..high] by insertion (small ranges)
+static void SORT_FN(insertion_range)(SORT_TYPE* tab, int low, int high, Counters* counters) {
+    for (int i = low + 1; i <= high; i++) {
+        SORT_TYPE key = tab[i];
+        int j = i - 1;
+        counters->memoryAccesses += 2; // read key, write it back
+        while (j >= low && SORT_FN(less)(&key, &tab[j], counters)) {
+            counters->memoryAccesses++; // the move (the read was counted by less)
+            tab[j + 1] = tab[j];
+            j--;
+        }
+        tab[j + 1] = key;
+    }
+}
+
+/*
+----------------------------------------------------
+ INTROSORT
+----------------------------------------------------
+*/
+KERNEL_INLINE void SORT_FN(sort3)(SORT_TYPE* tab, int a, int b, int c, Counters* counters) {
+    if (SORT_FN(less)(&tab[b], &tab[a], counters)) SORT_FN(swap)(&tab[a], &tab[b], counters);
+    if (SORT_FN(less)(&tab[c], &tab[b], counters)) SORT_FN(swap)(&tab[b], &tab[c], counters);
+    if (SORT_FN(less)(&tab[b], &tab[a], counters)) SORT_FN(swap)(&tab[a], &tab[b], counters);
+}
+
+// Pivot (median of 3, or ninther) to tab[low], then Hoare partition around it
+static int SORT_FN(partition)(SORT_TYPE* tab, int low, int high, Counters* counters) {
+    int length = high - low + 1;
+    int mid = low + length / 2;
+    if (length > SORT_NINTHER_CUTOFF) {
+        int step = length / 8;
+        SORT_FN(sort3)(tab, low, low + step, low + 2 * step, counters);
+        SORT_FN(sort3)(tab, mid - step, mid, mid + step, counters);
+        SORT_FN(sort3)(tab, high - 2 * step, high - step, high, counters);
+        SORT_FN(sort3)(tab, low + step, mid, high - step, counters);
+    } else {
+        SORT_FN(sort3)(tab, low, mid, high, counters);
+    }
+    SORT_FN(swap)(&tab[low], &tab[mid], counters);
+
+    SORT_TYPE pivot = tab[low];
+    counters->memoryAccesses++; // read pivot
+    int i = low - 1;
+    int j = high + 1;
+    while (1) {
+        do { i++; } while (SORT_FN(less)(&tab[i], &pivot, counters));
+        do { j--; } while (SORT_FN(less)(&pivot, &tab[j], counters));
+        if (i >= j) return j;
+        SORT_FN(swap)(&tab[i], &tab[j], counters);
+    }
+}
+
+static void SORT_FN(sift_down)(SORT_TYPE* tab, int root, int count, Counters* counters) {
+    while (1) {
+        int child = 2 * root + 1;
+        if (child >= count) return;
+        if (child + 1 < count && SORT_FN(less)(&tab[child], &tab[child + 1], counters)) child++;
+        if (!SORT_FN(less)(&tab[root], &tab[child], counters)) return;
+        SORT_FN(swap)(&tab[root], &tab[child], counters);
+        root = child;
+    }
+}
+
+static void SORT_FN(heap_sort)(SORT_TYPE* tab, int count, Counters* counters) {
+    for (int root = count / 2 - 1; root >= 0; root--) SORT_FN(sift_down)(tab, root, count, counters);
+    for (int end = count - 1; end > 0; end--) {
+        SORT_FN(swap)(&tab[0], &tab[end], counters);
+        SORT_FN(sift_down)(tab, 0, end, counters);
+    }
+}
+
+SORT_SCOPE void SORT_FN(intro_sort)(SORT_TYPE* tab, int size, Stats_t* stats) {
+    Counters counters = { 0, 0 };
+    struct { int low, high, depth; } stack[SORT_STACK_SIZE];
+    int top = 0;
+
+    int depthLimit = 0;
+    for (int n = size; n > 1; n >>= 1) depthLimit += 2;
+
+    int low = 0, high = size - 1, depth = depthLimit;
+    while (1) {
+        while (high - low + 1 > SORT_INSERTION_CUTOFF) {
+            if (depth == 0) {
+                SORT_FN(heap_sort)(tab + low, high - low + 1, &counters);
+                low = high;
+                break;
+            }
+            depth--;
+            int split = SORT_FN(partition)(tab, low, high, &counters);
+            flushCounters(&counters, stats, 1);
+
+            // smaller side now, larger side on the stack
+            if (split - low < high - split) {
+                stack[top].low = split + 1; stack[top].high = high; stack[top].depth = depth;
+                high = split;
+            } else {
+                stack[top].low = low; stack[top].high = split; stack[top].depth = depth;
+                low = split + 1;
+            }
+            top++;
+        }
+        if (low < high) SORT_FN(insertion_range)(tab, low, high, &counters);
+        flushCounters(&counters, stats, 1);
+
+        if (top == 0) break;
+        top--;
+        low = stack[top].low;
+        high = stack[top].high;
+        depth = stack[top].depth;
+    }
+}
+
+/*
+----------------------------------------------------
+ MERGE SORT (stable)
+----------------------------------------------------
+ Sorts tab[low..high] using buffer[low..high]; equal elements keep their
+ order (the left run wins ties), which records sorted by key rely on.
+----------------------------------------------------
+*/
+static void SORT_FN(merge_range)(SORT_TYPE* tab, SORT_TYPE* buffer, int low, int high, Counters* counters) {
+    if (high - low + 1 <= SORT_INSERTION_CUTOFF) {
+        SORT_FN(insertion_range)(tab, low, high, counters);
+        return;
+    }
+    int mid = low + (high - low) / 2;
+    SORT_FN(merge_range)(tab, buffer, low, mid, counters);
+    SORT_FN(merge_range)(tab, buffer, mid + 1, high, counters);
+    if (!SORT_FN(less)(&tab[mid + 1], &tab[mid], counters)) return; // already in order
+
+    int count = high - low + 1;
+    memcpy(buffer + low, tab + low, (size_t)count * sizeof(SORT_TYPE));
+    counters->memoryAccesses += 2LL * count;
+    int i = low, j = mid + 1, k = low;
+    while (i <= mid && j <= high) {
+        if (SORT_FN(less)(&buffer[j], &buffer[i], counters)) tab[k++] = buffer[j++];
+        else tab[k++] = buffer[i++];
+        counters->memoryAccesses++;
+    }
+    while (i <= mid) {
+        tab[k++] = buffer[i++];
+        counters->memoryAccesses += 2;
+    }
+    // what is left of the right run is already in place
+}
+
+SORT_SCOPE int SORT_FN(merge_sort)(SORT_TYPE* tab, int size, Stats_t* stats, Arena* arena) {
+    if (size < 2) return 0;
+    size_t bytes = (size_t)size * sizeof(SORT_TYPE);
+    SORT_TYPE* buffer = (SORT_TYPE*)arenaAlloc(arena, bytes, stats);
+    if (buffer == NULL) return -1;
+    Counters counters = { 0, 0 };
+    SORT_FN(merge_range)(tab, buffer, 0, size - 1, &counters);
+    flushCounters(&counters, stats, 1);
+    arenaFree(arena, buffer, bytes, stats);
+    return 0;
+}
+
+#undef SORT_FN
+#undef SORT_CONCAT
+#undef SORT_CONCAT_
+#undef SORT_INSERTION_CUTOFF
+#undef SORT_NINTHER_CUTOFF
+#undef SORT_STACK_SIZE
+#undef SORT_NAME
+#undef SORT_TYPE
+#undef SORT_LESS
+#undef SORT_SCOPE
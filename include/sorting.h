@@ -1,19 +1,70 @@
 #ifndef SORTING_H
 #define SORTING_H
 
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_ttf.h>
-#include "main.h"
+#include "stats.h"
+#include "trace.h"
 
+// Resumable sorts for the window.
+// Each algorithm is a state machine: one call to stepSort() performs at most
+// 'budget' operations (compare/swap/write), writes them to the machine's
+// output batch and returns, so the caller decides how much work is done at
+// a time and pause/resume is just "stop calling stepSort".
+// Kept SDL-free (run by the sort worker thread).
+
+// Range still to be sorted (explicit stack of the quick sort)
+typedef struct {
+    int low;
+    int high;
+} SortRange;
+
+typedef struct {
+    int algorithm; // 1: bubble, 2: selection, 3: insertion, 4: quick, 0: idle
+    int done;      // 1 once the array is sorted
+
+    // private copy being sorted (the window shows the replayed trace)
+    int* tab;
+    int size;
+    Stats_t* stats;
+
+    // ops recorded by the last stepSort() call
+    TraceOp* out;
+    size_t outCount;
+    size_t outCapacity;
+
+    // loop state, meaning depends on the algorithm
+    int phase;
+    int i, j;
+    int minimum;  // selection sort
+    int key;      // insertion sort
+    int swapped;  // bubble sort
+
+    // quick sort: current partition + ranges left to do
+    int low, high, pivot;
+    SortRange* stack;
+    int stackTop;
+    int stackCapacity;
+} SortMachine;
+
+//batchCapacity = most ops a single stepSort() call can record
+//return a pointer to an idle machine, or NULL on failure.
 //implemented in sorting.c
-void bubble_sort(App_Window* app); 
+SortMachine* createSortMachine(size_t batchCapacity);
 
+//Starts 'algorithm' on a copy of 'array'.
+//return 0 on success, -1 if memory ran out.
 //implemented in sorting.c
-void selection_sort(App_Window* app); 
+int startSort(SortMachine* machine, int algorithm, const int* array, int size, Stats_t* stats);
 
+//Runs up to 'budget' operations (at most batchCapacity); they are in out[0 .. outCount).
+//return 1 when the sort is finished.
 //implemented in sorting.c
-void insertion_sort(App_Window* app); 
+int stepSort(SortMachine* machine, long long budget);
 
+//Back to idle (drops the copy), keeps the buffers for the next sort.
 //implemented in sorting.c
-void quick_sort(App_Window* app);
-#endif 
\ No newline at end of file
+void stopSort(SortMachine* machine);
+
+//implemented in sorting.c
+void freeSortMachine(SortMachine* machine);
+
+#endif 
@@ -1,14 +1,31 @@
 #ifndef STATS_H
 #define STATS_H
 
-#include <SDL2/SDL_stdinc.h> // for Uint64
+#include <stdint.h> // for uint64_t (kept SDL-free for the bench binary)
+
+// Hardware counters (perf.c), only filled where the CPU and the kernel allow it
+#define HW_CYCLES        0
+#define HW_INSTRUCTIONS  1
+#define HW_BRANCH_MISSES 2
+#define HW_L1D_MISSES    3 // L1 data cache read misses
+#define HW_LLC_MISSES    4 // last level cache misses
+#define HW_DTLB_MISSES   5 // data TLB read misses
+#define HW_COUNTER_COUNT 6
 
 //Structure to hold all performance stats
 typedef struct {
     double executionTime;
     long long comparisons;
     long long memoryAccesses;
-    Uint64 startTicks;
+    uint64_t startTicks;
+    long long hardware[HW_COUNTER_COUNT];
+    unsigned int hardwareValid; // bit i set when hardware[i] was measured
+    long long auxBytes;         // scratch memory in use (arena.c)
+    long long auxPeakBytes;     // most scratch memory in use at once
+    long long auxAllocations;   // scratch buffers taken
+    long long naturalRuns;      // runs found in the input (adaptive.h)
+    long long gallopHits;       // galloping searches that moved a block (TimSort)
+    long long charComparisons;  // characters examined by the string sorts (strsort.h)
 } Stats_t;
 
 
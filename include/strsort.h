@@ -0,0 +1,82 @@
+#ifndef STRSORT_H
+#define STRSORT_H
+
+#include "arena.h"
+#include "stats.h"
+#include "trace.h"
+
+// Sorts of variable-length string keys (NUL-terminated bytes, strcmp order).
+// The keys are an array of pointers; 'values' (may be NULL) is an int
+// array moved along with them, which is how the window shows a string
+// sort: every int is drawn as its bar and sorted as its key.
+//  - string_multikey_sort: three-way radix quicksort (Bentley-Sedgewick).
+//    Partitions on one character against the pivot's into <, = and >;
+//    only the = part moves on to the next character, so a shared prefix
+//    is read once per partition level instead of once per comparison.
+//  - string_msd_radix_sort: MSD radix sort, one 256-way bucketing per
+//    character position; each key's character is read once into a byte
+//    buffer, then the keys are moved through a buffer of pointers.
+//    Buckets of STRING_MSD_CUTOFF keys or less finish by insertion sort.
+//    A level where every key has the same character moves nothing.
+//  - string_intro_sort: the comparison baseline, intro sort with a full
+//    strcmp per comparison (the shared prefix is read every time).
+// stats->charComparisons counts the characters examined: one per character
+// pair a strcmp looks at, one per character compared with the pivot
+// (multikey), one per character put in a bucket (MSD). Moving a key (and
+// its value) is one memory access each.
+// The equal-prefix ranges the radix sorts find are marked with an owner
+// color picked by their character (TRACE_OWNER), so the window colors the
+// bars by prefix as it is discovered. 'sink' needs 'values' (the writes
+// carry them).
+// Kept SDL-free.
+
+#define STRING_MULTIKEY_CUTOFF 10 // multikey: ranges this short finish by insertion sort
+#define STRING_MSD_CUTOFF 32      // MSD: buckets this small finish by insertion sort
+#define STRING_PREFIX_COLORS 12   // owner colors 0 .. 11 (12 is the selections' grey)
+
+// Key shapes of the generator: keys sort exactly like their int value
+// (value >= 0), so any input of dataset.h gives the same order as strings.
+#define STRING_PATHS 0 // "/usr/lib/share/core.h": 1 to 7 directory levels (5 bits of the value each), variable length
+#define STRING_IDS   1 // "customer-0042/invoice-000a3f9": 22 shared bytes, then fixed-width base 36
+#define STRING_SHAPE_COUNT 2
+#define STRING_KEY_MAX 80 // longest key, NUL included
+
+//Picks the shape of the keys sorted by the window and the bench: "paths" or "ids".
+//return 0, or -1 if the name is unknown.
+//implemented in strsort.c
+int setStringShape(const char* name);
+
+//Current shape (STRING_PATHS ..) and its name.
+//implemented in strsort.c
+int stringShape(void);
+const char* stringShapeName(int shape);
+
+//Writes the key of 'value' in 'shape' to 'out' (STRING_KEY_MAX bytes).
+//return its length.
+//implemented in strsort.c
+int formatStringKey(int value, int shape, char* out);
+
+//Keys of values[0 .. size), pointer array and characters both taken from
+//'arena' (NULL: one heap block each) and not counted as scratch memory.
+//return NULL if memory ran out.
+//implemented in strsort.c
+const char** createStringKeys(const int* values, int size, int shape, Arena* arena);
+
+//implemented in strsort.c
+void string_multikey_sort(const char** keys, int* values, int size, Stats_t* stats, OpSink* sink);
+
+//Buffers (size pointers, size bytes, size ints with values) from 'arena'.
+//return 0, or -1 if they could not be allocated.
+//implemented in strsort.c
+int string_msd_radix_sort(const char** keys, int* values, int size, Stats_t* stats, Arena* arena, OpSink* sink);
+
+//implemented in strsort.c
+void string_intro_sort(const char** keys, int* values, int size, Stats_t* stats, OpSink* sink);
+
+//Same sorts with the counting and the trace compiled out (instrument.h).
+//implemented in strsort.c
+void string_multikey_sort_raw(const char** keys, int* values, int size);
+int string_msd_radix_sort_raw(const char** keys, int* values, int size, Arena* arena);
+void string_intro_sort_raw(const char** keys, int* values, int size);
+
+#endif
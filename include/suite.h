@@ -0,0 +1,63 @@
+#ifndef SUITE_H
+#define SUITE_H
+
+// Statistics of the repeated bench runs and comparison with a baseline.
+//  - every point (algorithm, distribution, threads, n) is timed several
+//    times and summarized by its median, MAD (median absolute deviation,
+//    robust to the odd preempted run), 99th percentile and minimum
+//  - the growth of the median with n gives the complexity exponent
+//    (slope of log(time) over log(n): ~1 for n log n sorts, ~2 for O(n^2))
+//  - a baseline is the JSON output of an earlier bench run; a point is a
+//    regression when its median is slower by more than the tolerance AND
+//    by more than the noise (3 MADs, scaled to a standard deviation)
+// Kept SDL-free (used by the bench binary).
+
+typedef struct {
+    double median;
+    double mad;
+    double p99;
+    double min;
+    int reps;
+} TimingSummary;
+
+typedef struct {
+    char algorithm[32];
+    char distribution[32];
+    int threads;
+    long long n;
+    double median;
+    double mad;
+    unsigned long long seed; // of the inputs (0: not recorded)
+} BaselineEntry;
+
+typedef struct {
+    BaselineEntry* entries;
+    int count;
+} Baseline;
+
+//Summary of 'count' timings (the array is sorted in place).
+//implemented in suite.c
+void summarizeTimings(double* seconds, int count, TimingSummary* summary);
+
+//Least squares slope of log(seconds) over log(n); 0 with fewer than 2 points.
+//implemented in suite.c
+double fitExponent(const double* n, const double* seconds, int count);
+
+//Reads the points of a bench JSON file (one object per line, as printed).
+//return NULL if the file cannot be read or has no point (message on stderr).
+//implemented in suite.c
+Baseline* loadBaseline(const char* path);
+
+//return the matching point, or NULL.
+//implemented in suite.c
+const BaselineEntry* findBaseline(const Baseline* baseline, const char* algorithm, const char* distribution,
+                                  int threads, long long n);
+
+//1 if 'now' is significantly slower than 'base' (tolerance: fraction, e.g. 0.05).
+//implemented in suite.c
+int isRegression(const TimingSummary* now, const BaselineEntry* base, double tolerance);
+
+//implemented in suite.c
+void freeBaseline(Baseline* baseline);
+
+#endif
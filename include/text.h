@@ -0,0 +1,61 @@
+#ifndef TEXT_H
+#define TEXT_H
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+// Text drawing without per-frame TTF rasterization.
+// Printable ASCII glyphs are rendered once into one atlas texture, and each
+// string is drawn as a single batch of textured quads (SDL_RenderGeometry).
+// Static lines (menu, legend) are rendered once and kept as whole textures.
+
+#define ATLAS_FIRST_CHAR 32  // ' '
+#define ATLAS_LAST_CHAR  126 // '~'
+#define ATLAS_GLYPHS (ATLAS_LAST_CHAR - ATLAS_FIRST_CHAR + 1)
+#define STATIC_TEXT_CACHE 32 // max cached static lines
+
+// Position of one glyph inside the atlas
+typedef struct {
+    SDL_Rect rect; // source rect in the atlas
+    int advance;   // pen advance in pixels
+} Glyph;
+
+// A static line rendered once
+typedef struct {
+    const char* text;
+    SDL_Color color;
+    SDL_Texture* texture;
+    int w, h;
+} StaticText;
+
+typedef struct {
+    TTF_Font* font;        // borrowed, used for the static lines
+    SDL_Texture* texture;  // white glyphs, tinted per string
+    int width, height;     // atlas size
+    int lineHeight;
+    Glyph glyphs[ATLAS_GLYPHS];
+
+    StaticText cache[STATIC_TEXT_CACHE];
+    int cacheCount;
+} GlyphAtlas;
+
+//Builds the atlas for 'font' (call once at startup).
+//return NULL on failure.
+//implemented in text.c
+GlyphAtlas* createGlyphAtlas(SDL_Renderer* renderer, TTF_Font* font);
+
+//Frees the atlas texture and every cached static line.
+//implemented in text.c
+void freeGlyphAtlas(GlyphAtlas* atlas);
+
+//Draws dynamic text (numbers, counters) from the atlas in one batched call.
+//return the drawn width in pixels.
+//implemented in text.c
+int drawAtlasText(SDL_Renderer* renderer, GlyphAtlas* atlas, const char* text, int x, int y, SDL_Color color);
+
+//Draws a line that never changes; it is rendered on first use and then reused.
+//'text' must be a string literal (or outlive the atlas).
+//Fills w/h with the drawn size when not NULL.
+//implemented in text.c
+void drawStaticText(SDL_Renderer* renderer, GlyphAtlas* atlas, const char* text, int x, int y, SDL_Color color, int* w, int* h);
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Compact record of every compare/swap/write/read done by a sort.
+// The window replays it at any speed and can seek backward and forward.
+// Kept SDL-free.
+
+// Operation types (stored in the top bits of TraceOp::head)
+#define TRACE_COMPARE 0 // compare tab[a] and tab[b]
+#define TRACE_SWAP    1 // swap tab[a] and tab[b]
+#define TRACE_WRITE   2 // tab[a] = b
+#define TRACE_OWNER   3 // worker (top bits of arg) now owns tab[a .. low bits of arg]
+#define TRACE_READ    4 // read tab[a] alone (against a key held aside), nothing changes
+
+#define TRACE_TYPE_SHIFT 28
+#define TRACE_INDEX_MASK ((1u << TRACE_TYPE_SHIFT) - 1) // indices up to 2^28 - 1
+#define TRACE_OWNER_COLORS 16 // worker ids kept by TRACE_OWNER (id % 16)
+
+// One operation, 8 bytes: type + first index packed in head, second index or value in arg.
+typedef struct {
+    uint32_t head;
+    uint32_t arg;
+} TraceOp;
+
+// Packs one op (used by the sorts that produce the stream)
+static inline TraceOp makeTraceOp(uint32_t type, int a, int arg) {
+    TraceOp op;
+    op.head = (type << TRACE_TYPE_SHIFT) | ((uint32_t)a & TRACE_INDEX_MASK);
+    op.arg = (uint32_t)arg;
+    return op;
+}
+
+// TRACE_OWNER: 'worker' now works on [low..high]
+static inline TraceOp makeOwnerOp(int low, int high, int worker) {
+    return makeTraceOp(TRACE_OWNER, low,
+                       (int)(((uint32_t)(worker % TRACE_OWNER_COLORS) << TRACE_TYPE_SHIFT) | ((uint32_t)high & TRACE_INDEX_MASK)));
+}
+
+// Where a sort sends its ops when it is not a SortMachine (parallel sorts).
+// push() may be called from several threads and must serialize itself.
+typedef struct {
+    void (*push)(void* context, TraceOp op);
+    void* context;
+} OpSink;
+
+// Operation stream plus periodic copies of the array (keyframes).
+// Keyframe k is the array state after ops[0 .. k * keyframeInterval).
+typedef struct {
+    TraceOp* ops;
+    size_t count;
+    size_t capacity;
+
+    int size;                // length of the recorded array
+    size_t keyframeInterval; // ops between two keyframes
+    int* keyframes;          // keyframeCount * size ints
+    size_t keyframeCount;
+    size_t keyframeCapacity;
+
+    int* shadow; // array state after the last recorded op (source of the keyframes)
+    int failed;  // 1 if an allocation failed (the trace is truncated)
+
+    // worker owning each element (0 = none, else id + 1), only for parallel sorts
+    int hasOwners;
+    unsigned char* ownerShadow;
+    unsigned char* ownerKeyframes; // keyframeCapacity * size
+
+} Trace;
+
+// return a pointer to an empty trace, or NULL on failure.
+// Implemented in trace.c
+Trace* createTrace(void);
+
+// Empties the trace and starts recording the sort of 'array' (copied).
+// Implemented in trace.c
+void resetTrace(Trace* trace, const int* array, int size);
+
+// Frees the trace and all its buffers.
+// Implemented in trace.c
+void freeTrace(Trace* trace);
+
+// Appends ops produced by the sort, in order.
+// Implemented in trace.c
+void traceAppend(Trace* trace, const TraceOp* ops, size_t count);
+
+// Replays ops [from, to) onto 'array' (which must hold the state at 'from').
+// 'owners' (size elements, may be NULL) receives the TRACE_OWNER ranges.
+// highlight1/highlight2 receive the indices touched by the last op (-1 if none).
+// Implemented in trace.c
+void traceApply(const Trace* trace, size_t from, size_t to, int* array, unsigned char* owners,
+                int* highlight1, int* highlight2);
+
+// Rebuilds the array (and owners, if not NULL) at 'position' from the nearest keyframe.
+// Cost is one keyframe copy plus at most keyframeInterval ops.
+// Implemented in trace.c
+void traceSeek(const Trace* trace, size_t position, int* array, unsigned char* owners,
+               int* highlight1, int* highlight2);
+
+#endif // TRACE_H
@@ -0,0 +1,53 @@
+#ifndef TYPED_H
+#define TYPED_H
+
+#include <math.h>   // For isnan
+#include <stdint.h>
+#include "arena.h"
+#include "stats.h"
+
+// The comparison sorts on other element types than int.
+// Each one is generated from sort_template.h with its comparison inlined
+// (no qsort-style function pointer): intro sort and a stable merge sort for
+//  - i64    : 64-bit signed keys
+//  - double : total order, NaN after every number (NaNs equal to each other)
+//  - record : 64-byte records ordered by their 16-byte key (high, then low)
+// plus a key-index sort for the records: only (key, index) tags are sorted,
+// then each record is moved once to its place, to compare against moving
+// whole records on every swap.
+// Buffers come from 'arena' (NULL: the heap); merge sorts return 0, or -1
+// if the buffer could not be allocated.
+// Kept SDL-free.
+
+// Order of the double sorts: NaN after every number (the bench checks with it too)
+static inline int f64Less(double a, double b) {
+    return !isnan(a) && (isnan(b) || a < b);
+}
+
+#define RECORD_PAYLOAD 48 // bytes of payload after the key (64-byte records)
+
+typedef struct {
+    uint64_t keyHigh;
+    uint64_t keyLow;
+    unsigned char payload[RECORD_PAYLOAD];
+} Record;
+
+//implemented in typed.c
+void i64_intro_sort(int64_t* tab, int size, Stats_t* stats);
+int i64_merge_sort(int64_t* tab, int size, Stats_t* stats, Arena* arena);
+
+//implemented in typed.c
+void f64_intro_sort(double* tab, int size, Stats_t* stats);
+int f64_merge_sort(double* tab, int size, Stats_t* stats, Arena* arena);
+
+//implemented in typed.c
+void record_intro_sort(Record* tab, int size, Stats_t* stats);
+int record_merge_sort(Record* tab, int size, Stats_t* stats, Arena* arena);
+
+//Key-index sort: tags sorted by intro sort, then one gather of the records.
+//Not stable (like record_intro_sort).
+//return 0, or -1 if memory ran out.
+//implemented in typed.c
+int record_tag_sort(Record* tab, int size, Stats_t* stats, Arena* arena);
+
+#endif
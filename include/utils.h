@@ -1,19 +1,34 @@
 #ifndef UTILS_H
 #define UTILS_H
 #include "main.h"
+#include "dataset.h" // For createDataset
+#include "recorder.h" // For FrameWriter
 
 //Runs the main application loop.
 //This function only returns when the user quits.
 //implemented in utils.c
 void runMainLoop(App_Window* app);
 
+//Largest value of the array (app->maxValue, or the size when it is 0).
+//implemented in utils.c
+int arrayMaxValue(const App_Window* app);
+
+//(Re)creates app->array (app->size elements of the current shape and seed)
+//and an empty owner array; frees the previous ones.
+//return 0, or -1 if memory ran out.
+//implemented in utils.c
+int createAppArray(App_Window* app);
+
+//Headless run: sorts with 'algorithm' (a registry id, 1 to ALGO_MAX) and
+//writes one frame per app->replaySpeed ops until the sort is over, then
+//'holdFrames' more of the sorted array. The app must have been created with AppConfig.headless.
+//return 0, or -1 if the sort could not start or a write failed.
+//implemented in utils.c
+int runRecording(App_Window* app, int algorithm, FrameWriter* writer, int holdFrames);
+
 //SDL Events
 //returns an action code
 //implemented in utils.c
 int handleEvents(int* running);
 
-//random number
-//implemented in utils.c   
-int* createRandomArray(int size, int maxValue);
-
 #endif
\ No newline at end of file
@@ -4,31 +4,74 @@
 #include <SDL2/SDL_ttf.h>
 #include "main.h"
 #include "stats.h"
+#include "trace.h"
+#include "text.h"
 
 //Initializes all SDL/TTF systems and creates the app struct.
+// 'config' gives the window size, N and the value range.
 // return a pointer to the newly created App_window, or NULL on failure.
 //implemented in visual.c
-App_Window* initAppVisuals(); // Renamed to be specific to 'visual'
+App_Window* initAppVisuals(const AppConfig* config); // Renamed to be specific to 'visual'
 
 // Cleans up all resources (memory, SDL, TTF).
 //param app A pointer to the App_Window struct to be freed.
 //implemented in visual.c
 void cleanupAppVisuals(App_Window* app);
 
-//Render sorting bars
+//Render sorting bars in the zoneWidth x zoneHeight zone at the top left, colored
+//by worker when 'owners' is not NULL; 'maxValue' is drawn at the full height
+//one batched call per color when the array fits the sort zone, per-pixel-column min/max otherwise
 //implemented in visual.c
-void drawArray(SDL_Renderer* renderer, int* array, int size, int highlight1, int highlight2);
+void drawArray(SDL_Renderer* renderer, BarCache* bars, int* array, const unsigned char* owners, int size,
+               int maxValue, int zoneWidth, int zoneHeight, int highlight1, int highlight2);
+
+//Bar cache lifetime
+//implemented in visual.c
+BarCache* createBarCache();
+void freeBarCache(BarCache* bars);
+
+//Tell the bar cache which elements changed since the last frame
+//(only used by the per-column path, where clean columns are not rescanned)
+//implemented in visual.c
+void markAllBarsDirty(BarCache* bars);
+void markBarsDirty(BarCache* bars, int index, int size);
+void markTraceDirty(BarCache* bars, const Trace* trace, size_t from, size_t to, int size);
 
 //Render top-left stats box
 //implemented in visual.c
-void drawStats(SDL_Renderer* renderer, TTF_Font* font, Stats_t* stats);
+void drawStats(SDL_Renderer* renderer, GlyphAtlas* atlas, Stats_t* stats);
+
+//Render the string keys (strsort.h) of the highlighted bars, in a box
+//whose bottom is at y = 'bottom' (string sorts: the bars are the values)
+//implemented in visual.c
+void drawStringKeys(SDL_Renderer* renderer, GlyphAtlas* atlas, const int* array, int size,
+                    int highlight1, int highlight2, int bottom);
+
+//Render replay position (step counter + progress bar)
+//implemented in visual.c
+void drawTimeline(SDL_Renderer* renderer, GlyphAtlas* atlas, const Trace* trace, size_t cursor, int speed);
+
+//Render the lanes of a race side by side in the zoneWidth x zoneHeight zone,
+//each with its name, finish place and throughput ('input' until it starts)
+//implemented in visual.c
+void drawRace(SDL_Renderer* renderer, GlyphAtlas* atlas, const Race* race, int* input, int inputSize,
+              int maxValue, int zoneWidth, int zoneHeight);
+
+//Render the access heatmap of 'map' (created in *texture on first use) with
+//the replay position 'cursor', and its stride and reuse histograms, in 'area'
+//implemented in visual.c
+void drawAccessMap(SDL_Renderer* renderer, GlyphAtlas* atlas, const AccessMap* map, SDL_Texture** texture,
+                   size_t cursor, SDL_Rect area);
 
-//Render entire screen (bars, legend, stats)
+//Render entire screen (bars, legend, stats; the lanes in race mode)
 //implemented in visual.c
 void renderApp(App_Window* app, int highlight1, int hightlight2);
 
-//Render right-hand menu
+//Render right-hand menu (with the current input shape and size), along the right edge
+//'race' is NULL outside race mode, else its lanes are the selected entries
+//'k' is the rank the selections use
 //implemented in visual.c
-void drawLegend(SDL_Renderer* renderer, TTF_Font* font, int selectedAlgorithm);
+void drawLegend(SDL_Renderer* renderer, GlyphAtlas* atlas, int selectedAlgorithm, const Race* race,
+                int distribution, int size, int k, int windowWidth, int windowHeight);
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,110 @@
+#ifndef WORKER_H
+#define WORKER_H
+
+#include <SDL2/SDL.h>
+#include <stdatomic.h>
+#include "sorting.h"
+#include "ring.h"
+#include "stats.h"
+#include "pool.h"
+#include "perf.h"
+#include "arena.h"
+
+// Runs the selected sort on its own thread.
+// The worker steps the SortMachine at full speed and pushes every op into an
+// SPSC ring; the window thread drains the ring at its own pace. Pause and
+// stop are atomic flags, so the sort never waits on the display (only on a
+// full ring when it is far ahead of the replay).
+// 'algorithm' is a registry id (registry.h). The ones without a state machine
+// are direct sorts: one call of their entry point, with the worker's thread
+// pool and the app's arena. Each pool worker collects its ops in its own
+// buffer, moved into the ring under a mutex when full and at every fork/join
+// point of the pool (so the ring keeps the order the replay needs).
+// The hardware counters (perf.h) are only enabled while the sort itself runs.
+// The copy sorted by the direct sorts and their scratch buffers come from the
+// app's arena, reset when a run starts: repeating a run allocates nothing.
+
+#define DIRECT_OP_BATCH 256 // ops a pool worker buffers before taking the ring's lock
+
+// Ops of one pool worker not yet in the ring
+typedef struct {
+    TraceOp ops[DIRECT_OP_BATCH];
+    int count;
+} DirectOpBuffer;
+
+typedef struct {
+    SDL_Thread* thread; // NULL when no sort is running
+    int algorithm;
+    int selectK; // rank of the selections
+    SortMachine* machine;
+    OpRing* ring;
+
+    // direct sorts
+    ThreadPool* pool;
+    int poolThreads;  // workers asked for (setSortWorkerThreads)
+    int* directTab;   // copy being sorted (in the arena)
+    Arena* arena;     // app's scratch memory, owned by the worker thread during a run
+    int directSize;
+    DirectOpBuffer* directOps; // one per pool worker
+    SDL_mutex* sinkLock; // one pool worker at a time in the ring
+    int waiters;         // pool workers waiting on a full ring or on pause (under sinkLock)
+    Uint64 waitStart;    // when the first of them started waiting
+    long long blockedNs; // time with at least one of them waiting (under sinkLock)
+    Uint64 directStart;  // when the direct sort started
+    long long tracedComparisons; // counted from the flushed ops, while the sort's own
+    long long tracedAccesses;    // counters are not known yet (under sinkLock)
+    Stats_t local; // counters of the current run (worker thread only)
+    Stats_t base;  // window stats when the run started
+    PerfCounters perf; // hardware counters of the run (worker thread only)
+
+    atomic_int paused;
+    atomic_int stop;
+    atomic_int finished; // sort done and every op pushed
+
+    // counters published for the window thread
+    atomic_llong comparisons;
+    atomic_llong memoryAccesses;
+    atomic_llong elapsedNs; // time spent sorting (not waiting)
+    atomic_llong hardware[HW_COUNTER_COUNT];
+    atomic_uint hardwareValid;
+    atomic_llong auxPeakBytes;
+    atomic_llong auxAllocations;
+    atomic_llong naturalRuns;
+    atomic_llong gallopHits;
+    atomic_llong charComparisons;
+} SortWorker;
+
+//return a pointer to an idle worker, or NULL on failure.
+//implemented in worker.c
+SortWorker* createSortWorker(size_t ringCapacity);
+
+//Starts 'algorithm' on a copy of 'array'. 'stats' is the starting point of the counters.
+//'k' is the rank of the selections (13 to 15), ignored by the sorts.
+//'arena' is reset and used by the run until the next start or stop.
+//return 0 on success, -1 on failure.
+//implemented in worker.c
+int startSortWorker(SortWorker* worker, int algorithm, const int* array, int size, int k, const Stats_t* stats,
+                    Arena* arena);
+
+//Stops the worker and gives its pool 'threads' workers (<= 0: one per core),
+//so that several workers running at once share the cores instead of each
+//starting one thread per core.
+//return 0, or -1 if the new pool could not be created (the old one stays).
+//implemented in worker.c
+int setSortWorkerThreads(SortWorker* worker, int threads);
+
+//implemented in worker.c
+void pauseSortWorker(SortWorker* worker, int paused);
+
+//Stops the thread (waits for it) and drops the ops still queued.
+//implemented in worker.c
+void stopSortWorker(SortWorker* worker);
+
+//Copies the live counters of the run into 'stats'.
+//implemented in worker.c
+void readSortWorkerStats(SortWorker* worker, Stats_t* stats);
+
+//implemented in worker.c
+void freeSortWorker(SortWorker* worker);
+
+#endif
@@ -0,0 +1,101 @@
+#include "registry.h"
+#include <stddef.h> // For NULL
+
+/*
+----------------------------------------------------
+ EXAMPLE PLUGIN: SHELL SORT
+----------------------------------------------------
+ Built apart from the program and the bench, and loaded by them at
+ startup (--plugin):
+
+   gcc -O2 -shared -fPIC -Iinclude plugins/shell_sort.c -o shell_sort.so
+   ./program --plugin ./shell_sort.so            (menu key G)
+   ./bench --plugin ./shell_sort.so --algo shell
+
+ Only the headers are used: the plugin counts into Stats_t and packs its
+ ops with makeTraceOp() itself, so it links against nothing.
+ Gapped insertion sort over Ciura's gaps (extended by x2.25).
+----------------------------------------------------
+*/
+
+static const int ciuraGaps[] = { 1, 4, 10, 23, 57, 132, 301, 701, 1750 };
+#define CIURA_COUNT ((int)(sizeof(ciuraGaps) / sizeof(ciuraGaps[0])))
+#define MAX_GAPS 48
+
+// Gaps below size / 2, smallest first; return how many
+static int shellGaps(int size, int* gaps) {
+    int count = 0;
+    for (int g = 0; g < CIURA_COUNT && ciuraGaps[g] <= size / 2; g++) gaps[count++] = ciuraGaps[g];
+    if (count == 0) gaps[count++] = 1;
+    while (count == CIURA_COUNT || (count > CIURA_COUNT && count < MAX_GAPS)) {
+        long long next = (long long)gaps[count - 1] * 9 / 4;
+        if (next > size / 2) break;
+        gaps[count++] = (int)next;
+    }
+    return count;
+}
+
+static void emit(OpSink* sink, TraceOp op) {
+    if (sink != NULL) sink->push(sink->context, op);
+}
+
+static int shellSort(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)context;
+    int gaps[MAX_GAPS];
+    long long comparisons = 0;
+    long long accesses = 0;
+    for (int g = shellGaps(size, gaps) - 1; g >= 0; g--) {
+        int gap = gaps[g];
+        for (int i = gap; i < size; i++) {
+            int value = tab[i];
+            int j = i;
+            accesses++;
+            while (j >= gap) {
+                comparisons++;
+                accesses++;
+                emit(sink, makeTraceOp(TRACE_COMPARE, j - gap, i));
+                if (tab[j - gap] <= value) break;
+                tab[j] = tab[j - gap];
+                accesses++;
+                emit(sink, makeTraceOp(TRACE_WRITE, j, tab[j]));
+                j -= gap;
+            }
+            if (j != i) {
+                tab[j] = value;
+                accesses++;
+                emit(sink, makeTraceOp(TRACE_WRITE, j, value));
+            }
+        }
+    }
+    stats->comparisons += comparisons;
+    stats->memoryAccesses += accesses;
+    return 0;
+}
+
+static int shellSortRaw(int* tab, int size, const SortContext* context) {
+    (void)context;
+    int gaps[MAX_GAPS];
+    for (int g = shellGaps(size, gaps) - 1; g >= 0; g--) {
+        int gap = gaps[g];
+        for (int i = gap; i < size; i++) {
+            int value = tab[i];
+            int j = i;
+            while (j >= gap && tab[j - gap] > value) {
+                tab[j] = tab[j - gap];
+                j -= gap;
+            }
+            tab[j] = value;
+        }
+    }
+    return 0;
+}
+
+static const AlgorithmInfo algorithms[] = {
+    { "shell", "Shell Sort", 'G', 0, shellSort, shellSortRaw, 0, ALGO_MEMORY_CONSTANT, KEY_INT32, 0, NULL },
+};
+
+const AlgorithmInfo* sortPluginAlgorithms(int abi, int* count) {
+    if (abi != SORT_PLUGIN_ABI) return NULL;
+    *count = (int)(sizeof(algorithms) / sizeof(algorithms[0]));
+    return algorithms;
+}
@@ -0,0 +1,167 @@
+#include "access.h"
+#include <stdlib.h> // For malloc/free
+#include <string.h> // For memset
+
+#define HEAT_CELLS (ACCESS_TIME_BUCKETS * ACCESS_INDEX_BUCKETS)
+
+AccessMap* createAccessMap(void) {
+    AccessMap* map = (AccessMap*)malloc(sizeof(AccessMap));
+    if (map == NULL) return NULL;
+    memset(map, 0, sizeof(AccessMap));
+    map->reads = (uint64_t*)calloc(HEAT_CELLS, sizeof(uint64_t));
+    map->writes = (uint64_t*)calloc(HEAT_CELLS, sizeof(uint64_t));
+    if (map->reads == NULL || map->writes == NULL) {
+        freeAccessMap(map);
+        return NULL;
+    }
+    map->lastIndex = -1;
+    return map;
+}
+
+int resetAccessMap(AccessMap* map, int size) {
+    memset(map->reads, 0, HEAT_CELLS * sizeof(uint64_t));
+    memset(map->writes, 0, HEAT_CELLS * sizeof(uint64_t));
+    memset(map->strides, 0, sizeof(map->strides));
+    memset(map->reuses, 0, sizeof(map->reuses));
+    map->columns = 0;
+    map->opsPerColumn = 1;
+    map->samplePeriod = 1;
+    map->nextSample = 0;
+    map->ops = 0;
+    map->readCount = 0;
+    map->writeCount = 0;
+    map->coldLines = 0;
+    map->lastIndex = -1;
+
+    int lineCount = size > 0 ? ((size - 1) >> ACCESS_LINE_SHIFT) + 1 : 0;
+    if (lineCount != map->lineCount) {
+        free(map->lastTouch);
+        map->lastTouch = lineCount > 0 ? (uint64_t*)malloc(lineCount * sizeof(uint64_t)) : NULL;
+        if (lineCount > 0 && map->lastTouch == NULL) {
+            map->size = 0; // records nothing
+            map->rows = 0;
+            map->lineCount = 0;
+            return -1;
+        }
+        map->lineCount = lineCount;
+    }
+    if (lineCount > 0) memset(map->lastTouch, 0, lineCount * sizeof(uint64_t));
+
+    // about ACCESS_TRACKED_LINES lines followed, whatever the size
+    map->lineMask = 0;
+    while ((uint64_t)lineCount / (map->lineMask + 1) > ACCESS_TRACKED_LINES) map->lineMask = map->lineMask * 2 + 1;
+
+    map->size = size > 0 ? size : 0;
+    map->rows = size < ACCESS_INDEX_BUCKETS ? map->size : ACCESS_INDEX_BUCKETS;
+    return 0;
+}
+
+void freeAccessMap(AccessMap* map) {
+    if (map == NULL) return;
+    free(map->reads);
+    free(map->writes);
+    free(map->lastTouch);
+    free(map);
+}
+
+// Bin of a distance: 0 for 0, else 1 + floor(log2(distance)), capped
+static inline int histogramBin(uint64_t distance) {
+    if (distance == 0) return 0;
+    int bin = 64 - __builtin_clzll(distance);
+    return bin < ACCESS_HISTOGRAM_BINS ? bin : ACCESS_HISTOGRAM_BINS - 1;
+}
+
+// Reuse distance of a touch of tab[index] by op 'op' (tracked lines only)
+static inline void touchLine(AccessMap* map, int index, uint64_t op) {
+    uint32_t line = (uint32_t)index >> ACCESS_LINE_SHIFT;
+    if (map->lineMask != 0) {
+        uint32_t hash = line * 0x9E3779B1u; // Fibonacci hashing: strided lines are spread too
+        if (((hash ^ (hash >> 15)) & map->lineMask) != 0) return;
+    }
+    uint64_t last = map->lastTouch[line];
+    if (last == 0) map->coldLines++;
+    else map->reuses[histogramBin(op + 1 - last)]++;
+    map->lastTouch[line] = op + 1;
+}
+
+// Time axis full: every column takes the ops of two, sampled half as often
+static void mergeColumns(AccessMap* map) {
+    int rows = map->rows;
+    for (int c = 0; c < ACCESS_TIME_BUCKETS / 2; c++) {
+        for (int r = 0; r < rows; r++) {
+            map->reads[c * rows + r] = map->reads[2 * c * rows + r] + map->reads[(2 * c + 1) * rows + r];
+            map->writes[c * rows + r] = map->writes[2 * c * rows + r] + map->writes[(2 * c + 1) * rows + r];
+        }
+    }
+    size_t half = (size_t)(ACCESS_TIME_BUCKETS / 2) * rows;
+    memset(map->reads + half, 0, half * sizeof(uint64_t));
+    memset(map->writes + half, 0, half * sizeof(uint64_t));
+    map->columns = (map->columns + 1) / 2;
+    map->opsPerColumn *= 2;
+    if (map->opsPerColumn > ACCESS_SAMPLES_PER_COLUMN) map->samplePeriod = map->opsPerColumn / ACCESS_SAMPLES_PER_COLUMN;
+}
+
+// Heatmap cell and strides of one sampled op, weighted by the sampling period
+static void sampleOp(AccessMap* map, unsigned type, int a, int b, uint64_t op) {
+    uint64_t column = op / map->opsPerColumn;
+    while (column >= ACCESS_TIME_BUCKETS) {
+        mergeColumns(map);
+        column = op / map->opsPerColumn;
+    }
+    if ((int)column >= map->columns) map->columns = (int)column + 1;
+
+    uint64_t weight = map->samplePeriod;
+    size_t cell = (size_t)column * map->rows;
+    size_t rowA = cell + (size_t)((long long)a * map->rows / map->size);
+    if (type == TRACE_WRITE) {
+        map->writes[rowA] += weight;
+    } else if (type == TRACE_READ) {
+        map->reads[rowA] += weight;
+    } else {
+        size_t rowB = cell + (size_t)((long long)b * map->rows / map->size);
+        map->reads[rowA] += weight;
+        map->reads[rowB] += weight;
+        if (type == TRACE_SWAP) {
+            map->writes[rowA] += weight;
+            map->writes[rowB] += weight;
+        }
+    }
+
+    if (map->lastIndex >= 0) map->strides[histogramBin((uint64_t)llabs((long long)a - map->lastIndex))] += weight;
+    if (type != TRACE_WRITE && type != TRACE_READ) map->strides[histogramBin((uint64_t)llabs((long long)b - a))] += weight;
+}
+
+void accessMapRecord(AccessMap* map, const TraceOp* ops, size_t count) {
+    if (map->size == 0) return;
+    for (size_t k = 0; k < count; k++) {
+        uint64_t op = map->ops + k;
+        unsigned type = ops[k].head >> TRACE_TYPE_SHIFT;
+        if (type == TRACE_OWNER) continue; // touches nothing
+        int a = (int)(ops[k].head & TRACE_INDEX_MASK);
+        int single = (type == TRACE_WRITE || type == TRACE_READ); // touches tab[a] only
+        int b = single ? a : (int)ops[k].arg;
+        if (a >= map->size || b < 0 || b >= map->size) continue;
+
+        // totals: every recorded op
+        if (type == TRACE_WRITE) {
+            map->writeCount++;
+        } else if (type == TRACE_READ) {
+            map->readCount++;
+        } else {
+            map->readCount += 2;
+            if (type == TRACE_SWAP) map->writeCount += 2;
+        }
+
+        // reuse: every touch of the tracked lines
+        touchLine(map, a, op);
+        if (!single) touchLine(map, b, op);
+
+        // heatmap and strides: one op out of samplePeriod
+        if (op >= map->nextSample) {
+            sampleOp(map, type, a, b, op);
+            map->nextSample = op + map->samplePeriod;
+        }
+        map->lastIndex = b;
+    }
+    map->ops += count;
+}
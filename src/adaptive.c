@@ -0,0 +1,763 @@
+#include "adaptive.h"
+#include "instrument.h"
+#include <stddef.h> // For NULL
+
+#define TIM_MIN_MERGE 64  // below this, one binary insertion sort (no merge)
+#define TIM_MIN_GALLOP 7  // wins in a row before a merge starts galloping
+#define TIM_STACK_SIZE 64 // pending runs: the invariants keep them under log_phi(n)
+
+#define PDQ_INSERTION_CUTOFF 24 // ranges this short are finished by insertion sort
+#define PDQ_NINTHER_CUTOFF 128  // above this, the pivot is a median of three medians
+#define PDQ_PARTIAL_LIMIT 8     // moves allowed to the insertion sort of an already partitioned range
+
+/*
+----------------------------------------------------
+ TIMSORT
+----------------------------------------------------
+*/
+typedef struct {
+    int base;
+    int length;
+} TimRun;
+
+// Everything the helpers need, kept in one place so they stay small.
+// Every helper is inlined into the two entry points with 'counted' constant
+// (instrument.h): tim_sort counts and traces, tim_sort_raw does neither.
+typedef struct {
+    int* tab;
+    int* buffer; // copy of the shorter run of a merge (size / 2 elements)
+    int minGallop;
+    TimRun runs[TIM_STACK_SIZE];
+    int runCount;
+    Counters counters; // flushed to 'stats' after each run / merge
+    Stats_t* stats;
+    OpSink* sink;
+} Tim;
+
+KERNEL_INLINE void timEmit(Tim* s, TraceOp op, const int counted) {
+    if (counted && s->sink != NULL) s->sink->push(s->sink->context, op);
+}
+
+// tab[index] = value (the value was read before: 1 read + 1 write)
+KERNEL_INLINE void timWrite(Tim* s, int index, int value, const int counted) {
+    COUNT_ACCESSES(&s->counters, 2);
+    s->tab[index] = value;
+    timEmit(s, makeTraceOp(TRACE_WRITE, index, value), counted);
+}
+
+// a < b for keys already read; 'index' is the element of tab just read (-1: one of the buffer)
+KERNEL_INLINE int timLess(Tim* s, int a, int b, int index, const int counted) {
+    COUNT_COMPARISONS(&s->counters, 1);
+    if (index >= 0) timEmit(s, makeTraceOp(TRACE_READ, index, 0), counted);
+    return a < b;
+}
+
+// tab[index] = value, for a key held in a local (1 write)
+KERNEL_INLINE void timStore(Tim* s, int index, int value, const int counted) {
+    COUNT_ACCESSES(&s->counters, 1);
+    s->tab[index] = value;
+    timEmit(s, makeTraceOp(TRACE_WRITE, index, value), counted);
+}
+
+// run[i], from tab or from the buffer
+KERNEL_INLINE int timRead(Tim* s, const int* run, int i, const int counted) {
+    (void)s;
+    COUNT_ACCESSES(&s->counters, 1);
+    return run[i];
+}
+
+/*
+ Galloping: where 'key' goes in the sorted run[0 .. length), searched by
+ exponential steps from 'hint' and then by bisection, in O(log distance).
+ 'traceBase' is the index of run[0] in tab (-1: the run is in the buffer, its reads are not traced).
+ gallopLeft returns the first k with key <= run[k] (before equal keys),
+ gallopRight the first k with key < run[k] (after equal keys).
+*/
+KERNEL_INLINE int gallopLeft(Tim* s, int key, const int* run, int length, int hint, int traceBase, const int counted) {
+    long long lastOffset = 0, offset = 1;
+    int probe = traceBase >= 0 ? traceBase + hint : -1;
+    if (timLess(s, timRead(s, run, hint, counted), key, probe, counted)) {
+        // run[hint] < key: step right until key <= run[hint + offset]
+        long long maxOffset = length - hint;
+        while (offset < maxOffset &&
+               timLess(s, timRead(s, run, hint + (int)offset, counted), key,
+                       traceBase >= 0 ? traceBase + hint + (int)offset : -1, counted)) {
+            lastOffset = offset;
+            offset = (offset << 1) + 1;
+        }
+        if (offset > maxOffset) offset = maxOffset;
+        lastOffset += hint;
+        offset += hint;
+    } else {
+        // key <= run[hint]: step left until run[hint - offset] < key
+        long long maxOffset = hint + 1;
+        while (offset < maxOffset &&
+               !timLess(s, timRead(s, run, hint - (int)offset, counted), key,
+                        traceBase >= 0 ? traceBase + hint - (int)offset : -1, counted)) {
+            lastOffset = offset;
+            offset = (offset << 1) + 1;
+        }
+        if (offset > maxOffset) offset = maxOffset;
+        long long k = lastOffset;
+        lastOffset = hint - offset;
+        offset = hint - k;
+    }
+    // run[lastOffset] < key <= run[offset]: bisect in between
+    lastOffset++;
+    while (lastOffset < offset) {
+        long long mid = lastOffset + ((offset - lastOffset) >> 1);
+        if (timLess(s, timRead(s, run, (int)mid, counted), key, traceBase >= 0 ? traceBase + (int)mid : -1, counted)) {
+            lastOffset = mid + 1;
+        } else {
+            offset = mid;
+        }
+    }
+    return (int)offset;
+}
+
+KERNEL_INLINE int gallopRight(Tim* s, int key, const int* run, int length, int hint, int traceBase, const int counted) {
+    long long lastOffset = 0, offset = 1;
+    int probe = traceBase >= 0 ? traceBase + hint : -1;
+    if (timLess(s, key, timRead(s, run, hint, counted), probe, counted)) {
+        // key < run[hint]: step left until run[hint - offset] <= key
+        long long maxOffset = hint + 1;
+        while (offset < maxOffset &&
+               timLess(s, key, timRead(s, run, hint - (int)offset, counted),
+                       traceBase >= 0 ? traceBase + hint - (int)offset : -1, counted)) {
+            lastOffset = offset;
+            offset = (offset << 1) + 1;
+        }
+        if (offset > maxOffset) offset = maxOffset;
+        long long k = lastOffset;
+        lastOffset = hint - offset;
+        offset = hint - k;
+    } else {
+        // run[hint] <= key: step right until key < run[hint + offset]
+        long long maxOffset = length - hint;
+        while (offset < maxOffset &&
+               !timLess(s, key, timRead(s, run, hint + (int)offset, counted),
+                        traceBase >= 0 ? traceBase + hint + (int)offset : -1, counted)) {
+            lastOffset = offset;
+            offset = (offset << 1) + 1;
+        }
+        if (offset > maxOffset) offset = maxOffset;
+        lastOffset += hint;
+        offset += hint;
+    }
+    // run[lastOffset] <= key < run[offset]: bisect in between
+    lastOffset++;
+    while (lastOffset < offset) {
+        long long mid = lastOffset + ((offset - lastOffset) >> 1);
+        if (timLess(s, key, timRead(s, run, (int)mid, counted), traceBase >= 0 ? traceBase + (int)mid : -1, counted)) {
+            offset = mid;
+        } else {
+            lastOffset = mid + 1;
+        }
+    }
+    return (int)offset;
+}
+
+KERNEL_INLINE void countGallop(Tim* s, int moved, const int counted) {
+    if (counted && moved > 0) s->stats->gallopHits++;
+}
+
+// Length of the run starting at 'low' (at most up to 'high', exclusive);
+// a strictly descending run is reversed (strictly: equal keys keep their order).
+KERNEL_INLINE int countRun(Tim* s, int low, int high, const int counted) {
+    int* tab = s->tab;
+    int runHigh = low + 1;
+    if (runHigh == high) return 1;
+
+    if (timLess(s, timRead(s, tab, runHigh, counted), timRead(s, tab, low, counted), runHigh, counted)) {
+        runHigh++;
+        while (runHigh < high &&
+               timLess(s, timRead(s, tab, runHigh, counted), timRead(s, tab, runHigh - 1, counted), runHigh, counted)) {
+            runHigh++;
+        }
+        for (int i = low, j = runHigh - 1; i < j; i++, j--) {
+            COUNT_ACCESSES(&s->counters, 4); // 2 reads + 2 writes
+            int tmp = tab[i];
+            tab[i] = tab[j];
+            tab[j] = tmp;
+            timEmit(s, makeTraceOp(TRACE_SWAP, i, j), counted);
+        }
+    } else {
+        runHigh++;
+        while (runHigh < high &&
+               !timLess(s, timRead(s, tab, runHigh, counted), timRead(s, tab, runHigh - 1, counted), runHigh, counted)) {
+            runHigh++;
+        }
+    }
+    return runHigh - low;
+}
+
+// Sorts tab[low .. high) knowing that tab[low .. start) is sorted
+KERNEL_INLINE void binaryInsertion(Tim* s, int low, int high, int start, const int counted) {
+    int* tab = s->tab;
+    for (int i = start; i < high; i++) {
+        int pivot = timRead(s, tab, i, counted);
+        int left = low, right = i;
+        while (left < right) {
+            int mid = left + ((right - left) >> 1);
+            if (timLess(s, pivot, timRead(s, tab, mid, counted), mid, counted)) right = mid;
+            else left = mid + 1;
+        }
+        for (int j = i; j > left; j--) timWrite(s, j, tab[j - 1], counted);
+        timStore(s, left, pivot, counted);
+    }
+}
+
+// Smallest run length worth merging: n / minRun is a power of two or just below
+static int computeMinRun(int size) {
+    int extra = 0;
+    while (size >= TIM_MIN_MERGE) {
+        extra |= size & 1;
+        size >>= 1;
+    }
+    return size + extra;
+}
+
+/*
+ Merges A = tab[baseA .. +lengthA) and the run B right after it, with
+ lengthA <= lengthB: A is copied to the buffer and merged from the left.
+ The caller made sure that B[0] < A[0] and that A ends with the largest key.
+*/
+KERNEL_INLINE void mergeLow(Tim* s, int baseA, int lengthA, int baseB, int lengthB, const int counted) {
+    int* tab = s->tab;
+    int* buffer = s->buffer;
+    for (int i = 0; i < lengthA; i++) buffer[i] = tab[baseA + i];
+    COUNT_ACCESSES(&s->counters, 2LL * lengthA);
+
+    int a = 0, b = baseB, dest = baseA;
+    int minGallop = s->minGallop;
+    timWrite(s, dest++, tab[b++], counted);
+    if (--lengthB == 0) goto succeed;
+    if (lengthA == 1) goto copyB;
+
+    while (1) {
+        int winsA = 0, winsB = 0;
+        // one element at a time until one side wins minGallop times in a row
+        while (1) {
+            if (timLess(s, timRead(s, tab, b, counted), timRead(s, buffer, a, counted), b, counted)) {
+                timWrite(s, dest++, tab[b++], counted);
+                winsB++;
+                winsA = 0;
+                if (--lengthB == 0) goto succeed;
+                if (winsB >= minGallop) break;
+            } else {
+                timWrite(s, dest++, buffer[a++], counted);
+                winsA++;
+                winsB = 0;
+                if (--lengthA == 1) goto copyB;
+                if (winsA >= minGallop) break;
+            }
+        }
+
+        // galloping: whole blocks at once while it keeps paying off
+        minGallop++;
+        do {
+            minGallop -= minGallop > 1;
+            int k = gallopRight(s, tab[b], buffer + a, lengthA, 0, -1, counted);
+            winsA = k;
+            countGallop(s, k, counted);
+            for (int i = 0; i < k; i++) timWrite(s, dest++, buffer[a++], counted);
+            lengthA -= k;
+            if (lengthA == 1) goto copyB;
+            if (lengthA == 0) goto succeed;
+            timWrite(s, dest++, tab[b++], counted);
+            if (--lengthB == 0) goto succeed;
+
+            k = gallopLeft(s, buffer[a], tab + b, lengthB, 0, b, counted);
+            winsB = k;
+            countGallop(s, k, counted);
+            for (int i = 0; i < k; i++) timWrite(s, dest++, tab[b++], counted);
+            lengthB -= k;
+            if (lengthB == 0) goto succeed;
+            timWrite(s, dest++, buffer[a++], counted);
+            if (--lengthA == 1) goto copyB;
+        } while (winsA >= TIM_MIN_GALLOP || winsB >= TIM_MIN_GALLOP);
+        minGallop++; // leaving gallop mode costs: harder to enter again
+    }
+
+succeed:
+    for (int i = 0; i < lengthA; i++) timWrite(s, dest++, buffer[a++], counted);
+    s->minGallop = minGallop < 1 ? 1 : minGallop;
+    return;
+copyB:
+    // the last element of A is the largest: the rest of B, then it
+    for (int i = 0; i < lengthB; i++) timWrite(s, dest++, tab[b++], counted);
+    timWrite(s, dest, buffer[a], counted);
+    s->minGallop = minGallop < 1 ? 1 : minGallop;
+}
+
+/*
+ Same with lengthA > lengthB: B is copied to the buffer and merged from the
+ right. The caller made sure that the last of A > the last of B and that
+ B[0] < A[0].
+*/
+KERNEL_INLINE void mergeHigh(Tim* s, int baseA, int lengthA, int baseB, int lengthB, const int counted) {
+    int* tab = s->tab;
+    int* buffer = s->buffer;
+    for (int i = 0; i < lengthB; i++) buffer[i] = tab[baseB + i];
+    COUNT_ACCESSES(&s->counters, 2LL * lengthB);
+
+    int a = baseA + lengthA - 1, b = lengthB - 1, dest = baseB + lengthB - 1;
+    int minGallop = s->minGallop;
+    timWrite(s, dest--, tab[a--], counted);
+    if (--lengthA == 0) goto succeed;
+    if (lengthB == 1) goto copyA;
+
+    while (1) {
+        int winsA = 0, winsB = 0;
+        while (1) {
+            if (timLess(s, timRead(s, buffer, b, counted), timRead(s, tab, a, counted), a, counted)) {
+                timWrite(s, dest--, tab[a--], counted);
+                winsA++;
+                winsB = 0;
+                if (--lengthA == 0) goto succeed;
+                if (winsA >= minGallop) break;
+            } else {
+                timWrite(s, dest--, buffer[b--], counted);
+                winsB++;
+                winsA = 0;
+                if (--lengthB == 1) goto copyA;
+                if (winsB >= minGallop) break;
+            }
+        }
+
+        minGallop++;
+        do {
+            minGallop -= minGallop > 1;
+            int k = lengthA - gallopRight(s, buffer[b], tab + baseA, lengthA, lengthA - 1, baseA, counted);
+            winsA = k;
+            countGallop(s, k, counted);
+            for (int i = 0; i < k; i++) timWrite(s, dest--, tab[a--], counted);
+            lengthA -= k;
+            if (lengthA == 0) goto succeed;
+            timWrite(s, dest--, buffer[b--], counted);
+            if (--lengthB == 1) goto copyA;
+
+            k = lengthB - gallopLeft(s, tab[a], buffer, lengthB, lengthB - 1, -1, counted);
+            winsB = k;
+            countGallop(s, k, counted);
+            for (int i = 0; i < k; i++) timWrite(s, dest--, buffer[b--], counted);
+            lengthB -= k;
+            if (lengthB == 1) goto copyA;
+            if (lengthB == 0) goto succeed;
+            timWrite(s, dest--, tab[a--], counted);
+            if (--lengthA == 0) goto succeed;
+        } while (winsA >= TIM_MIN_GALLOP || winsB >= TIM_MIN_GALLOP);
+        minGallop++;
+    }
+
+succeed:
+    for (int i = 0; i < lengthB; i++) timWrite(s, dest--, buffer[b--], counted);
+    s->minGallop = minGallop < 1 ? 1 : minGallop;
+    return;
+copyA:
+    // the first element of B is the smallest: the rest of A, then it
+    for (int i = 0; i < lengthA; i++) timWrite(s, dest--, tab[a--], counted);
+    timWrite(s, dest, buffer[b], counted);
+    s->minGallop = minGallop < 1 ? 1 : minGallop;
+}
+
+// Merges the runs i and i + 1 of the stack
+KERNEL_INLINE void mergeAt(Tim* s, int i, const int counted) {
+    int* tab = s->tab;
+    int baseA = s->runs[i].base, lengthA = s->runs[i].length;
+    int baseB = s->runs[i + 1].base, lengthB = s->runs[i + 1].length;
+
+    s->runs[i].length = lengthA + lengthB;
+    if (i == s->runCount - 3) s->runs[i + 1] = s->runs[i + 2];
+    s->runCount--;
+
+    // the start of A that is already below B[0] stays where it is
+    int k = gallopRight(s, tab[baseB], tab + baseA, lengthA, 0, baseA, counted);
+    countGallop(s, k, counted);
+    baseA += k;
+    lengthA -= k;
+    if (lengthA > 0) {
+        // and so does the end of B that is already above the last of A
+        int keptB = gallopLeft(s, tab[baseA + lengthA - 1], tab + baseB, lengthB, lengthB - 1, baseB, counted);
+        countGallop(s, lengthB - keptB, counted);
+        lengthB = keptB;
+        if (lengthB > 0) {
+            if (lengthA <= lengthB) mergeLow(s, baseA, lengthA, baseB, lengthB, counted);
+            else mergeHigh(s, baseA, lengthA, baseB, lengthB, counted);
+        }
+    }
+    flushCounters(&s->counters, s->stats, counted);
+}
+
+// Merges until the run lengths on the stack grow at least like Fibonacci
+// (checked on the top 4 runs: the top 3 alone are not enough)
+KERNEL_INLINE void mergeCollapse(Tim* s, const int counted) {
+    TimRun* runs = s->runs;
+    while (s->runCount > 1) {
+        int n = s->runCount - 2;
+        if ((n > 0 && runs[n - 1].length <= runs[n].length + runs[n + 1].length) ||
+            (n > 1 && runs[n - 2].length <= runs[n - 1].length + runs[n].length)) {
+            if (runs[n - 1].length < runs[n + 1].length) n--;
+        } else if (runs[n].length > runs[n + 1].length) {
+            break;
+        }
+        mergeAt(s, n, counted);
+    }
+}
+
+KERNEL_INLINE void mergeForceCollapse(Tim* s, const int counted) {
+    while (s->runCount > 1) {
+        int n = s->runCount - 2;
+        if (n > 0 && s->runs[n - 1].length < s->runs[n + 1].length) n--;
+        mergeAt(s, n, counted);
+    }
+}
+
+KERNEL_INLINE int timBody(int* tab, int size, Stats_t* stats, Arena* arena, OpSink* sink, const int counted) {
+    if (size < 2) return 0;
+    Tim s;
+    s.tab = tab;
+    s.buffer = NULL;
+    s.minGallop = TIM_MIN_GALLOP;
+    s.runCount = 0;
+    s.counters.comparisons = 0;
+    s.counters.memoryAccesses = 0;
+    s.stats = stats;
+    s.sink = sink;
+
+    if (size < TIM_MIN_MERGE) {
+        // one run extended to the whole array
+        int length = countRun(&s, 0, size, counted);
+        if (counted) stats->naturalRuns++;
+        binaryInsertion(&s, 0, size, length, counted);
+        flushCounters(&s.counters, stats, counted);
+        return 0;
+    }
+
+    size_t bufferBytes = (size_t)(size / 2 + 1) * sizeof(int);
+    s.buffer = (int*)arenaAlloc(arena, bufferBytes, counted ? stats : NULL);
+    if (s.buffer == NULL) return -1;
+
+    int minRun = computeMinRun(size);
+    int low = 0, remaining = size;
+    while (remaining > 0) {
+        int length = countRun(&s, low, size, counted);
+        if (counted) stats->naturalRuns++;
+        if (length < minRun) {
+            // short run: grown to minRun by binary insertion
+            int forced = remaining < minRun ? remaining : minRun;
+            binaryInsertion(&s, low, low + forced, low + length, counted);
+            length = forced;
+        }
+        s.runs[s.runCount].base = low;
+        s.runs[s.runCount].length = length;
+        s.runCount++;
+        flushCounters(&s.counters, stats, counted);
+        mergeCollapse(&s, counted);
+
+        low += length;
+        remaining -= length;
+    }
+    mergeForceCollapse(&s, counted);
+
+    arenaFree(arena, s.buffer, bufferBytes, counted ? stats : NULL);
+    return 0;
+}
+
+int tim_sort(int* tab, int size, Stats_t* stats, Arena* arena, OpSink* sink) {
+    return timBody(tab, size, stats, arena, sink, 1);
+}
+
+int tim_sort_raw(int* tab, int size) {
+    return timBody(tab, size, NULL, NULL, NULL, 0);
+}
+
+/*
+----------------------------------------------------
+ PDQSORT
+----------------------------------------------------
+*/
+typedef struct {
+    int* tab;
+    Counters counters; // flushed to 'stats' after each partition / leaf
+    Stats_t* stats;
+    OpSink* sink;
+} Pdq;
+
+KERNEL_INLINE void pdqEmit(Pdq* s, TraceOp op, const int counted) {
+    if (counted && s->sink != NULL) s->sink->push(s->sink->context, op);
+}
+
+// key < tab[i] for a key already read
+KERNEL_INLINE int keyLess(Pdq* s, int key, int i, const int counted) {
+    COUNT_COMPARISONS(&s->counters, 1);
+    COUNT_ACCESSES(&s->counters, 1);
+    pdqEmit(s, makeTraceOp(TRACE_READ, i, 0), counted);
+    return key < s->tab[i];
+}
+
+// tab[i] < key
+KERNEL_INLINE int lessKey(Pdq* s, int i, int key, const int counted) {
+    COUNT_COMPARISONS(&s->counters, 1);
+    COUNT_ACCESSES(&s->counters, 1);
+    pdqEmit(s, makeTraceOp(TRACE_READ, i, 0), counted);
+    return s->tab[i] < key;
+}
+
+KERNEL_INLINE int pdqLess(Pdq* s, int i, int j, const int counted) {
+    COUNT_COMPARISONS(&s->counters, 1);
+    COUNT_ACCESSES(&s->counters, 2);
+    pdqEmit(s, makeTraceOp(TRACE_COMPARE, i, j), counted);
+    return s->tab[i] < s->tab[j];
+}
+
+KERNEL_INLINE void pdqSwap(Pdq* s, int i, int j, const int counted) {
+    COUNT_ACCESSES(&s->counters, 4); // 2 reads + 2 writes
+    int tmp = s->tab[i];
+    s->tab[i] = s->tab[j];
+    s->tab[j] = tmp;
+    pdqEmit(s, makeTraceOp(TRACE_SWAP, i, j), counted);
+}
+
+KERNEL_INLINE void pdqWrite(Pdq* s, int i, int value, const int counted) {
+    COUNT_ACCESSES(&s->counters, 1);
+    s->tab[i] = value;
+    pdqEmit(s, makeTraceOp(TRACE_WRITE, i, value), counted);
+}
+
+KERNEL_INLINE int pdqRead(Pdq* s, int i, const int counted) {
+    COUNT_ACCESSES(&s->counters, 1);
+    return s->tab[i];
+}
+
+// Insertion sort of tab[low .. high). Unless 'leftmost', tab[low - 1] is
+// <= every key of the range and stops the shifts without a bound check.
+KERNEL_INLINE void pdqInsertion(Pdq* s, int low, int high, int leftmost, const int counted) {
+    for (int i = low + 1; i < high; i++) {
+        if (!pdqLess(s, i, i - 1, counted)) continue;
+        int key = pdqRead(s, i, counted);
+        int j = i;
+        do {
+            pdqWrite(s, j, pdqRead(s, j - 1, counted), counted);
+            j--;
+        } while ((!leftmost || j > low) && keyLess(s, key, j - 1, counted));
+        pdqWrite(s, j, key, counted);
+    }
+}
+
+// Insertion sort that gives up after PDQ_PARTIAL_LIMIT moves.
+// return 1 if tab[low .. high) is now sorted.
+KERNEL_INLINE int partialInsertion(Pdq* s, int low, int high, const int counted) {
+    int moves = 0;
+    for (int i = low + 1; i < high; i++) {
+        if (!pdqLess(s, i, i - 1, counted)) continue;
+        int key = pdqRead(s, i, counted);
+        int j = i;
+        do {
+            pdqWrite(s, j, pdqRead(s, j - 1, counted), counted);
+            j--;
+        } while (j > low && keyLess(s, key, j - 1, counted));
+        pdqWrite(s, j, key, counted);
+        moves += i - j;
+        if (moves > PDQ_PARTIAL_LIMIT) return 0;
+    }
+    return 1;
+}
+
+// Orders tab[a] <= tab[b] <= tab[c]
+KERNEL_INLINE void pdqSort3(Pdq* s, int a, int b, int c, const int counted) {
+    if (pdqLess(s, b, a, counted)) pdqSwap(s, a, b, counted);
+    if (pdqLess(s, c, b, counted)) pdqSwap(s, b, c, counted);
+    if (pdqLess(s, b, a, counted)) pdqSwap(s, a, b, counted);
+}
+
+/*
+ Partition around the pivot tab[low]: keys < pivot to the left, keys >=
+ pivot to the right. The median-of-3 left a key >= pivot at the end, so the
+ scans need no bound check. 'alreadyPartitioned' is set when no swap was
+ needed.
+ return the final position of the pivot.
+*/
+KERNEL_INLINE int partitionRight(Pdq* s, int low, int high, int* alreadyPartitioned, const int counted) {
+    int pivot = pdqRead(s, low, counted);
+    int first = low, last = high;
+
+    while (lessKey(s, ++first, pivot, counted));
+    if (first - 1 == low) {
+        while (first < last && !lessKey(s, --last, pivot, counted));
+    } else {
+        while (!lessKey(s, --last, pivot, counted));
+    }
+    *alreadyPartitioned = first >= last;
+
+    while (first < last) {
+        pdqSwap(s, first, last, counted);
+        while (lessKey(s, ++first, pivot, counted));
+        while (!lessKey(s, --last, pivot, counted));
+    }
+    int pivotPosition = first - 1;
+    pdqWrite(s, low, pdqRead(s, pivotPosition, counted), counted);
+    pdqWrite(s, pivotPosition, pivot, counted);
+    return pivotPosition;
+}
+
+/*
+ Used when the pivot equals the key right before the range (so no key of
+ the range is smaller): keys == pivot to the left, keys > pivot to the
+ right. The left part is then done, whatever its size.
+ return the last position of the keys equal to the pivot.
+*/
+KERNEL_INLINE int partitionLeft(Pdq* s, int low, int high, const int counted) {
+    int pivot = pdqRead(s, low, counted);
+    int first = low, last = high;
+
+    while (keyLess(s, pivot, --last, counted));
+    if (last + 1 == high) {
+        while (first < last && !keyLess(s, pivot, ++first, counted));
+    } else {
+        while (!keyLess(s, pivot, ++first, counted));
+    }
+
+    while (first < last) {
+        pdqSwap(s, first, last, counted);
+        while (keyLess(s, pivot, --last, counted));
+        while (!keyLess(s, pivot, ++first, counted));
+    }
+    pdqWrite(s, low, pdqRead(s, last, counted), counted);
+    pdqWrite(s, last, pivot, counted);
+    return last;
+}
+
+// Heap sort of tab[low .. high), once too many partitions went wrong
+KERNEL_INLINE void pdqSiftDown(Pdq* s, int low, int root, int count, const int counted) {
+    while (1) {
+        int child = 2 * root + 1;
+        if (child >= count) return;
+        if (child + 1 < count && pdqLess(s, low + child, low + child + 1, counted)) child++;
+        if (!pdqLess(s, low + root, low + child, counted)) return;
+        pdqSwap(s, low + root, low + child, counted);
+        root = child;
+    }
+}
+
+KERNEL_INLINE void pdqHeapSort(Pdq* s, int low, int high, const int counted) {
+    int count = high - low;
+    for (int root = count / 2 - 1; root >= 0; root--) pdqSiftDown(s, low, root, count, counted);
+    for (int end = count - 1; end > 0; end--) {
+        pdqSwap(s, low, low + end, counted);
+        pdqSiftDown(s, low, 0, end, counted);
+    }
+}
+
+// Swaps a few elements of a side left very small or very large by a
+// partition, to break the pattern that caused it
+KERNEL_INLINE void breakPatterns(Pdq* s, int low, int high, const int counted) {
+    int length = high - low;
+    if (length < PDQ_INSERTION_CUTOFF) return;
+    int quarter = length / 4;
+    pdqSwap(s, low, low + quarter, counted);
+    pdqSwap(s, high - 1, high - quarter, counted);
+    if (length > PDQ_NINTHER_CUTOFF) {
+        pdqSwap(s, low + 1, low + quarter + 1, counted);
+        pdqSwap(s, low + 2, low + quarter + 2, counted);
+        pdqSwap(s, high - 2, high - quarter - 1, counted);
+        pdqSwap(s, high - 3, high - quarter - 2, counted);
+    }
+}
+
+/*
+ Sorts tab[low .. high). The smaller side of each partition is sorted by
+ recursion and the loop goes on with the larger one, so the recursion is at
+ most log2(n) deep. 'leftmost': nothing before 'low' bounds the range.
+*/
+static void pdqLoopCounted(Pdq* s, int low, int high, int badAllowed, int leftmost);
+static void pdqLoopRaw(Pdq* s, int low, int high, int badAllowed, int leftmost);
+
+KERNEL_INLINE void pdqLoopBody(Pdq* s, int low, int high, int badAllowed, int leftmost, const int counted) {
+    while (1) {
+        int length = high - low;
+        if (length < PDQ_INSERTION_CUTOFF) {
+            pdqInsertion(s, low, high, leftmost, counted);
+            flushCounters(&s->counters, s->stats, counted);
+            return;
+        }
+
+        // median of 3 (ninther above PDQ_NINTHER_CUTOFF) moved to tab[low]
+        int half = length / 2;
+        if (length > PDQ_NINTHER_CUTOFF) {
+            pdqSort3(s, low, low + half, high - 1, counted);
+            pdqSort3(s, low + 1, low + half - 1, high - 2, counted);
+            pdqSort3(s, low + 2, low + half + 1, high - 3, counted);
+            pdqSort3(s, low + half - 1, low + half, low + half + 1, counted);
+            pdqSwap(s, low, low + half, counted);
+        } else {
+            pdqSort3(s, low + half, low, high - 1, counted);
+        }
+
+        // many keys equal to the pivot: put them aside in one pass
+        if (!leftmost && !pdqLess(s, low - 1, low, counted)) {
+            low = partitionLeft(s, low, high, counted) + 1;
+            flushCounters(&s->counters, s->stats, counted);
+            continue;
+        }
+
+        int alreadyPartitioned = 0;
+        int pivot = partitionRight(s, low, high, &alreadyPartitioned, counted);
+        flushCounters(&s->counters, s->stats, counted);
+        int leftLength = pivot - low;
+        int rightLength = high - (pivot + 1);
+
+        if (leftLength < length / 8 || rightLength < length / 8) {
+            // unbalanced: heap sort if it keeps happening, else shuffle
+            if (--badAllowed == 0) {
+                pdqHeapSort(s, low, high, counted);
+                flushCounters(&s->counters, s->stats, counted);
+                return;
+            }
+            breakPatterns(s, low, pivot, counted);
+            breakPatterns(s, pivot + 1, high, counted);
+        } else if (alreadyPartitioned && partialInsertion(s, low, pivot, counted) &&
+                   partialInsertion(s, pivot + 1, high, counted)) {
+            // the range looked sorted, and it was
+            flushCounters(&s->counters, s->stats, counted);
+            if (counted) s->stats->naturalRuns++;
+            return;
+        }
+
+        if (leftLength < rightLength) {
+            if (counted) pdqLoopCounted(s, low, pivot, badAllowed, leftmost);
+            else pdqLoopRaw(s, low, pivot, badAllowed, leftmost);
+            low = pivot + 1;
+            leftmost = 0;
+        } else {
+            if (counted) pdqLoopCounted(s, pivot + 1, high, badAllowed, 0);
+            else pdqLoopRaw(s, pivot + 1, high, badAllowed, 0);
+            high = pivot;
+        }
+    }
+}
+
+static void pdqLoopCounted(Pdq* s, int low, int high, int badAllowed, int leftmost) {
+    pdqLoopBody(s, low, high, badAllowed, leftmost, 1);
+}
+
+static void pdqLoopRaw(Pdq* s, int low, int high, int badAllowed, int leftmost) {
+    pdqLoopBody(s, low, high, badAllowed, leftmost, 0);
+}
+
+KERNEL_INLINE void pdqBody(int* tab, int size, Stats_t* stats, OpSink* sink, const int counted) {
+    if (size < 2) return;
+    Pdq s = { tab, { 0, 0 }, stats, sink };
+    int badAllowed = 0; // floor(log2(n))
+    for (int n = size; n > 1; n >>= 1) badAllowed++;
+    if (counted) pdqLoopCounted(&s, 0, size, badAllowed, 1);
+    else pdqLoopRaw(&s, 0, size, badAllowed, 1);
+}
+
+void pdq_sort(int* tab, int size, Stats_t* stats, OpSink* sink) {
+    pdqBody(tab, size, stats, sink, 1);
+}
+
+void pdq_sort_raw(int* tab, int size) {
+    pdqBody(tab, size, NULL, NULL, 0);
+}
@@ -0,0 +1,100 @@
+#include "arena.h"
+#include <stdlib.h> // For aligned_alloc and free
+
+// The block header takes a whole line so the data after it stays aligned
+#define BLOCK_HEADER ARENA_ALIGNMENT
+
+static size_t roundUp(size_t bytes) {
+    return (bytes + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+static ArenaBlock* newBlock(Arena* arena, size_t capacity) {
+    ArenaBlock* block = (ArenaBlock*)aligned_alloc(ARENA_ALIGNMENT, BLOCK_HEADER + capacity);
+    if (block == NULL) return NULL;
+    block->next = arena->blocks;
+    block->capacity = capacity;
+    block->used = 0;
+    arena->blocks = block;
+    arena->reserved += capacity;
+    arena->heapAllocations++;
+    return block;
+}
+
+Arena* createArena(size_t capacity) {
+    Arena* arena = (Arena*)malloc(sizeof(Arena));
+    if (arena == NULL) return NULL;
+    arena->blocks = NULL;
+    arena->reserved = 0;
+    arena->heapAllocations = 0;
+    if (capacity > 0 && newBlock(arena, roundUp(capacity)) == NULL) {
+        free(arena);
+        return NULL;
+    }
+    return arena;
+}
+
+static void countAllocation(Stats_t* stats, size_t bytes) {
+    if (stats == NULL) return;
+    stats->auxAllocations++;
+    stats->auxBytes += (long long)bytes;
+    if (stats->auxBytes > stats->auxPeakBytes) stats->auxPeakBytes = stats->auxBytes;
+}
+
+void* arenaAlloc(Arena* arena, size_t bytes, Stats_t* stats) {
+    size_t size = roundUp(bytes > 0 ? bytes : 1);
+    void* pointer;
+    if (arena == NULL) {
+        pointer = aligned_alloc(ARENA_ALIGNMENT, size);
+    } else {
+        ArenaBlock* block = arena->blocks;
+        if (block == NULL || block->capacity - block->used < size) {
+            // at least double what is reserved so a growing run chains few blocks
+            size_t capacity = size > arena->reserved ? size : arena->reserved;
+            block = newBlock(arena, capacity);
+        }
+        pointer = NULL;
+        if (block != NULL) {
+            pointer = (unsigned char*)block + BLOCK_HEADER + block->used;
+            block->used += size;
+        }
+    }
+    if (pointer != NULL) countAllocation(stats, size);
+    return pointer;
+}
+
+void arenaFree(Arena* arena, void* pointer, size_t bytes, Stats_t* stats) {
+    if (pointer == NULL) return;
+    if (stats != NULL) stats->auxBytes -= (long long)roundUp(bytes > 0 ? bytes : 1);
+    if (arena == NULL) free(pointer);
+}
+
+void arenaReset(Arena* arena) {
+    if (arena == NULL || arena->blocks == NULL) return;
+    if (arena->blocks->next == NULL) {
+        arena->blocks->used = 0;
+        return;
+    }
+
+    // several blocks: one block as large as all of them
+    size_t total = arena->reserved;
+    ArenaBlock* block = arena->blocks;
+    while (block != NULL) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+    arena->reserved = 0;
+    newBlock(arena, total); // out of memory: the next allocation tries again
+}
+
+void freeArena(Arena* arena) {
+    if (arena == NULL) return;
+    ArenaBlock* block = arena->blocks;
+    while (block != NULL) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
@@ -0,0 +1,747 @@
+#include "registry.h"
+#include "strsort.h"
+#include "radix.h"
+#include "network.h"
+#include "external.h"
+#include "arena.h"
+#include "typed.h"
+#include "pool.h"
+#include "dataset.h"
+#include "stats.h"
+#include "perf.h"
+#include "suite.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+----------------------------------------------------
+ HEADLESS BENCHMARK
+----------------------------------------------------
+ Runs the sorting kernels without SDL on arrays of 10^3 .. 10^8 elements
+ (one size per power of ten) and prints wall time, comparisons,
+ memory accesses and the hardware counters (perf.c) as CSV or JSON.
+ Parallel sorts are run with 1, 2, 4, ... up to --threads workers to give
+ the speedup curve.
+ --external IN OUT sorts a file of 32-bit ints that may not fit in memory
+ instead (external merge sort within --memory MB, runs written to --temp).
+ --network picks the sorting network used for the small leaves of intro,
+ pquick and pmerge (default: the best one the CPU has), to compare them.
+ --raw also times the uncounted variant of the sorts that have one
+ (instrument.h) on the same input, to show what the counting costs.
+ Every point is run --warmup times untimed, then --reps times; the median,
+ MAD, p99 and min are printed (suite.h), with the growth exponent since the
+ previous size and a fitted exponent per curve on stderr. --pin keeps the
+ threads on fixed cores. --baseline compares with an earlier JSON output
+ and exits with 2 if a point got significantly slower.
+ The scratch buffers of the sorts come from one arena (arena.h), reset
+ before every run: aux_peak_bytes / aux_allocations give what a run needs,
+ arena_mallocs how often the arena itself had to grow during the timed
+ runs (0 once the warmup has sized it). natural_runs / gallop_hits show how
+ much order the adaptive sorts (tim, pdq) found in the input.
+ quickselect, topk and partial only put the k smallest elements in front
+ (introsort.h); --k gives k as a count or as a percentage of n (default
+ 1%), printed in the k column, to compare their work with a full sort.
+
+ multikey, msd and strintro sort the ints as string keys (strsort.h) of
+ the --strings shape; char_comparisons gives the characters they read.
+ Every algorithm of the registry (registry.h) is measured: the built-ins,
+ the element-type variants below and the --plugin ones; --list prints
+ them.
+
+ ./bench [--algo NAME|all] [--list] [--plugin FILE.so]... [--k K|P%]
+         [--min N] [--max N] [--quadratic-max N] [--threads T]
+         [--format csv|json] [--seed S] [--network auto|avx2|sse4|scalar|off]
+         [--dist shuffled|sorted|reversed|nearly-sorted|few-unique|organ-pipe|
+                 sawtooth|zipf|all-equal|all[,...]] [--dist-param P]
+         [--counters on|off] [--raw] [--reps R] [--warmup W] [--pin CPU]
+         [--strings paths|ids]
+         [--baseline FILE.json] [--tolerance PCT]
+ ./bench --external IN OUT [--memory MB] [--temp DIR] [--threads T]
+----------------------------------------------------
+*/
+
+#define PARALLEL_CUTOFF 4096 // ranges sorted sequentially by one worker
+#define MAX_SIZES 16         // powers of ten in a sweep (10^8 at most)
+#define EXIT_REGRESSION 2    // slower than --baseline (1 is any other failure)
+#define DOUBLE_NAN_PERIOD 64 // introf64 / mergef64: one value in 64 becomes a NaN key
+
+// Pool of the parallel sorts (one per thread count of the sweep, NULL for the others)
+static ThreadPool* benchPool = NULL;
+// Scratch memory of the sorts, and of the key conversions (not counted)
+static Arena* benchArena = NULL;
+// Rank of the selections at the current size (--k)
+static int benchK = 1;
+
+/*
+----------------------------------------------------
+ OTHER ELEMENT TYPES (typed.h)
+----------------------------------------------------
+ Registered by the bench next to the built-ins (the window only sorts
+ ints). The int input is widened to the element type and narrowed back
+ after the sort; the conversion is inside the timing (its buffer is
+ taken from the arena without being counted as scratch memory).
+ Records get a 16-byte key (value / 1024, value % 1024), so both halves
+ are compared, and a payload that has to travel with the key.
+----------------------------------------------------
+*/
+typedef int (*RecordSortFn)(Record* tab, int size, Stats_t* stats, Arena* arena);
+
+static int benchRadix64(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)sink;
+    int64_t* wide = (int64_t*)arenaAlloc(context->arena, size * sizeof(int64_t), NULL);
+    if (wide == NULL) return -1;
+    for (int i = 0; i < size; i++) wide[i] = tab[i];
+    if (radix_sort64(wide, size, stats, context->pool, context->arena) != 0) return -1;
+    for (int i = 0; i < size; i++) tab[i] = (int)wide[i];
+    return 0;
+}
+
+static int benchInt64(int* tab, int size, Stats_t* stats, int merge, Arena* arena) {
+    int64_t* wide = (int64_t*)arenaAlloc(arena, size * sizeof(int64_t), NULL);
+    if (wide == NULL) return -1;
+    for (int i = 0; i < size; i++) wide[i] = (int64_t)tab[i] << 20; // beyond 32 bits
+    if (!merge) i64_intro_sort(wide, size, stats);
+    else if (i64_merge_sort(wide, size, stats, arena) != 0) return -1;
+    for (int i = 0; i < size; i++) tab[i] = (int)(wide[i] >> 20);
+    return 0;
+}
+
+// Key of 'value' in the double sorts: NaN for the multiples of
+// DOUBLE_NAN_PERIOD (so the NaN-last order is exercised), value + 0.25 otherwise
+static double doubleKey(int value) {
+    return value % DOUBLE_NAN_PERIOD == 0 ? NAN : value + 0.25;
+}
+
+static int benchDouble(int* tab, int size, Stats_t* stats, int merge, Arena* arena) {
+    double* keys = (double*)arenaAlloc(arena, size * sizeof(double), NULL);
+    if (keys == NULL) return -1;
+    for (int i = 0; i < size; i++) keys[i] = doubleKey(tab[i]);
+    if (!merge) f64_intro_sort(keys, size, stats);
+    else if (f64_merge_sort(keys, size, stats, arena) != 0) return -1;
+    for (int i = 0; i < size; i++) tab[i] = isnan(keys[i]) ? 0 : (int)keys[i]; // 0: a NaN again for the check
+    return 0;
+}
+
+static int benchRecords(int* tab, int size, Stats_t* stats, RecordSortFn sort, Arena* arena) {
+    Record* records = (Record*)arenaAlloc(arena, size * sizeof(Record), NULL);
+    if (records == NULL) return -1;
+    for (int i = 0; i < size; i++) {
+        records[i].keyHigh = (uint64_t)tab[i] / 1024;
+        records[i].keyLow = (uint64_t)tab[i] % 1024;
+        memset(records[i].payload, i & 0xFF, RECORD_PAYLOAD);
+    }
+    if (sort(records, size, stats, arena) != 0) return -1;
+    for (int i = 0; i < size; i++) tab[i] = (int)(records[i].keyHigh * 1024 + records[i].keyLow);
+    return 0;
+}
+
+static int recordIntro(Record* tab, int size, Stats_t* stats, Arena* arena) {
+    (void)arena;
+    record_intro_sort(tab, size, stats);
+    return 0;
+}
+
+static int benchIntro64(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)sink;
+    return benchInt64(tab, size, stats, 0, context->arena);
+}
+
+static int benchMerge64(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)sink;
+    return benchInt64(tab, size, stats, 1, context->arena);
+}
+
+static int benchIntroDouble(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)sink;
+    return benchDouble(tab, size, stats, 0, context->arena);
+}
+
+static int benchMergeDouble(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)sink;
+    return benchDouble(tab, size, stats, 1, context->arena);
+}
+
+static int benchIntroRecord(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)sink;
+    return benchRecords(tab, size, stats, recordIntro, context->arena);
+}
+
+static int benchMergeRecord(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)sink;
+    return benchRecords(tab, size, stats, record_merge_sort, context->arena);
+}
+
+static int benchTagRecord(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)sink;
+    return benchRecords(tab, size, stats, record_tag_sort, context->arena);
+}
+
+static const AlgorithmInfo typedVariants[] = {
+    // name          label            key          machine run               raw   stable memory                keyTypes     flags          failure
+    { "radix64",     "Radix Sort 64", ALGO_NO_KEY, 0, benchRadix64,     NULL, 1, ALGO_MEMORY_LINEAR,   KEY_INT64,   ALGO_PARALLEL, "out of memory" },
+    { "intro64",     "Intro 64",      ALGO_NO_KEY, 0, benchIntro64,     NULL, 0, ALGO_MEMORY_LOG,      KEY_INT64,   0,             "out of memory" },
+    { "merge64",     "Merge 64",      ALGO_NO_KEY, 0, benchMerge64,     NULL, 1, ALGO_MEMORY_LINEAR,   KEY_INT64,   0,             "out of memory" },
+    { "introf64",    "Intro f64",     ALGO_NO_KEY, 0, benchIntroDouble, NULL, 0, ALGO_MEMORY_LOG,      KEY_FLOAT64, 0,             "out of memory" },
+    { "mergef64",    "Merge f64",     ALGO_NO_KEY, 0, benchMergeDouble, NULL, 1, ALGO_MEMORY_LINEAR,   KEY_FLOAT64, 0,             "out of memory" },
+    { "introrecord", "Intro Record",  ALGO_NO_KEY, 0, benchIntroRecord, NULL, 0, ALGO_MEMORY_LOG,      KEY_RECORD,  0,             "out of memory" },
+    { "mergerecord", "Merge Record",  ALGO_NO_KEY, 0, benchMergeRecord, NULL, 1, ALGO_MEMORY_LINEAR,   KEY_RECORD,  0,             "out of memory" },
+    { "tagrecord",   "Tag Record",    ALGO_NO_KEY, 0, benchTagRecord,   NULL, 0, ALGO_MEMORY_LINEAR,   KEY_RECORD,  0,             "out of memory" },
+};
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int isSorted(const int* tab, int size) {
+    for (int i = 1; i < size; i++) {
+        if (tab[i - 1] > tab[i]) return 0;
+    }
+    return 1;
+}
+
+// Sorted as the double sorts order their keys (doubleKey), NaNs last
+static int isSortedDoubles(const int* tab, int size) {
+    for (int i = 1; i < size; i++) {
+        if (f64Less(doubleKey(tab[i]), doubleKey(tab[i - 1]))) return 0;
+    }
+    return 1;
+}
+
+// Sorted, or for a selection: the rank-k element splits the array
+static int isDone(const AlgorithmInfo* algorithm, const int* tab, int size) {
+    if (algorithm->keyTypes == KEY_FLOAT64) return isSortedDoubles(tab, size);
+    if ((algorithm->flags & ALGO_SELECTION) == 0) return isSorted(tab, size);
+    int k = benchK;
+    if ((algorithm->flags & ALGO_SELECT_PREFIX) && !isSorted(tab, k)) return 0;
+    for (int i = 0; i < k - 1; i++) {
+        if (tab[i] > tab[k - 1]) return 0;
+    }
+    for (int i = k; i < size; i++) {
+        if (tab[i] < tab[k - 1]) return 0;
+    }
+    return 1;
+}
+
+// Hardware counter columns: empty (CSV) or null (JSON) when not measured
+static void printCounterHeader(void) {
+    for (int c = 0; c < HW_COUNTER_COUNT; c++) printf(",%s", perfCounterName(c));
+}
+
+static void printCounters(const Stats_t* stats, int json) {
+    for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+        int valid = (stats->hardwareValid >> c) & 1;
+        if (json && valid) printf(", \"%s\": %lld", perfCounterName(c), stats->hardware[c]);
+        else if (json) printf(", \"%s\": null", perfCounterName(c));
+        else if (valid) printf(",%lld", stats->hardware[c]);
+        else printf(",");
+    }
+}
+
+// Time the counting adds, relative to the raw run
+static double overheadPercent(double counted, double raw) {
+    return raw > 0.0 ? (counted / raw - 1.0) * 100.0 : 0.0;
+}
+
+static double changePercent(double now, double before) {
+    return before > 0.0 ? (now / before - 1.0) * 100.0 : 0.0;
+}
+
+// "all", or a comma separated list of distribution names
+static int parseDistributions(const char* list, int* distributions) {
+    if (strcmp(list, "all") == 0) {
+        for (int d = 0; d < DATASET_COUNT; d++) distributions[d] = d;
+        return DATASET_COUNT;
+    }
+    int count = 0;
+    char name[64];
+    while (*list != '\0') {
+        size_t length = strcspn(list, ",");
+        if (length >= sizeof(name) || count == DATASET_COUNT) length = sizeof(name) - 1;
+        memcpy(name, list, length);
+        name[length] = '\0';
+        int distribution = datasetFromName(name);
+        if (distribution < 0 || count == DATASET_COUNT) {
+            fprintf(stderr, "Unknown distribution '%s'.\n", name);
+            return -1;
+        }
+        distributions[count++] = distribution;
+        list += length;
+        if (*list == ',') list++;
+    }
+    if (count == 0) fprintf(stderr, "No distribution given.\n");
+    return count > 0 ? count : -1;
+}
+
+/*
+----------------------------------------------------
+ ONE POINT OF THE SWEEP
+----------------------------------------------------
+ --warmup untimed runs (caches, page faults, branch predictors, CPU
+ frequency), then --reps timed runs, each on a fresh copy of the input.
+----------------------------------------------------
+*/
+typedef struct {
+    TimingSummary time;
+    TimingSummary raw; // reps = 0 without --raw
+    Stats_t stats;     // counts of one run; hardware counters averaged over the timed runs
+    long long arenaMallocs; // blocks the arena took from the heap during the timed runs
+    int sorted;
+    int failed; // a run returned -1 (algorithm->failure)
+} Point;
+
+static int measurePoint(const AlgorithmInfo* algorithm, const int* input, int n, int reps, int warmup, int raw,
+                        Point* point) {
+    int* work = (int*)malloc((size_t)n * sizeof(int));
+    double* seconds = (double*)malloc(reps * sizeof(double));
+    if (work == NULL || seconds == NULL) {
+        free(work);
+        free(seconds);
+        return -1;
+    }
+    point->sorted = 1;
+    point->failed = 0;
+    SortContext context = { benchPool, benchArena, benchK, PARALLEL_CUTOFF };
+
+    for (int w = 0; w < warmup; w++) {
+        Stats_t scratch;
+        resetStats(&scratch);
+        memcpy(work, input, (size_t)n * sizeof(int));
+        arenaReset(benchArena);
+        if (algorithm->run(work, n, &context, &scratch, NULL) != 0) point->failed = 1;
+    }
+    arenaReset(benchArena); // folds what the warmup added into one block
+    long long heapAllocations = benchArena->heapAllocations;
+
+    // counters opened (a few syscalls per thread) outside the timed part
+    PerfCounters perf;
+    perfOpen(&perf, (algorithm->flags & ALGO_PARALLEL) ? benchPool : NULL);
+    for (int r = 0; r < reps; r++) {
+        memcpy(work, input, (size_t)n * sizeof(int));
+        resetStats(&point->stats);
+        arenaReset(benchArena);
+        double start = nowSeconds();
+        perfEnable(&perf);
+        if (algorithm->run(work, n, &context, &point->stats, NULL) != 0) point->failed = 1;
+        perfDisable(&perf);
+        seconds[r] = nowSeconds() - start;
+        if (!isDone(algorithm, work, n)) point->sorted = 0;
+    }
+    point->arenaMallocs = benchArena->heapAllocations - heapAllocations;
+    perfRead(&perf, &point->stats);
+    perfClose(&perf);
+    for (int c = 0; c < HW_COUNTER_COUNT; c++) point->stats.hardware[c] /= reps;
+    summarizeTimings(seconds, reps, &point->time);
+    point->stats.executionTime = point->time.median;
+
+    point->raw.reps = 0;
+    if (raw && algorithm->raw != NULL) {
+        for (int r = 0; r < warmup + reps; r++) {
+            memcpy(work, input, (size_t)n * sizeof(int));
+            arenaReset(benchArena);
+            double start = nowSeconds();
+            if (algorithm->raw(work, n, &context) != 0) point->failed = 1;
+            if (r >= warmup) seconds[r - warmup] = nowSeconds() - start;
+            if (!isDone(algorithm, work, n)) point->sorted = 0;
+        }
+        summarizeTimings(seconds, reps, &point->raw);
+    }
+    free(work);
+    free(seconds);
+    return 0;
+}
+
+// One CSV line or JSON object ('exponent' and 'base' may be NULL)
+// 'k' is the rank of a selection, 0 for the sorts
+static void printPoint(int json, int first, const char* name, const char* distribution, int threads, long long n,
+                       int k, uint64_t seed, const Point* point, const double* exponent, const BaselineEntry* base) {
+    const TimingSummary* t = &point->time;
+    if (json) {
+        printf("%s  {\"algorithm\": \"%s\", \"distribution\": \"%s\", \"seed\": %llu, \"threads\": %d, "
+               "\"n\": %lld, \"seconds\": %.6f, \"mad\": %.6f, \"p99\": %.6f, \"min\": %.6f, \"reps\": %d",
+               first ? "" : ",\n", name, distribution, (unsigned long long)seed, threads, n,
+               t->median, t->mad, t->p99, t->min, t->reps);
+        if (exponent != NULL) printf(", \"exponent\": %.3f", *exponent);
+        else printf(", \"exponent\": null");
+        printf(", \"comparisons\": %lld, \"memory_accesses\": %lld", point->stats.comparisons,
+               point->stats.memoryAccesses);
+        printf(", \"aux_peak_bytes\": %lld, \"aux_allocations\": %lld, \"arena_mallocs\": %lld",
+               point->stats.auxPeakBytes, point->stats.auxAllocations, point->arenaMallocs);
+        printf(", \"natural_runs\": %lld, \"gallop_hits\": %lld, \"char_comparisons\": %lld",
+               point->stats.naturalRuns, point->stats.gallopHits, point->stats.charComparisons);
+        if (k > 0) printf(", \"k\": %d", k);
+        else printf(", \"k\": null");
+        if (point->raw.reps > 0) {
+            printf(", \"raw_seconds\": %.6f, \"overhead_pct\": %.1f", point->raw.median,
+                   overheadPercent(t->median, point->raw.median));
+        } else {
+            printf(", \"raw_seconds\": null, \"overhead_pct\": null");
+        }
+        if (base != NULL) printf(", \"baseline_pct\": %.1f", changePercent(t->median, base->median));
+        else printf(", \"baseline_pct\": null");
+        printCounters(&point->stats, json);
+        printf("}");
+    } else {
+        printf("%s,%s,%d,%lld,%.6f,%.6f,%.6f,%.6f,%d,", name, distribution, threads, n,
+               t->median, t->mad, t->p99, t->min, t->reps);
+        if (exponent != NULL) printf("%.3f", *exponent);
+        printf(",%lld,%lld,%lld,%lld,%lld,%lld,%lld,%lld,", point->stats.comparisons, point->stats.memoryAccesses,
+               point->stats.auxPeakBytes, point->stats.auxAllocations, point->arenaMallocs,
+               point->stats.naturalRuns, point->stats.gallopHits, point->stats.charComparisons);
+        if (k > 0) printf("%d", k);
+        printf(",");
+        if (point->raw.reps > 0) {
+            printf("%.6f,%.1f,", point->raw.median, overheadPercent(t->median, point->raw.median));
+        } else {
+            printf(",,");
+        }
+        if (base != NULL) printf("%.1f", changePercent(t->median, base->median));
+        printCounters(&point->stats, json);
+        printf("\n");
+    }
+}
+
+// Progress of the external sort, on one stderr line
+static void externalProgress(void* context, const char* phase, long long done, long long total) {
+    (void)context;
+    fprintf(stderr, "\r%-5s %lld / %lld", phase, done, total);
+    if (done == total) fprintf(stderr, "\n");
+}
+
+// --external: one file sort, reported like the other runs
+static int runExternal(const char* input, const char* output, long long memoryMB, const char* tempDir,
+                       int threads, int json) {
+    ExternalConfig config;
+    memset(&config, 0, sizeof(config));
+    config.memoryBudget = (size_t)memoryMB << 20;
+    config.tempDir = tempDir;
+    config.pool = (threads > 1) ? createThreadPool(threads) : NULL;
+    config.progress = externalProgress;
+
+    Stats_t stats;
+    resetStats(&stats);
+    PerfCounters perf; // the I/O threads are not counted (they spend their time in the kernel)
+    perfOpen(&perf, config.pool);
+    double start = nowSeconds();
+    perfEnable(&perf);
+    int status = external_sort_file(input, output, &config, &stats);
+    perfDisable(&perf);
+    stats.executionTime = nowSeconds() - start;
+    perfRead(&perf, &stats);
+    perfClose(&perf);
+    freeThreadPool(config.pool);
+    if (status != 0) return EXIT_FAILURE;
+
+    if (json) {
+        printf("[\n  {\"algorithm\": \"external\", \"threads\": %d, \"memory_mb\": %lld, \"seconds\": %.6f, "
+               "\"comparisons\": %lld, \"memory_accesses\": %lld, \"aux_peak_bytes\": %lld, \"aux_allocations\": %lld",
+               threads, memoryMB, stats.executionTime, stats.comparisons, stats.memoryAccesses,
+               stats.auxPeakBytes, stats.auxAllocations);
+        printCounters(&stats, json);
+        printf("}\n]\n");
+    } else {
+        printf("algorithm,threads,memory_mb,seconds,comparisons,memory_accesses,aux_peak_bytes,aux_allocations");
+        printCounterHeader();
+        printf("\nexternal,%d,%lld,%.6f,%lld,%lld,%lld,%lld", threads, memoryMB, stats.executionTime,
+               stats.comparisons, stats.memoryAccesses, stats.auxPeakBytes, stats.auxAllocations);
+        printCounters(&stats, json);
+        printf("\n");
+    }
+    return EXIT_SUCCESS;
+}
+
+// --list: the registry, one algorithm per line
+static void listAlgorithms(void) {
+    static const char* typeNames[] = { "int32", "int64", "float64", "record", "string" };
+    printf("id,name,key,stable,memory,key_types,flags\n");
+    for (int id = 1; id <= algorithmCount(); id++) {
+        const AlgorithmInfo* info = algorithmInfo(id);
+        printf("%d,%s,%c,%s,%s,", id, info->name, info->key ? info->key : '-', info->stable ? "yes" : "no",
+               algorithmMemoryName(info->memory));
+        const char* separator = "";
+        for (int t = 0; t < 5; t++) {
+            if ((info->keyTypes >> t) & 1) {
+                printf("%s%s", separator, typeNames[t]);
+                separator = "|";
+            }
+        }
+        static const char* flagNames[] = { "quadratic", "parallel", "select-nth", "select-prefix", "adversarial" };
+        separator = ",";
+        for (int f = 0; f < 5; f++) {
+            if ((info->flags >> f) & 1) {
+                printf("%s%s", separator, flagNames[f]);
+                separator = "|";
+            }
+        }
+        if (info->machine > 0) printf("%smachine", separator);
+        else if (info->flags == 0) printf(",");
+        printf("\n");
+    }
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [--algo NAME|all] [--list] [--plugin FILE.so]... [--k K|P%%]\n"
+            "          [--min N] [--max N] [--quadratic-max N] [--threads T] [--format csv|json] [--seed S]\n"
+            "          [--network auto|avx2|sse4|scalar|off] [--dist NAME[,NAME...]|all] [--dist-param P]\n"
+            "          [--counters on|off] [--raw] [--reps R] [--warmup W] [--pin CPU] [--strings paths|ids]\n"
+            "          [--baseline FILE.json] [--tolerance PCT]\n"
+            "       %s --external IN OUT [--memory MB] [--temp DIR] [--threads T]\n", prog, prog);
+}
+
+int main(int argc, char* argv[]) {
+    const char* algo = "all";
+    long long minN = 1000;
+    long long maxN = 1000000;
+    long long quadraticMax = 100000;
+    int maxThreads = poolCoreCount();
+    int json = 0;
+    uint64_t seed = (uint64_t)time(NULL);
+    int distributions[DATASET_COUNT] = { DATASET_SHUFFLED };
+    int distributionCount = 1;
+    int distributionParam = 0;
+    int reps = 5;
+    int warmup = 1;
+    int pinCpu = -1;
+    double tolerance = 0.05;
+    Baseline* baseline = NULL;
+    const char* externalIn = NULL;
+    const char* externalOut = NULL;
+    long long memoryMB = 1024;
+    const char* tempDir = NULL;
+    int raw = 0;
+    long long kCount = 0;   // --k K: rank of the selections
+    double kPercent = 1.0;  // --k P%: rank as a share of n (default 1%)
+    int list = 0;
+
+    // the registry's built-ins, then the typed variants, then the plugins
+    for (size_t v = 0; v < sizeof(typedVariants) / sizeof(typedVariants[0]); v++) {
+        if (registerAlgorithm(&typedVariants[v]) < 0) return EXIT_FAILURE;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--algo") == 0 && i + 1 < argc) {
+            algo = argv[++i];
+        } else if (strcmp(argv[i], "--min") == 0 && i + 1 < argc) {
+            minN = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+            maxN = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--quadratic-max") == 0 && i + 1 < argc) {
+            quadraticMax = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            maxThreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            json = (strcmp(argv[++i], "json") == 0);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--dist") == 0 && i + 1 < argc) {
+            distributionCount = parseDistributions(argv[++i], distributions);
+            if (distributionCount < 0) return EXIT_FAILURE;
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pin") == 0 && i + 1 < argc) {
+            pinCpu = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline = loadBaseline(argv[++i]);
+            if (baseline == NULL) return EXIT_FAILURE;
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]) / 100.0;
+        } else if (strcmp(argv[i], "--dist-param") == 0 && i + 1 < argc) {
+            distributionParam = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--external") == 0 && i + 2 < argc) {
+            externalIn = argv[++i];
+            externalOut = argv[++i];
+        } else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+            memoryMB = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--temp") == 0 && i + 1 < argc) {
+            tempDir = argv[++i];
+        } else if (strcmp(argv[i], "--k") == 0 && i + 1 < argc) {
+            const char* value = argv[++i];
+            size_t length = strlen(value);
+            int valid;
+            if (length > 0 && value[length - 1] == '%') {
+                kCount = 0;
+                kPercent = atof(value);
+                valid = kPercent > 0.0 && kPercent <= 100.0;
+            } else {
+                kCount = atoll(value);
+                valid = kCount >= 1;
+            }
+            if (!valid) {
+                fprintf(stderr, "--k takes a count (1 or more) or a percentage of n (up to 100%%).\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--plugin") == 0 && i + 1 < argc) {
+            if (loadAlgorithmPlugin(argv[++i]) < 0) return EXIT_FAILURE;
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list = 1;
+        } else if (strcmp(argv[i], "--raw") == 0) {
+            raw = 1;
+        } else if (strcmp(argv[i], "--counters") == 0 && i + 1 < argc) {
+            setPerfEnabled(strcmp(argv[++i], "off") != 0);
+        } else if (strcmp(argv[i], "--strings") == 0 && i + 1 < argc) {
+            if (setStringShape(argv[++i]) != 0) {
+                fprintf(stderr, "Unknown string keys '%s' (paths or ids).\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--network") == 0 && i + 1 < argc) {
+            if (setNetworkMode(argv[++i]) != 0) {
+                fprintf(stderr, "Unknown network '%s' or not supported by this CPU.\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (list) {
+        listAlgorithms();
+        return EXIT_SUCCESS;
+    }
+    if (strcmp(algo, "all") != 0 && findAlgorithm(algo) == 0) {
+        fprintf(stderr, "Unknown algorithm '%s' (--list gives them).\n", algo);
+        return EXIT_FAILURE;
+    }
+    if (externalIn != NULL) {
+        if (memoryMB < 1) memoryMB = 1;
+        if (maxThreads > POOL_MAX_THREADS) maxThreads = POOL_MAX_THREADS;
+        return runExternal(externalIn, externalOut, memoryMB, tempDir, maxThreads, json);
+    }
+    if (minN < 2 || maxN < minN || maxN > 100000000) {
+        fprintf(stderr, "Sizes must satisfy 2 <= min <= max <= 100000000.\n");
+        return EXIT_FAILURE;
+    }
+    if (maxThreads < 1) maxThreads = 1;
+    if (maxThreads > POOL_MAX_THREADS) maxThreads = POOL_MAX_THREADS;
+    if (reps < 1) reps = 1;
+    if (warmup < 0) warmup = 0;
+    fprintf(stderr, "Sorting network leaves: %s\n", networkModeName());
+    fprintf(stderr, "Input seed %llu, %d warmup + %d timed runs per point\n", (unsigned long long)seed, warmup, reps);
+
+    // inputs are generated on every core (same arrays whatever the thread count)
+    ThreadPool* inputPool = createThreadPool(0);
+    benchArena = createArena(0);
+    if (benchArena == NULL) {
+        fprintf(stderr, "Failed to create the scratch arena.\n");
+        return EXIT_FAILURE;
+    }
+    if (pinCpu >= 0 && poolPinThread(pthread_self(), pinCpu) != 0) {
+        fprintf(stderr, "Could not pin the bench to CPU %d, running unpinned.\n", pinCpu);
+        pinCpu = -1;
+    }
+
+    if (json) printf("[\n");
+    else {
+        printf("algorithm,distribution,threads,n,seconds,mad,p99,min,reps,exponent,comparisons,memory_accesses,"
+               "aux_peak_bytes,aux_allocations,arena_mallocs,natural_runs,gallop_hits,char_comparisons,k,raw_seconds,overhead_pct,"
+               "baseline_pct");
+        printCounterHeader();
+        printf("\n");
+    }
+
+    int first = 1;
+    int failed = 0;
+    int regressions = 0;
+    int seedWarned = 0;
+    for (int id = 1; id <= algorithmCount(); id++) {
+        const AlgorithmInfo* info = algorithmInfo(id);
+        if (strcmp(algo, "all") != 0 && strcmp(algo, info->name) != 0) continue;
+        int parallel = (info->flags & ALGO_PARALLEL) != 0;
+        int selection = (info->flags & ALGO_SELECTION) != 0;
+
+        // sequential sorts: one pass with 1 thread; parallel: 1, 2, 4, ..., maxThreads
+        for (int threads = 1; threads <= (parallel ? maxThreads : 1);
+             threads = (threads < maxThreads && threads * 2 > maxThreads) ? maxThreads : threads * 2) {
+            if (parallel) {
+                benchPool = createThreadPool(threads);
+                if (benchPool == NULL) {
+                    fprintf(stderr, "Failed to create a pool of %d threads.\n", threads);
+                    return EXIT_FAILURE;
+                }
+                if (pinCpu >= 0) poolPinWorkers(benchPool, pinCpu);
+            }
+
+            for (int d = 0; d < distributionCount; d++) {
+                int distribution = distributions[d];
+                double fitN[MAX_SIZES], fitSeconds[MAX_SIZES];
+                int fitCount = 0;
+
+                for (long long n = minN; n <= maxN; n *= 10) {
+                    if ((info->flags & ALGO_QUADRATIC) && n > quadraticMax) break;
+                    // only a shuffled input keeps a last-element pivot away from its worst case
+                    if ((info->flags & ALGO_ADVERSARIAL) && distribution != DATASET_SHUFFLED && n > quadraticMax) break;
+
+                    // same input for every algorithm at a given size
+                    benchK = (kCount > 0) ? (int)(kCount < n ? kCount : n) : (int)(n * kPercent / 100.0);
+                    if (benchK < 1) benchK = 1;
+                    int* input = createDataset((int)n, (int)n, distribution, distributionParam, seed, inputPool);
+                    Point point;
+                    if (input == NULL || measurePoint(info, input, (int)n, reps, warmup, raw, &point) != 0) {
+                        fprintf(stderr, "Failed to allocate %lld elements.\n", n);
+                        return EXIT_FAILURE;
+                    }
+                    free(input);
+                    if (point.failed) {
+                        fprintf(stderr, "%s: %s for n=%lld\n", info->name, info->failure ? info->failure : "failed", n);
+                        failed = 1;
+                    } else if (!point.sorted) {
+                        fprintf(stderr, "%s: output not %s for n=%lld\n", info->name, selection ? "selected" : "sorted", n);
+                        failed = 1;
+                    }
+
+                    // local exponent: growth since the previous size
+                    double exponent = 0.0;
+                    int hasExponent = fitCount > 0 && fitSeconds[fitCount - 1] > 0.0 && point.time.median > 0.0;
+                    if (hasExponent) exponent = log(point.time.median / fitSeconds[fitCount - 1]) / log(n / fitN[fitCount - 1]);
+                    fitN[fitCount] = (double)n;
+                    fitSeconds[fitCount] = point.time.median;
+                    fitCount++;
+
+                    const BaselineEntry* base = (baseline != NULL)
+                        ? findBaseline(baseline, info->name, datasetName(distribution), threads, n) : NULL;
+                    if (base != NULL && base->seed != 0 && base->seed != seed && !seedWarned) {
+                        fprintf(stderr, "Baseline inputs used seed %llu (this run: %llu): pass --seed %llu "
+                                "to compare the same arrays.\n", base->seed, (unsigned long long)seed, base->seed);
+                        seedWarned = 1;
+                    }
+                    if (base != NULL && isRegression(&point.time, base, tolerance)) {
+                        fprintf(stderr, "REGRESSION %s %s threads=%d n=%lld: %.6f s -> %.6f s (%+.1f%%)\n",
+                                info->name, datasetName(distribution), threads, n, base->median,
+                                point.time.median, changePercent(point.time.median, base->median));
+                        regressions++;
+                    }
+
+                    printPoint(json, first, info->name, datasetName(distribution), threads, n,
+                               selection ? benchK : 0, seed, &point, hasExponent ? &exponent : NULL, base);
+                    first = 0;
+                    fflush(stdout);
+                }
+                if (fitCount >= 2) {
+                    fprintf(stderr, "Scaling %s %s threads=%d: time ~ n^%.2f over %d sizes\n", info->name,
+                            datasetName(distribution), threads, fitExponent(fitN, fitSeconds, fitCount), fitCount);
+                }
+            }
+
+            freeThreadPool(benchPool);
+            benchPool = NULL;
+        }
+    }
+    if (json) printf("\n]\n");
+    freeThreadPool(inputPool);
+    freeArena(benchArena);
+    freeBaseline(baseline);
+
+    if (failed) return EXIT_FAILURE;
+    if (regressions > 0) {
+        fprintf(stderr, "%d point(s) slower than the baseline.\n", regressions);
+        return EXIT_REGRESSION;
+    }
+    return EXIT_SUCCESS;
+}
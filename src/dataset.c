@@ -0,0 +1,331 @@
+#include "dataset.h"
+#include "rng.h"
+#include <math.h>   // For pow (Zipf weights)
+#include <stdlib.h> // For malloc()
+#include <string.h> // For strcmp
+
+#define CHUNK_MIN (1 << 16) // elements per chunk (more for huge arrays, see chunkLength)
+#define CHUNK_MAX_COUNT 2048
+#define ZIPF_MAX_RANKS (1 << 20) // distinct Zipf values kept in the table
+
+// Random streams of one seed, one per use (and per chunk / bucket inside a use)
+#define STREAM_VALUES   0ull
+#define STREAM_BUCKETS  (1ull << 40)
+#define STREAM_SHUFFLE  (2ull << 40)
+#define STREAM_SWAPS    (3ull << 40)
+
+static const char* names[DATASET_COUNT] = {
+    "shuffled", "sorted", "reversed", "nearly-sorted", "few-unique",
+    "organ-pipe", "sawtooth", "zipf", "all-equal",
+};
+
+// Everything the chunk functions need
+typedef struct {
+    int* tab;
+    int* buffer; // shuffle: destination of the bucket scatter
+    int size;
+    int maxValue;
+    int distribution;
+    int param;
+    uint64_t seed;
+    int chunk;      // elements per chunk
+    int chunkCount;
+    uint32_t* counts;  // shuffle: chunkCount * chunkCount bucket counts (then offsets)
+    size_t* bucketStart; // shuffle: chunkCount + 1
+    double* zipfCdf;
+    int zipfRanks;
+} Dataset;
+
+typedef void (*ChunkFn)(Dataset* data, int chunk);
+
+// Slice of chunks run by one pool task
+typedef struct {
+    Dataset* data;
+    ChunkFn fn;
+    int first;
+    int last; // exclusive
+} ChunkTask;
+
+typedef struct {
+    ThreadPool* pool;
+    ChunkTask* tasks;
+    int taskCount;
+} ChunkJob;
+
+/*
+----------------------------------------------------
+ CHUNK SCHEDULING
+----------------------------------------------------
+*/
+static int chunkLength(int size) {
+    int chunk = CHUNK_MIN;
+    while ((size + (long long)chunk - 1) / chunk > CHUNK_MAX_COUNT) chunk *= 2;
+    return chunk;
+}
+
+static void chunkTask(void* arg) {
+    ChunkTask* task = (ChunkTask*)arg;
+    for (int c = task->first; c < task->last; c++) task->fn(task->data, c);
+}
+
+static void chunkRoot(void* arg) {
+    ChunkJob* job = (ChunkJob*)arg;
+    TaskGroup group;
+    atomic_init(&group.pending, 0);
+    for (int t = 1; t < job->taskCount; t++) poolSpawn(job->pool, &group, chunkTask, &job->tasks[t]);
+    chunkTask(&job->tasks[0]);
+    poolWait(job->pool, &group);
+}
+
+// Runs fn on chunks [0, count): spread over the pool when there is one.
+static void forEachChunk(Dataset* data, ThreadPool* pool, ChunkFn fn, int count) {
+    int taskCount = (pool != NULL) ? pool->threadCount * 4 : 1;
+    if (taskCount > count) taskCount = count;
+
+    ChunkTask local;
+    ChunkTask* tasks = (taskCount > 1) ? (ChunkTask*)malloc(taskCount * sizeof(ChunkTask)) : NULL;
+    if (tasks == NULL) { // sequential (or no memory for the task list)
+        local.data = data;
+        local.fn = fn;
+        local.first = 0;
+        local.last = count;
+        chunkTask(&local);
+        return;
+    }
+    for (int t = 0; t < taskCount; t++) {
+        tasks[t].data = data;
+        tasks[t].fn = fn;
+        tasks[t].first = (int)((long long)count * t / taskCount);
+        tasks[t].last = (int)((long long)count * (t + 1) / taskCount);
+    }
+    ChunkJob job = { pool, tasks, taskCount };
+    poolRun(pool, chunkRoot, &job);
+    free(tasks);
+}
+
+/*
+----------------------------------------------------
+ VALUES
+----------------------------------------------------
+*/
+// Ramp from 1 to maxValue over 'length' positions
+// (after sorting a shuffled ramp the bars form a perfect line)
+static inline int ramp(long long i, long long length, int maxValue) {
+    if (length < 2) return maxValue;
+    return (int)(i * (maxValue - 1) / (length - 1)) + 1; // integer: a ramp of n values over n is 1..n exactly
+}
+
+// Rank of a uniform draw in the Zipf table (first rank whose CDF exceeds it)
+static int zipfRank(const Dataset* data, double u) {
+    int low = 0, high = data->zipfRanks - 1;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (data->zipfCdf[mid] > u) high = mid;
+        else low = mid + 1;
+    }
+    return low + 1;
+}
+
+static void fillChunk(Dataset* data, int chunk) {
+    int low = chunk * data->chunk;
+    int high = (low + data->chunk < data->size) ? low + data->chunk : data->size;
+    int size = data->size, maxValue = data->maxValue;
+    int* tab = data->tab;
+    Rng rng;
+    rngSeed(&rng, data->seed, STREAM_VALUES + (uint64_t)chunk);
+
+    switch (data->distribution) {
+        case DATASET_REVERSED:
+            for (int i = low; i < high; i++) tab[i] = ramp(size - 1 - i, size, maxValue);
+            break;
+        case DATASET_FEW_UNIQUE: {
+            int distinct = data->param;
+            for (int i = low; i < high; i++) tab[i] = ramp(rngBounded(&rng, (uint32_t)distinct), distinct, maxValue);
+            break;
+        }
+        case DATASET_ORGAN_PIPE: {
+            int half = (size + 1) / 2;
+            for (int i = low; i < high; i++) tab[i] = ramp(i < half ? i : size - 1 - i, half, maxValue);
+            break;
+        }
+        case DATASET_SAWTOOTH: {
+            int tooth = (size + data->param - 1) / data->param;
+            for (int i = low; i < high; i++) tab[i] = ramp(i % tooth, tooth, maxValue);
+            break;
+        }
+        case DATASET_ZIPF:
+            for (int i = low; i < high; i++) tab[i] = zipfRank(data, rngDouble(&rng));
+            break;
+        case DATASET_ALL_EQUAL:
+            for (int i = low; i < high; i++) tab[i] = (maxValue + 1) / 2;
+            break;
+        default: // sorted, nearly sorted and shuffled start from the ramp
+            for (int i = low; i < high; i++) tab[i] = ramp(i, size, maxValue);
+            break;
+    }
+}
+
+/*
+----------------------------------------------------
+ PARALLEL SHUFFLE
+----------------------------------------------------
+ Every element is sent to a random bucket (one bucket per chunk), then each
+ bucket is shuffled by Fisher-Yates. A uniform choice of bucket followed
+ by a uniform permutation inside each bucket gives a uniform permutation
+ of the whole array. The bucket draws of a chunk come from its own stream,
+ drawn once to count and again to scatter.
+----------------------------------------------------
+*/
+static void countBuckets(Dataset* data, int chunk) {
+    int low = chunk * data->chunk;
+    int high = (low + data->chunk < data->size) ? low + data->chunk : data->size;
+    uint32_t* counts = data->counts + (size_t)chunk * data->chunkCount;
+    Rng rng;
+    rngSeed(&rng, data->seed, STREAM_BUCKETS + (uint64_t)chunk);
+    for (int i = low; i < high; i++) counts[rngBounded(&rng, (uint32_t)data->chunkCount)]++;
+}
+
+static void scatterBuckets(Dataset* data, int chunk) {
+    int low = chunk * data->chunk;
+    int high = (low + data->chunk < data->size) ? low + data->chunk : data->size;
+    uint32_t* offsets = data->counts + (size_t)chunk * data->chunkCount;
+    Rng rng;
+    rngSeed(&rng, data->seed, STREAM_BUCKETS + (uint64_t)chunk);
+    for (int i = low; i < high; i++) {
+        data->buffer[offsets[rngBounded(&rng, (uint32_t)data->chunkCount)]++] = data->tab[i];
+    }
+}
+
+static void shuffleBucket(Dataset* data, int bucket) {
+    int* start = data->buffer + data->bucketStart[bucket];
+    size_t length = data->bucketStart[bucket + 1] - data->bucketStart[bucket];
+    Rng rng;
+    rngSeed(&rng, data->seed, STREAM_SHUFFLE + (uint64_t)bucket);
+    for (size_t i = length; i > 1; i--) {
+        size_t j = rngBounded(&rng, (uint32_t)i);
+        int tmp = start[i - 1];
+        start[i - 1] = start[j];
+        start[j] = tmp;
+    }
+}
+
+// Shuffles data->tab; the result ends up in data->tab (a new block).
+static int shuffle(Dataset* data, ThreadPool* pool) {
+    int buckets = data->chunkCount;
+    data->buffer = (int*)malloc((size_t)data->size * sizeof(int));
+    data->counts = (uint32_t*)calloc((size_t)buckets * buckets, sizeof(uint32_t));
+    data->bucketStart = (size_t*)malloc((buckets + 1) * sizeof(size_t));
+    if (data->buffer == NULL || data->counts == NULL || data->bucketStart == NULL) {
+        free(data->buffer);
+        free(data->counts);
+        free(data->bucketStart);
+        return -1;
+    }
+
+    forEachChunk(data, pool, countBuckets, data->chunkCount);
+
+    // counts -> first slot of each (chunk, bucket) in the buffer, bucket by bucket
+    size_t sum = 0;
+    for (int b = 0; b < buckets; b++) {
+        data->bucketStart[b] = sum;
+        for (int c = 0; c < data->chunkCount; c++) {
+            uint32_t* slot = &data->counts[(size_t)c * buckets + b];
+            uint32_t count = *slot;
+            *slot = (uint32_t)sum;
+            sum += count;
+        }
+    }
+    data->bucketStart[buckets] = sum;
+
+    forEachChunk(data, pool, scatterBuckets, data->chunkCount);
+    forEachChunk(data, pool, shuffleBucket, buckets);
+
+    free(data->tab);
+    data->tab = data->buffer;
+    free(data->counts);
+    free(data->bucketStart);
+    return 0;
+}
+
+/*
+----------------------------------------------------
+ ENTRY POINTS
+----------------------------------------------------
+*/
+int* createDataset(int size, int maxValue, int distribution, int param, uint64_t seed, ThreadPool* pool) {
+    if (size < 1) size = 1;
+    if (maxValue < 1) maxValue = 1;
+
+    Dataset data;
+    memset(&data, 0, sizeof(data));
+    data.size = size;
+    data.maxValue = maxValue;
+    data.distribution = distribution;
+    data.seed = seed;
+    data.chunk = chunkLength(size);
+    data.chunkCount = (int)((size + (long long)data.chunk - 1) / data.chunk);
+
+    // defaults of the shapes that take a parameter
+    if (param <= 0) {
+        if (distribution == DATASET_NEARLY_SORTED) param = size / 100 > 0 ? size / 100 : 1;
+        else if (distribution == DATASET_ZIPF) param = 100;
+        else param = 8;
+    }
+    data.param = param;
+
+    data.tab = (int*)malloc((size_t)size * sizeof(int));
+    if (data.tab == NULL) return NULL;
+
+    if (distribution == DATASET_ZIPF) {
+        // cumulative weights of ranks 1 .. m, normalized to 1
+        data.zipfRanks = maxValue < ZIPF_MAX_RANKS ? maxValue : ZIPF_MAX_RANKS;
+        data.zipfCdf = (double*)malloc(data.zipfRanks * sizeof(double));
+        if (data.zipfCdf == NULL) {
+            free(data.tab);
+            return NULL;
+        }
+        double s = param / 100.0, sum = 0.0;
+        for (int k = 0; k < data.zipfRanks; k++) {
+            sum += 1.0 / pow(k + 1, s);
+            data.zipfCdf[k] = sum;
+        }
+        for (int k = 0; k < data.zipfRanks; k++) data.zipfCdf[k] /= sum;
+    }
+
+    forEachChunk(&data, pool, fillChunk, data.chunkCount);
+    free(data.zipfCdf);
+
+    if (distribution == DATASET_SHUFFLED && shuffle(&data, pool) != 0) {
+        free(data.tab);
+        return NULL;
+    }
+    if (distribution == DATASET_NEARLY_SORTED) {
+        // a few random swaps: sequential, there are few of them
+        Rng rng;
+        rngSeed(&rng, seed, STREAM_SWAPS);
+        for (int k = 0; k < param; k++) {
+            uint32_t i = rngBounded(&rng, (uint32_t)size);
+            uint32_t j = rngBounded(&rng, (uint32_t)size);
+            int tmp = data.tab[i];
+            data.tab[i] = data.tab[j];
+            data.tab[j] = tmp;
+        }
+    }
+    return data.tab;
+}
+
+int* createRandomArray(int size, int maxValue, uint64_t seed) {
+    return createDataset(size, maxValue, DATASET_SHUFFLED, 0, seed, NULL);
+}
+
+const char* datasetName(int distribution) {
+    if (distribution < 0 || distribution >= DATASET_COUNT) return "unknown";
+    return names[distribution];
+}
+
+int datasetFromName(const char* name) {
+    for (int d = 0; d < DATASET_COUNT; d++) {
+        if (strcmp(name, names[d]) == 0) return d;
+    }
+    return -1;
+}
@@ -0,0 +1,623 @@
+#include "external.h"
+#include "introsort.h"
+#include "parallel.h"
+#include <errno.h>
+#include <fcntl.h>    // For open
+#include <pthread.h>
+#include <stdint.h>   // For INT64_MAX (exhausted runs)
+#include <stdio.h>    // For error messages
+#include <stdlib.h>   // For malloc/free
+#include <string.h>   // For memset and strerror
+#include <sys/stat.h> // For fstat
+#include <unistd.h>   // For pread, pwrite, unlink
+
+#define IO_BLOCK_MIN (1 << 20)   // bytes: smallest merge buffer worth a disk request
+#define MAX_FAN_IN 1024          // runs merged at once
+#define RUN_CUTOFF 4096          // parallel sort: ranges sorted by one worker
+#define KEY_DONE INT64_MAX       // key of an exhausted run (loses every match)
+
+/*
+----------------------------------------------------
+ I/O THREAD
+----------------------------------------------------
+ Executes read/write requests in submission order on its own thread.
+ The caller submits, goes on with its work, and waits only when it needs
+ the buffer back.
+----------------------------------------------------
+*/
+typedef struct IoRequest {
+    int fd;
+    int write;      // 0: read, 1: write
+    void* buffer;
+    size_t bytes;
+    off_t offset;
+    ssize_t result; // bytes done, -1 on error
+    int done;
+    struct IoRequest* next;
+} IoRequest;
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;     // new request or shutdown
+    pthread_cond_t finished; // a request is done
+    IoRequest* head;
+    IoRequest* tail;
+    int shutdown;
+} IoThread;
+
+// Whole transfer (pread/pwrite may stop early). Returns bytes done, -1 on error.
+static ssize_t transfer(IoRequest* request) {
+    size_t total = 0;
+    while (total < request->bytes) {
+        char* at = (char*)request->buffer + total;
+        ssize_t n = request->write
+            ? pwrite(request->fd, at, request->bytes - total, request->offset + (off_t)total)
+            : pread(request->fd, at, request->bytes - total, request->offset + (off_t)total);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) break; // end of file
+        total += (size_t)n;
+    }
+    return (ssize_t)total;
+}
+
+static void* ioThreadMain(void* data) {
+    IoThread* io = (IoThread*)data;
+    pthread_mutex_lock(&io->lock);
+    while (1) {
+        while (io->head == NULL && !io->shutdown) pthread_cond_wait(&io->wake, &io->lock);
+        if (io->head == NULL) break; // shutdown with nothing queued
+
+        IoRequest* request = io->head;
+        pthread_mutex_unlock(&io->lock);
+        ssize_t result = transfer(request);
+        pthread_mutex_lock(&io->lock);
+
+        io->head = request->next;
+        if (io->head == NULL) io->tail = NULL;
+        request->result = result;
+        request->done = 1;
+        pthread_cond_broadcast(&io->finished);
+    }
+    pthread_mutex_unlock(&io->lock);
+    return NULL;
+}
+
+static int ioStart(IoThread* io) {
+    memset(io, 0, sizeof(IoThread));
+    pthread_mutex_init(&io->lock, NULL);
+    pthread_cond_init(&io->wake, NULL);
+    pthread_cond_init(&io->finished, NULL);
+    return pthread_create(&io->thread, NULL, ioThreadMain, io) == 0 ? 0 : -1;
+}
+
+static void ioStop(IoThread* io) {
+    pthread_mutex_lock(&io->lock);
+    io->shutdown = 1;
+    pthread_cond_signal(&io->wake);
+    pthread_mutex_unlock(&io->lock);
+    pthread_join(io->thread, NULL);
+    pthread_mutex_destroy(&io->lock);
+    pthread_cond_destroy(&io->wake);
+    pthread_cond_destroy(&io->finished);
+}
+
+static void ioSubmit(IoThread* io, IoRequest* request, int fd, int write, void* buffer, size_t bytes, off_t offset) {
+    request->fd = fd;
+    request->write = write;
+    request->buffer = buffer;
+    request->bytes = bytes;
+    request->offset = offset;
+    request->result = 0;
+    request->done = 0;
+    request->next = NULL;
+
+    pthread_mutex_lock(&io->lock);
+    if (io->tail != NULL) io->tail->next = request;
+    else io->head = request;
+    io->tail = request;
+    pthread_cond_signal(&io->wake);
+    pthread_mutex_unlock(&io->lock);
+}
+
+// Waits for 'request' (already done or never submitted: returns at once).
+// return the bytes transferred, -1 on error.
+static ssize_t ioWait(IoThread* io, IoRequest* request) {
+    pthread_mutex_lock(&io->lock);
+    while (!request->done) pthread_cond_wait(&io->finished, &io->lock);
+    pthread_mutex_unlock(&io->lock);
+    return request->result;
+}
+
+/*
+----------------------------------------------------
+ LOSER TREE
+----------------------------------------------------
+ tree[1 .. k-1] hold the loser of each match, tree[0] the overall winner.
+ After the winner's source advances, only the matches on its path to the
+ root are replayed: log2(k) comparisons per element.
+----------------------------------------------------
+*/
+typedef struct {
+    int k;
+    int* tree;
+    int64_t* keys; // k + 1 keys: keys[k] is the -infinity used to build the tree
+} LoserTree;
+
+// Called after a match between sources a and b (may be NULL).
+typedef void (*MatchFn)(void* context, int a, int b);
+
+static int createLoserTree(LoserTree* lt, int k, Arena* arena, Stats_t* stats) {
+    lt->k = k;
+    lt->tree = (int*)arenaAlloc(arena, k * sizeof(int), stats);
+    lt->keys = (int64_t*)arenaAlloc(arena, (k + 1) * sizeof(int64_t), stats);
+    if (lt->tree == NULL || lt->keys == NULL) {
+        arenaFree(arena, lt->tree, k * sizeof(int), stats);
+        arenaFree(arena, lt->keys, (k + 1) * sizeof(int64_t), stats);
+        return -1;
+    }
+    return 0;
+}
+
+static void freeLoserTree(LoserTree* lt, Arena* arena, Stats_t* stats) {
+    arenaFree(arena, lt->tree, lt->k * sizeof(int), stats);
+    arenaFree(arena, lt->keys, (lt->k + 1) * sizeof(int64_t), stats);
+}
+
+// Replays the matches from leaf 's' up to the root.
+static void ltAdjust(LoserTree* lt, int s, Stats_t* stats, MatchFn onMatch, void* context) {
+    for (int t = (s + lt->k) / 2; t > 0; t /= 2) {
+        int other = lt->tree[t];
+        if (other == lt->k || s == lt->k) { // virtual -infinity leaf wins for free (only while building)
+            if (s != lt->k) {
+                lt->tree[t] = s;
+                s = lt->k;
+            }
+            continue;
+        }
+        stats->comparisons++;
+        if (onMatch != NULL) onMatch(context, s, other);
+        // ties go to the lower source: the merge keeps run order
+        if (lt->keys[s] > lt->keys[other] || (lt->keys[s] == lt->keys[other] && s > other)) {
+            lt->tree[t] = s;
+            s = other;
+        }
+    }
+    lt->tree[0] = s;
+}
+
+// keys[0 .. k) must hold the first key of every source.
+static void ltBuild(LoserTree* lt, Stats_t* stats, MatchFn onMatch, void* context) {
+    lt->keys[lt->k] = INT64_MIN;
+    for (int t = 0; t < lt->k; t++) lt->tree[t] = lt->k;
+    for (int s = lt->k - 1; s >= 0; s--) ltAdjust(lt, s, stats, onMatch, context);
+}
+
+/*
+----------------------------------------------------
+ ARRAY VERSION (window)
+----------------------------------------------------
+*/
+// Ops of a sort running on tab + offset, shifted to positions in tab.
+typedef struct {
+    OpSink* target;
+    int offset;
+} OffsetSink;
+
+static void pushShifted(void* context, TraceOp op) {
+    OffsetSink* shifted = (OffsetSink*)context;
+    uint32_t type = op.head >> TRACE_TYPE_SHIFT;
+    op.head += (uint32_t)shifted->offset;
+    // arg is an index too, except for writes (a value) and reads (unused); owners keep it in the low bits
+    if (type != TRACE_WRITE && type != TRACE_READ) op.arg += (uint32_t)shifted->offset;
+    shifted->target->push(shifted->target->context, op);
+}
+
+typedef struct {
+    int* position; // next element of each run
+    int* end;
+    OpSink* sink;
+} ArrayMerge;
+
+static void showMatch(void* context, int a, int b) {
+    ArrayMerge* merge = (ArrayMerge*)context;
+    if (merge->position[a] >= merge->end[a] || merge->position[b] >= merge->end[b]) return; // exhausted run
+    merge->sink->push(merge->sink->context, makeTraceOp(TRACE_COMPARE, merge->position[a], merge->position[b]));
+}
+
+int external_sort(int* tab, int size, int runSize, Stats_t* stats, Arena* arena, OpSink* sink) {
+    if (size < 2) return 0;
+    if (runSize < 2) runSize = 2;
+    int runCount = (size + runSize - 1) / runSize;
+
+    // 1. run formation
+    for (int r = 0; r < runCount; r++) {
+        int low = r * runSize;
+        int length = (low + runSize <= size) ? runSize : size - low;
+        if (sink != NULL) {
+            OffsetSink shifted = { sink, low };
+            OpSink runSink = { pushShifted, &shifted };
+            intro_sort(tab + low, length, stats, &runSink);
+            sink->push(sink->context, makeOwnerOp(low, low + length - 1, r));
+        } else {
+            intro_sort(tab + low, length, stats, NULL);
+        }
+    }
+    if (runCount == 1) return 0;
+
+    // 2. one k-way merge into a buffer; the window sees the output overwrite the input
+    int* output = (int*)arenaAlloc(arena, size * sizeof(int), stats);
+    int* position = (int*)arenaAlloc(arena, 2 * runCount * sizeof(int), stats);
+    LoserTree lt;
+    if (output == NULL || position == NULL || createLoserTree(&lt, runCount, arena, stats) != 0) {
+        arenaFree(arena, output, size * sizeof(int), stats);
+        arenaFree(arena, position, 2 * runCount * sizeof(int), stats);
+        return -1;
+    }
+    int* end = position + runCount;
+    for (int r = 0; r < runCount; r++) {
+        position[r] = r * runSize;
+        end[r] = (position[r] + runSize <= size) ? position[r] + runSize : size;
+        lt.keys[r] = tab[position[r]];
+    }
+    stats->memoryAccesses += runCount;
+
+    ArrayMerge merge = { position, end, sink };
+    MatchFn onMatch = (sink != NULL) ? showMatch : NULL;
+    ltBuild(&lt, stats, onMatch, &merge);
+
+    for (int out = 0; out < size; out++) {
+        int winner = lt.tree[0];
+        output[out] = (int)lt.keys[winner];
+        if (sink != NULL) sink->push(sink->context, makeTraceOp(TRACE_WRITE, out, output[out]));
+
+        position[winner]++;
+        lt.keys[winner] = (position[winner] < end[winner]) ? tab[position[winner]] : KEY_DONE;
+        ltAdjust(&lt, winner, stats, onMatch, &merge);
+    }
+    stats->memoryAccesses += 2LL * size; // read + write of every element
+
+    memcpy(tab, output, size * sizeof(int));
+    freeLoserTree(&lt, arena, stats);
+    arenaFree(arena, output, size * sizeof(int), stats);
+    arenaFree(arena, position, 2 * runCount * sizeof(int), stats);
+    return 0;
+}
+
+/*
+----------------------------------------------------
+ FILE VERSION
+----------------------------------------------------
+*/
+// One run file being merged: two buffers, one consumed while the other fills.
+typedef struct {
+    int fd;
+    off_t offset;      // next byte to request
+    long long left;    // elements not yet requested
+    int* buffer[2];
+    IoRequest request[2];
+    int current;       // buffer being consumed
+    int position;
+    int count;         // elements in the current buffer
+} RunReader;
+
+typedef struct {
+    char** paths;
+    long long* lengths; // elements per run
+    int count;
+    int capacity;
+} RunList;
+
+static void progress(const ExternalConfig* config, const char* phase, long long done, long long total) {
+    if (config->progress != NULL) config->progress(config->progressContext, phase, done, total);
+}
+
+// Creates a new empty run file and records it. return its fd, -1 on error.
+static int newRun(RunList* runs, const char* dir, long long length) {
+    static int serial = 0;
+    if (runs->count == runs->capacity) {
+        int capacity = runs->capacity ? runs->capacity * 2 : 64;
+        char** paths = (char**)realloc(runs->paths, capacity * sizeof(char*));
+        if (paths == NULL) return -1;
+        runs->paths = paths;
+        long long* lengths = (long long*)realloc(runs->lengths, capacity * sizeof(long long));
+        if (lengths == NULL) return -1;
+        runs->lengths = lengths;
+        runs->capacity = capacity;
+    }
+    char* path = (char*)malloc(strlen(dir) + 64);
+    if (path == NULL) return -1;
+    sprintf(path, "%s/sortrun-%d-%d.bin", dir, (int)getpid(), serial++);
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "External sort: cannot create %s: %s\n", path, strerror(errno));
+        free(path);
+        return -1;
+    }
+    runs->paths[runs->count] = path;
+    runs->lengths[runs->count] = length;
+    runs->count++;
+    return fd;
+}
+
+static void removeRuns(RunList* runs, int from, int to) {
+    for (int r = from; r < to; r++) {
+        unlink(runs->paths[r]);
+        free(runs->paths[r]);
+        runs->paths[r] = NULL;
+    }
+}
+
+// Sorts one chunk in memory. Files often hold few distinct keys, so both
+// kernels must stay O(n log n) on duplicates: Hoare partitions, which stop
+// on keys equal to the pivot, and a bounded recursion depth.
+static void sortChunk(int* chunk, int count, const ExternalConfig* config, Stats_t* stats) {
+    if (config->pool != NULL) parallel_quick_sort(chunk, count, stats, config->pool, RUN_CUTOFF, NULL);
+    else intro_sort(chunk, count, stats, NULL);
+}
+
+// Phase 1: chunk c goes through buffer c % 3, so chunk c+1 is read and
+// chunk c-1 written while chunk c is sorted.
+static int formRuns(int input, long long total, const ExternalConfig* config, IoThread* reader, IoThread* writer,
+                    RunList* runs, Stats_t* stats) {
+    long long chunkElements = (long long)(config->memoryBudget / 3 / sizeof(int));
+    if (chunkElements > (1 << 30)) chunkElements = 1 << 30; // int sizes for the in-memory sort
+    if (chunkElements < 1024) chunkElements = 1024;
+    long long chunkCount = (total + chunkElements - 1) / chunkElements;
+    const char* dir = config->tempDir ? config->tempDir : ".";
+
+    int* buffers[3] = { NULL, NULL, NULL };
+    IoRequest reads[3], writes[3];
+    int runFds[3] = { -1, -1, -1 };
+    memset(reads, 0, sizeof(reads));
+    memset(writes, 0, sizeof(writes));
+    for (int b = 0; b < 3; b++) {
+        reads[b].done = writes[b].done = 1;
+        buffers[b] = (int*)arenaAlloc(NULL, chunkElements * sizeof(int), stats);
+        if (buffers[b] == NULL) {
+            for (int f = 0; f < b; f++) arenaFree(NULL, buffers[f], chunkElements * sizeof(int), stats);
+            fprintf(stderr, "External sort: not enough memory for the run buffers.\n");
+            return -1;
+        }
+    }
+
+    int status = 0;
+    long long elements0 = total < chunkElements ? total : chunkElements;
+    ioSubmit(reader, &reads[0], input, 0, buffers[0], (size_t)elements0 * sizeof(int), 0);
+
+    for (long long c = 0; c < chunkCount && status == 0; c++) {
+        int b = (int)(c % 3);
+        long long first = c * chunkElements;
+        long long count = (total - first < chunkElements) ? total - first : chunkElements;
+        if (ioWait(reader, &reads[b]) != (ssize_t)(count * sizeof(int))) {
+            fprintf(stderr, "External sort: read error on the input.\n");
+            status = -1;
+            break;
+        }
+
+        // prefetch the next chunk into the buffer written two chunks ago
+        if (c + 1 < chunkCount) {
+            int nb = (int)((c + 1) % 3);
+            if (ioWait(writer, &writes[nb]) < 0) { status = -1; break; }
+            if (runFds[nb] >= 0) { close(runFds[nb]); runFds[nb] = -1; }
+            long long nextFirst = first + count;
+            long long nextCount = (total - nextFirst < chunkElements) ? total - nextFirst : chunkElements;
+            ioSubmit(reader, &reads[nb], input, 0, buffers[nb], (size_t)nextCount * sizeof(int),
+                     (off_t)(nextFirst * sizeof(int)));
+        }
+
+        sortChunk(buffers[b], (int)count, config, stats);
+
+        runFds[b] = newRun(runs, dir, count);
+        if (runFds[b] < 0) { status = -1; break; }
+        ioSubmit(writer, &writes[b], runFds[b], 1, buffers[b], (size_t)count * sizeof(int), 0);
+        progress(config, "runs", first + count, total);
+    }
+
+    // let every request finish before the buffers go away
+    for (int b = 0; b < 3; b++) {
+        ioWait(reader, &reads[b]);
+        if (ioWait(writer, &writes[b]) < 0) status = -1;
+        if (runFds[b] >= 0) close(runFds[b]);
+        arenaFree(NULL, buffers[b], chunkElements * sizeof(int), stats);
+    }
+    if (status != 0) fprintf(stderr, "External sort: failed while writing the runs.\n");
+    return status;
+}
+
+// Asks for the next block of 'run' into buffer 'which'.
+static void requestBlock(IoThread* reader, RunReader* run, int which, int blockElements) {
+    long long count = run->left < blockElements ? run->left : blockElements;
+    run->left -= count;
+    ioSubmit(reader, &run->request[which], run->fd, 0, run->buffer[which], (size_t)count * sizeof(int), run->offset);
+    run->offset += (off_t)(count * sizeof(int));
+}
+
+// Switches 'run' to its other buffer. return 0 at the end of the run, -1 on error.
+static int nextBlock(IoThread* reader, RunReader* run, int blockElements) {
+    int other = 1 - run->current;
+    ssize_t bytes = ioWait(reader, &run->request[other]);
+    if (bytes < 0) return -1;
+    run->count = (int)(bytes / (ssize_t)sizeof(int));
+    run->position = 0;
+    if (run->left > 0) requestBlock(reader, run, run->current, blockElements); // refill the drained one
+    else run->request[run->current].result = 0; // nothing left: reads as an empty block
+    run->current = other;
+    return run->count > 0;
+}
+
+// Phase 2: merges runs [first, first + k) into 'outFd'.
+static int mergeRuns(RunList* runs, int first, int k, int outFd, long long total, int blockElements, const ExternalConfig* config, IoThread* reader, IoThread* writer,
+                     Stats_t* stats) {
+    size_t memoryBytes = (size_t)(2 * k + 2) * blockElements * sizeof(int);
+    RunReader* readers = (RunReader*)calloc(k, sizeof(RunReader));
+    int* memory = (int*)arenaAlloc(NULL, memoryBytes, stats);
+    LoserTree lt;
+    if (readers == NULL || memory == NULL || createLoserTree(&lt, k, NULL, stats) != 0) {
+        free(readers);
+        arenaFree(NULL, memory, memoryBytes, stats);
+        fprintf(stderr, "External sort: not enough memory for the merge buffers.\n");
+        return -1;
+    }
+
+    int status = 0;
+    int opened = 0;
+    for (int r = 0; r < k; r++) {
+        RunReader* run = &readers[r];
+        run->fd = open(runs->paths[first + r], O_RDONLY);
+        if (run->fd < 0) { status = -1; break; }
+        opened++;
+        run->left = runs->lengths[first + r];
+        run->buffer[0] = memory + (size_t)(2 * r) * blockElements;
+        run->buffer[1] = run->buffer[0] + blockElements;
+        run->request[0].done = run->request[1].done = 1;
+        run->current = 1;
+        requestBlock(reader, run, 0, blockElements);
+        if (run->left > 0) requestBlock(reader, run, 1, blockElements);
+    }
+    for (int r = 0; r < k && status == 0; r++) {
+        // first block: swap onto buffer 0, the second one stays in flight
+        RunReader* run = &readers[r];
+        ssize_t bytes = ioWait(reader, &run->request[0]);
+        if (bytes < 0) { status = -1; break; }
+        run->current = 0;
+        run->count = (int)(bytes / (ssize_t)sizeof(int));
+        run->position = 0;
+        lt.keys[r] = run->count > 0 ? run->buffer[0][0] : KEY_DONE;
+    }
+
+    int* out[2] = { memory + (size_t)(2 * k) * blockElements, memory + (size_t)(2 * k + 1) * blockElements };
+    IoRequest writes[2];
+    memset(writes, 0, sizeof(writes));
+    writes[0].done = writes[1].done = 1;
+    int outCurrent = 0, outCount = 0;
+    off_t outOffset = 0;
+    long long merged = 0;
+
+    if (status == 0) ltBuild(&lt, stats, NULL, NULL);
+    while (status == 0 && lt.keys[lt.tree[0]] != KEY_DONE) {
+        int winner = lt.tree[0];
+        out[outCurrent][outCount++] = (int)lt.keys[winner];
+
+        RunReader* run = &readers[winner];
+        run->position++;
+        if (run->position == run->count) {
+            int more = nextBlock(reader, run, blockElements);
+            if (more < 0) { status = -1; break; }
+            lt.keys[winner] = more ? run->buffer[run->current][0] : KEY_DONE;
+        } else {
+            lt.keys[winner] = run->buffer[run->current][run->position];
+        }
+        ltAdjust(&lt, winner, stats, NULL, NULL);
+
+        if (outCount == blockElements) {
+            // hand the full buffer to the writer, continue in the other one
+            if (ioWait(writer, &writes[1 - outCurrent]) < 0) { status = -1; break; }
+            ioSubmit(writer, &writes[outCurrent], outFd, 1, out[outCurrent], (size_t)outCount * sizeof(int), outOffset);
+            outOffset += (off_t)(outCount * sizeof(int));
+            merged += outCount;
+            outCurrent = 1 - outCurrent;
+            outCount = 0;
+            progress(config, "merge", merged, total);
+        }
+    }
+    if (status == 0 && outCount > 0) {
+        if (ioWait(writer, &writes[1 - outCurrent]) < 0) status = -1;
+        else ioSubmit(writer, &writes[outCurrent], outFd, 1, out[outCurrent], (size_t)outCount * sizeof(int), outOffset);
+        merged += outCount;
+    }
+    stats->memoryAccesses += 2 * merged;
+
+    for (int w = 0; w < 2; w++) {
+        if (ioWait(writer, &writes[w]) < 0) status = -1;
+    }
+    for (int r = 0; r < opened; r++) {
+        ioWait(reader, &readers[r].request[0]);
+        ioWait(reader, &readers[r].request[1]);
+        close(readers[r].fd);
+    }
+    progress(config, "merge", merged, total);
+
+    freeLoserTree(&lt, NULL, stats);
+    free(readers);
+    arenaFree(NULL, memory, memoryBytes, stats);
+    return status;
+}
+
+int external_sort_file(const char* input, const char* output, const ExternalConfig* config, Stats_t* stats) {
+    int inFd = open(input, O_RDONLY);
+    if (inFd < 0) {
+        fprintf(stderr, "External sort: cannot open %s: %s\n", input, strerror(errno));
+        return -1;
+    }
+    struct stat info;
+    if (fstat(inFd, &info) != 0 || info.st_size % (off_t)sizeof(int) != 0) {
+        fprintf(stderr, "External sort: %s is not a file of 32-bit ints.\n", input);
+        close(inFd);
+        return -1;
+    }
+    long long total = (long long)(info.st_size / (off_t)sizeof(int));
+    posix_fadvise(inFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    int outFd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (outFd < 0) {
+        fprintf(stderr, "External sort: cannot create %s: %s\n", output, strerror(errno));
+        close(inFd);
+        return -1;
+    }
+
+    IoThread reader, writer;
+    if (ioStart(&reader) != 0) {
+        close(inFd);
+        close(outFd);
+        return -1;
+    }
+    if (ioStart(&writer) != 0) {
+        ioStop(&reader);
+        close(inFd);
+        close(outFd);
+        return -1;
+    }
+
+    RunList runs;
+    memset(&runs, 0, sizeof(runs));
+    int status = (total > 0) ? formRuns(inFd, total, config, &reader, &writer, &runs, stats) : 0;
+    close(inFd);
+
+    // fan-in: two blocks per run plus two for the output must fit the budget
+    int fanIn = (int)(config->memoryBudget / (2 * IO_BLOCK_MIN)) - 1;
+    if (fanIn > MAX_FAN_IN) fanIn = MAX_FAN_IN;
+    if (fanIn < 2) fanIn = 2;
+
+    // merge groups of runs into new runs until one pass can write the output
+    int next = 0; // first run not merged yet
+    while (status == 0 && runs.count - next > 0) {
+        int k = runs.count - next;
+        int last = (k <= fanIn);
+        if (!last) k = fanIn;
+
+        long long length = 0;
+        for (int r = next; r < next + k; r++) length += runs.lengths[r];
+        int blockElements = (int)(config->memoryBudget / ((size_t)(2 * k + 2) * sizeof(int)));
+        if (blockElements > (IO_BLOCK_MIN * 16) / (int)sizeof(int)) blockElements = (IO_BLOCK_MIN * 16) / (int)sizeof(int);
+        if (blockElements < 1024) blockElements = 1024;
+
+        int fd = last ? outFd : newRun(&runs, config->tempDir ? config->tempDir : ".", length);
+        if (fd < 0) { status = -1; break; }
+        status = mergeRuns(&runs, next, k, fd, length, blockElements, config, &reader, &writer, stats);
+        if (!last) close(fd);
+
+        removeRuns(&runs, next, next + k);
+        next += k;
+        if (last) break;
+    }
+    removeRuns(&runs, next, runs.count); // left over after an error
+
+    ioStop(&reader);
+    ioStop(&writer);
+    if (close(outFd) != 0) status = -1;
+    free(runs.paths);
+    free(runs.lengths);
+    return status;
+}
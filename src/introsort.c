@@ -0,0 +1,367 @@
+#include "introsort.h"
+#include "network.h"
+#include "instrument.h"
+#include <stddef.h> // For NULL
+
+#define INSERTION_CUTOFF 16 // ranges this short are finished by insertion sort
+#define NINTHER_CUTOFF 128  // above this, the pivot is a median of three medians
+#define STACK_SIZE 64       // > log2(INT_MAX): enough when the smaller side goes first
+#define SELECT_MARK_BLOCK 256 // heap top-k: scanned elements shown as dropped by blocks of this many
+
+// Range waiting on the stack, with the depth budget it had when pushed
+typedef struct {
+    int low;
+    int high;
+    int depth;
+} IntroRange;
+
+// Everything the helpers need, kept in one place so they stay small.
+// Every helper is inlined into the two entry points with 'counted' constant
+// (instrument.h): intro_sort counts and traces, intro_sort_raw does neither.
+typedef struct {
+    int* tab;
+    Counters counters; // flushed to 'stats' after each partition / leaf
+    OpSink* sink;
+} Intro;
+
+KERNEL_INLINE void emit(Intro* s, TraceOp op, const int counted) {
+    if (counted && s->sink != NULL) s->sink->push(s->sink->context, op);
+}
+
+KERNEL_INLINE int lessThan(Intro* s, int i, int j, const int counted) {
+    COUNT_COMPARISONS(&s->counters, 1);
+    COUNT_ACCESSES(&s->counters, 2);
+    emit(s, makeTraceOp(TRACE_COMPARE, i, j), counted);
+    return s->tab[i] < s->tab[j];
+}
+
+KERNEL_INLINE void swapValues(Intro* s, int i, int j, const int counted) {
+    COUNT_ACCESSES(&s->counters, 4); // 2 reads + 2 writes
+    int tmp = s->tab[i];
+    s->tab[i] = s->tab[j];
+    s->tab[j] = tmp;
+    emit(s, makeTraceOp(TRACE_SWAP, i, j), counted);
+}
+
+/*
+----------------------------------------------------
+ PIVOT SELECTION
+----------------------------------------------------
+*/
+// Sorts tab[a], tab[b], tab[c] so that tab[b] holds their median.
+KERNEL_INLINE void sort3(Intro* s, int a, int b, int c, const int counted) {
+    if (lessThan(s, b, a, counted)) swapValues(s, a, b, counted);
+    if (lessThan(s, c, b, counted)) swapValues(s, b, c, counted);
+    if (lessThan(s, b, a, counted)) swapValues(s, a, b, counted);
+}
+
+// Moves the pivot (median of 3, or ninther) to tab[low].
+KERNEL_INLINE void choosePivot(Intro* s, int low, int high, const int counted) {
+    int length = high - low + 1;
+    int mid = low + length / 2;
+
+    if (length > NINTHER_CUTOFF) {
+        // Tukey's ninther: median of the medians of three spread-out triples
+        int step = length / 8;
+        sort3(s, low, low + step, low + 2 * step, counted);
+        sort3(s, mid - step, mid, mid + step, counted);
+        sort3(s, high - 2 * step, high - step, high, counted);
+        sort3(s, low + step, mid, high - step, counted);
+    } else {
+        sort3(s, low, mid, high, counted);
+    }
+    swapValues(s, low, mid, counted);
+}
+
+/*
+----------------------------------------------------
+ HOARE PARTITION
+----------------------------------------------------
+ Pivot value = tab[low]. Returns j such that every element of [low..j]
+ is <= pivot and every element of [j+1..high] is >= pivot.
+----------------------------------------------------
+*/
+KERNEL_INLINE int hoarePartition(Intro* s, int low, int high, const int counted) {
+    int* tab = s->tab;
+    COUNT_ACCESSES(&s->counters, 1); // read pivot
+    int pivot = tab[low];
+    int i = low - 1;
+    int j = high + 1;
+
+    while (1) {
+        do {
+            i++;
+            COUNT_COMPARISONS(&s->counters, 1);
+            COUNT_ACCESSES(&s->counters, 1);
+            emit(s, makeTraceOp(TRACE_COMPARE, i, low), counted);
+        } while (tab[i] < pivot);
+
+        do {
+            j--;
+            COUNT_COMPARISONS(&s->counters, 1);
+            COUNT_ACCESSES(&s->counters, 1);
+            emit(s, makeTraceOp(TRACE_COMPARE, j, low), counted);
+        } while (tab[j] > pivot);
+
+        if (i >= j) return j;
+        swapValues(s, i, j, counted);
+    }
+}
+
+/*
+----------------------------------------------------
+ HEAP SORT FALLBACK
+----------------------------------------------------
+ Used on a range whose partitions keep going wrong: O(n log n) guaranteed.
+----------------------------------------------------
+*/
+// Sift tab[low + root] down a max-heap of 'count' elements starting at 'low'.
+KERNEL_INLINE void siftDown(Intro* s, int low, int root, int count, const int counted) {
+    while (1) {
+        int child = 2 * root + 1;
+        if (child >= count) return;
+        if (child + 1 < count && lessThan(s, low + child, low + child + 1, counted)) child++;
+        if (!lessThan(s, low + root, low + child, counted)) return;
+        swapValues(s, low + root, low + child, counted);
+        root = child;
+    }
+}
+
+KERNEL_INLINE void heapSortRange(Intro* s, int low, int high, const int counted) {
+    int count = high - low + 1;
+    for (int root = count / 2 - 1; root >= 0; root--) {
+        siftDown(s, low, root, count, counted);
+    }
+    for (int end = count - 1; end > 0; end--) {
+        swapValues(s, low, low + end, counted); // largest to the end
+        siftDown(s, low, 0, end, counted);
+    }
+}
+
+/*
+----------------------------------------------------
+ INSERTION SORT (small ranges)
+----------------------------------------------------
+*/
+KERNEL_INLINE void insertionRange(Intro* s, int low, int high, const int counted) {
+    int* tab = s->tab;
+    for (int i = low + 1; i <= high; i++) {
+        COUNT_ACCESSES(&s->counters, 1); // read key
+        int key = tab[i];
+        int j = i - 1;
+        COUNT_COMPARISONS(&s->counters, 1);
+        COUNT_ACCESSES(&s->counters, 1);
+        emit(s, makeTraceOp(TRACE_COMPARE, j, i), counted);
+        while (j >= low && tab[j] > key) {
+            COUNT_ACCESSES(&s->counters, 2);
+            tab[j + 1] = tab[j];
+            emit(s, makeTraceOp(TRACE_WRITE, j + 1, tab[j]), counted);
+            j--;
+        }
+        COUNT_ACCESSES(&s->counters, 1); // write key
+        tab[j + 1] = key;
+        emit(s, makeTraceOp(TRACE_WRITE, j + 1, key), counted);
+    }
+}
+
+/*
+----------------------------------------------------
+ INTROSORT
+----------------------------------------------------
+*/
+KERNEL_INLINE void introBody(int* tab, int size, Stats_t* stats, OpSink* sink, const int counted) {
+    Intro s = { tab, { 0, 0 }, sink };
+    IntroRange stack[STACK_SIZE];
+    int top = 0;
+
+    // depth budget: 2 * floor(log2(n))
+    int depthLimit = 0;
+    for (int n = size; n > 1; n >>= 1) depthLimit += 2;
+
+    // leaves go to a sorting network when the CPU has one, else insertion sort
+    int leafSize = (networkMode() != NETWORK_OFF) ? NETWORK_LEAF : INSERTION_CUTOFF;
+
+    int low = 0, high = size - 1, depth = depthLimit;
+    while (1) {
+        while (high - low + 1 > leafSize) {
+            if (depth == 0) {
+                heapSortRange(&s, low, high, counted); // too many bad pivots
+                flushCounters(&s.counters, stats, counted);
+                low = high; // range done
+                break;
+            }
+            depth--;
+
+            choosePivot(&s, low, high, counted);
+            int split = hoarePartition(&s, low, high, counted);
+            flushCounters(&s.counters, stats, counted);
+
+            // smaller side now, larger side on the stack
+            if (split - low < high - split) {
+                stack[top].low = split + 1; stack[top].high = high; stack[top].depth = depth;
+                high = split;
+            } else {
+                stack[top].low = low; stack[top].high = split; stack[top].depth = depth;
+                low = split + 1;
+            }
+            top++;
+        }
+        int leafDone = 0;
+        if (low < high) {
+            leafDone = counted ? network_leaf(tab, low, high - low + 1, stats, sink, -1)
+                               : network_leaf_raw(tab, low, high - low + 1);
+        }
+        if (low < high && !leafDone) {
+            insertionRange(&s, low, high, counted);
+            flushCounters(&s.counters, stats, counted);
+        }
+
+        if (top == 0) break;
+        top--;
+        low = stack[top].low;
+        high = stack[top].high;
+        depth = stack[top].depth;
+    }
+}
+
+void intro_sort(int* tab, int size, Stats_t* stats, OpSink* sink) {
+    introBody(tab, size, stats, sink, 1);
+}
+
+void intro_sort_raw(int* tab, int size) {
+    introBody(tab, size, NULL, NULL, 0);
+}
+
+/*
+----------------------------------------------------
+ SELECTION
+----------------------------------------------------
+ Same pivot and partition as the sort, but only the side holding the
+ wanted rank is kept: n + n/2 + n/4 ... ~ 2n compares on average instead
+ of n log2 n. Every range dropped is marked SELECT_DISCARD_COLOR for the
+ window: the selection never touches it again.
+----------------------------------------------------
+*/
+KERNEL_INLINE void discard(Intro* s, int low, int high, const int counted) {
+    if (low <= high) emit(s, makeOwnerOp(low, high, SELECT_DISCARD_COLOR), counted);
+}
+
+// Heap select fallback (as libstdc++ does): max-heap of tab[low .. target],
+// every smaller element of the rest replaces its top; the top is then the
+// wanted element. O(n log k) guaranteed.
+KERNEL_INLINE void heapSelectRange(Intro* s, int low, int high, int target, const int counted) {
+    int count = target - low + 1;
+    for (int root = count / 2 - 1; root >= 0; root--) {
+        siftDown(s, low, root, count, counted);
+    }
+    for (int i = target + 1; i <= high; i++) {
+        if (lessThan(s, i, low, counted)) {
+            swapValues(s, low, i, counted);
+            siftDown(s, low, 0, count, counted);
+        }
+    }
+    swapValues(s, low, target, counted);
+}
+
+// Introselect: tab[target] ends up where a full sort would put it, with
+// nothing greater on its left and nothing smaller on its right.
+// markLeft = 0 when the left side is sorted afterwards (partial sort).
+KERNEL_INLINE void selectBody(Intro* s, int size, int target, Stats_t* stats, int markLeft, const int counted) {
+    int depth = 0;
+    for (int n = size; n > 1; n >>= 1) depth += 2;
+
+    int low = 0, high = size - 1;
+    while (high - low + 1 > INSERTION_CUTOFF) {
+        if (depth == 0) {
+            heapSelectRange(s, low, high, target, counted); // too many bad pivots
+            flushCounters(&s->counters, stats, counted);
+            return;
+        }
+        depth--;
+
+        choosePivot(s, low, high, counted);
+        int split = hoarePartition(s, low, high, counted);
+        flushCounters(&s->counters, stats, counted);
+
+        if (target <= split) {
+            discard(s, split + 1, high, counted);
+            high = split;
+        } else {
+            if (markLeft) discard(s, low, split, counted);
+            low = split + 1;
+        }
+    }
+    insertionRange(s, low, high, counted);
+    flushCounters(&s->counters, stats, counted);
+}
+
+KERNEL_INLINE int clampRank(int k, int size) {
+    return k < 1 ? 1 : (k > size ? size : k);
+}
+
+KERNEL_INLINE void quickSelectBody(int* tab, int size, int k, Stats_t* stats, OpSink* sink, const int counted) {
+    if (size < 2) return;
+    Intro s = { tab, { 0, 0 }, sink };
+    selectBody(&s, size, clampRank(k, size) - 1, stats, 1, counted);
+}
+
+// Max-heap of the first k elements; every later element smaller than its
+// top replaces it. The heap is then sorted in place.
+KERNEL_INLINE void heapTopKBody(int* tab, int size, int k, Stats_t* stats, OpSink* sink, const int counted) {
+    if (size < 2) return;
+    Intro s = { tab, { 0, 0 }, sink };
+    k = clampRank(k, size);
+
+    for (int root = k / 2 - 1; root >= 0; root--) {
+        siftDown(&s, 0, root, k, counted);
+    }
+    int marked = k; // tab[k .. marked) already shown as dropped
+    for (int i = k; i < size; i++) {
+        if (lessThan(&s, i, 0, counted)) {
+            swapValues(&s, 0, i, counted);
+            siftDown(&s, 0, 0, k, counted);
+        }
+        if (i + 1 - marked == SELECT_MARK_BLOCK || i == size - 1) {
+            flushCounters(&s.counters, stats, counted);
+            discard(&s, marked, i, counted);
+            marked = i + 1;
+        }
+    }
+    for (int end = k - 1; end > 0; end--) {
+        swapValues(&s, 0, end, counted); // largest of the k to the end
+        siftDown(&s, 0, 0, end, counted);
+    }
+    flushCounters(&s.counters, stats, counted);
+}
+
+KERNEL_INLINE void partialSortBody(int* tab, int size, int k, Stats_t* stats, OpSink* sink, const int counted) {
+    if (size < 2) return;
+    Intro s = { tab, { 0, 0 }, sink };
+    k = clampRank(k, size);
+    selectBody(&s, size, k - 1, stats, 0, counted);
+    introBody(tab, k - 1, stats, sink, counted); // tab[k - 1] is already in place
+}
+
+void quick_select(int* tab, int size, int k, Stats_t* stats, OpSink* sink) {
+    quickSelectBody(tab, size, k, stats, sink, 1);
+}
+
+void heap_top_k(int* tab, int size, int k, Stats_t* stats, OpSink* sink) {
+    heapTopKBody(tab, size, k, stats, sink, 1);
+}
+
+void partial_sort(int* tab, int size, int k, Stats_t* stats, OpSink* sink) {
+    partialSortBody(tab, size, k, stats, sink, 1);
+}
+
+void quick_select_raw(int* tab, int size, int k) {
+    quickSelectBody(tab, size, k, NULL, NULL, 0);
+}
+
+void heap_top_k_raw(int* tab, int size, int k) {
+    heapTopKBody(tab, size, k, NULL, NULL, 0);
+}
+
+void partial_sort_raw(int* tab, int size, int k) {
+    partialSortBody(tab, size, k, NULL, NULL, 0);
+}
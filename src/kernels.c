@@ -0,0 +1,197 @@
+#include "kernels.h"
+#include "stats.h"
+#include "instrument.h"
+#include <stddef.h> // For NULL (no stats in the raw variants)
+
+/*
+----------------------------------------------------
+ BUBBLE SORT (headless)
+----------------------------------------------------
+ Same passes as bubble_sort() in sorting.c, with the early exit
+ when a pass does no swap. Counters flushed once per pass.
+----------------------------------------------------
+*/
+KERNEL_INLINE void bubbleBody(int* tab, int size, Stats_t* stats, const int counted) {
+    Counters counters = { 0, 0 };
+    for (int i = 0; i < size - 1; i++) {
+        int swapped = 0;
+
+        for (int j = 0; j < size - 1 - i; j++) {
+            COUNT_COMPARISONS(&counters, 1);
+            COUNT_ACCESSES(&counters, 2);
+
+            if (tab[j] > tab[j + 1]) {
+                COUNT_ACCESSES(&counters, 4); // 2 reads + 2 writes for a swap
+                int tmp = tab[j];
+                tab[j] = tab[j + 1];
+                tab[j + 1] = tmp;
+                swapped = 1;
+            }
+        }
+        flushCounters(&counters, stats, counted);
+
+        if (!swapped) break; // already sorted
+    }
+}
+
+void kernel_bubble_sort(int* tab, int size, Stats_t* stats) {
+    bubbleBody(tab, size, stats, 1);
+}
+
+void kernel_bubble_sort_raw(int* tab, int size) {
+    bubbleBody(tab, size, NULL, 0);
+}
+
+/*
+----------------------------------------------------
+ SELECTION SORT (headless)
+----------------------------------------------------
+*/
+KERNEL_INLINE void selectionBody(int* tab, int size, Stats_t* stats, const int counted) {
+    Counters counters = { 0, 0 };
+    for (int i = 0; i < size - 1; i++) {
+        int minimum = i;
+
+        for (int j = i + 1; j < size; j++) {
+            COUNT_COMPARISONS(&counters, 1);
+            COUNT_ACCESSES(&counters, 2); // read tab[j] and tab[minimum]
+
+            if (tab[j] < tab[minimum]) {
+                minimum = j;
+            }
+        }
+
+        if (minimum != i) {
+            COUNT_ACCESSES(&counters, 4); // 2 reads + 2 writes for swap
+            int tmp = tab[i];
+            tab[i] = tab[minimum];
+            tab[minimum] = tmp;
+        }
+        flushCounters(&counters, stats, counted);
+    }
+}
+
+void kernel_selection_sort(int* tab, int size, Stats_t* stats) {
+    selectionBody(tab, size, stats, 1);
+}
+
+void kernel_selection_sort_raw(int* tab, int size) {
+    selectionBody(tab, size, NULL, 0);
+}
+
+/*
+----------------------------------------------------
+ INSERTION SORT (headless)
+----------------------------------------------------
+ Counters flushed once at the end (a single pass over the array).
+----------------------------------------------------
+*/
+KERNEL_INLINE void insertionBody(int* tab, int size, Stats_t* stats, const int counted) {
+    Counters counters = { 0, 0 };
+    for (int i = 1; i < size; i++) {
+        COUNT_ACCESSES(&counters, 1); // read key
+        int key = tab[i];
+        int j = i - 1;
+
+        COUNT_COMPARISONS(&counters, 1);
+        COUNT_ACCESSES(&counters, 1);
+
+        while (j >= 0 && tab[j] > key) {
+            COUNT_ACCESSES(&counters, 2); // write tab[j+1], read tab[j]
+            tab[j + 1] = tab[j];
+            j--;
+        }
+
+        COUNT_ACCESSES(&counters, 1); // write key
+        tab[j + 1] = key;
+    }
+    flushCounters(&counters, stats, counted);
+}
+
+void kernel_insertion_sort(int* tab, int size, Stats_t* stats) {
+    insertionBody(tab, size, stats, 1);
+}
+
+void kernel_insertion_sort_raw(int* tab, int size) {
+    insertionBody(tab, size, NULL, 0);
+}
+
+/*
+----------------------------------------------------
+ QUICK SORT (headless)
+----------------------------------------------------
+ Lomuto partition with pivot = tab[high], like partition() in sorting.c.
+ Counters flushed once per partition.
+----------------------------------------------------
+*/
+
+// Partition around pivot = tab[high]. Returns pivot's final index.
+KERNEL_INLINE int partitionBody(int* tab, int low, int high, Stats_t* stats, const int counted) {
+    Counters counters = { 0, 0 };
+    COUNT_ACCESSES(&counters, 1); // read pivot
+    int pivot_value = tab[high];
+
+    int i = (low - 1); // boundary of "elements < pivot"
+
+    for (int j = low; j < high; j++) {
+        COUNT_COMPARISONS(&counters, 1);
+        COUNT_ACCESSES(&counters, 1); // read tab[j]
+
+        if (tab[j] < pivot_value) {
+            i++;
+            COUNT_ACCESSES(&counters, 4); // 2 reads + 2 writes
+            int temp = tab[i];
+            tab[i] = tab[j];
+            tab[j] = temp;
+        }
+    }
+
+    // place pivot at i+1 (its final position)
+    COUNT_ACCESSES(&counters, 4);
+    int temp = tab[i + 1];
+    tab[i + 1] = tab[high];
+    tab[high] = temp;
+
+    flushCounters(&counters, stats, counted);
+    return (i + 1);
+}
+
+#define QUICK_STACK_SIZE 64 // > log2(INT_MAX): enough when the larger side waits
+
+// Sorts tab[0 .. size). The larger side of each partition waits on an
+// explicit stack while the loop goes on with the smaller one, so at most
+// log2(n) ranges wait even when the partitions are lopsided (sorted input,
+// equal keys). A stack instead of recursion keeps the body inlinable.
+KERNEL_INLINE void quickBody(int* tab, int size, Stats_t* stats, const int counted) {
+    int lows[QUICK_STACK_SIZE], highs[QUICK_STACK_SIZE];
+    int top = 0;
+    int low = 0, high = size - 1;
+    while (1) {
+        if (low < high) {
+            int pivot_index = partitionBody(tab, low, high, stats, counted);
+            if (pivot_index - low < high - pivot_index) {
+                lows[top] = pivot_index + 1; // larger right side waits
+                highs[top++] = high;
+                high = pivot_index - 1;
+            } else {
+                lows[top] = low; // larger left side waits
+                highs[top++] = pivot_index - 1;
+                low = pivot_index + 1;
+            }
+        } else if (top > 0) {
+            top--;
+            low = lows[top];
+            high = highs[top];
+        } else {
+            return;
+        }
+    }
+}
+
+void kernel_quick_sort(int* tab, int size, Stats_t* stats) {
+    quickBody(tab, size, stats, 1);
+}
+
+void kernel_quick_sort_raw(int* tab, int size) {
+    quickBody(tab, size, NULL, 0);
+}
@@ -1,33 +1,120 @@
-#include "main.h"    // For defining the extern constants
+#include "main.h"    // For AppConfig
 #include "visual.h"  // For initAppVisuals, cleanupAppVisuals
-#include "utils.h"   // For runMainLoop
-#include <stdlib.h>  // For EXIT_SUCCESS/FAILURE
-#include <time.h>    // For time()
-#include <stdio.h>   // For srand()
+#include "utils.h"   // For runMainLoop, runRecording
+#include "registry.h" // For --plugin and --algo
+#include "strsort.h"  // For --strings
+#include <stdlib.h>  // For EXIT_SUCCESS/FAILURE, atoi
+#include <stdio.h>   // For fprintf()
+#include <string.h>  // For strcmp
 
-// Define global constants
-//available to other files because declared in main.h
-const int WINDOW_WIDTH = 800;
-const int WINDOW_HEIGHT = 600;
-const int N = 100;
+// Default settings (changed with the command line options below)
+#define DEFAULT_WINDOW_WIDTH 800
+#define DEFAULT_WINDOW_HEIGHT 600
+#define DEFAULT_SIZE 100
+#define DEFAULT_FPS 60
+
+static void usage(const char* prog) {
+    fprintf(stderr, "usage: %s [--n N] [--max-value V] [--width W] [--height H] [--k K] [--heatmap] [--plugin FILE.so]...\n"
+                    "          [--strings paths|ids]\n"
+                    "          [--record FILE|- --algo NAME|ID [--format y4m|ppm] [--fps F] [--speed OPS]]\n", prog);
+}
 
 int main(int argc, char *argv[])
 {
-    // Seed the random number generator ONCE at the start
-    srand(time(NULL));
+    AppConfig config = { DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT, DEFAULT_SIZE, 0, 0, 0, 0 };
+    // recording (no window): one video frame per 'speed' operations of the sort
+    const char* recordPath = NULL;
+    int recordFormat = FRAME_Y4M;
+    int fps = DEFAULT_FPS;
+    const char* algorithmName = NULL;
+    int speed = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--n") == 0 && i + 1 < argc) {
+            config.size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-value") == 0 && i + 1 < argc) {
+            config.maxValue = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            config.windowWidth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            config.windowHeight = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--k") == 0 && i + 1 < argc) {
+            config.selectK = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--heatmap") == 0) {
+            config.showAccess = 1;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            recordFormat = frameFormatFromName(argv[++i]);
+            if (recordFormat < 0) {
+                fprintf(stderr, "Unknown video format '%s' (y4m or ppm).\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            fps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--algo") == 0 && i + 1 < argc) {
+            algorithmName = argv[++i];
+        } else if (strcmp(argv[i], "--plugin") == 0 && i + 1 < argc) {
+            if (loadAlgorithmPlugin(argv[++i]) < 0) return EXIT_FAILURE;
+        } else if (strcmp(argv[i], "--strings") == 0 && i + 1 < argc) {
+            if (setStringShape(argv[++i]) != 0) {
+                fprintf(stderr, "Unknown string keys '%s' (paths or ids).\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (config.size < 2 || config.size > MAX_ARRAY_SIZE || config.maxValue < 0 || config.selectK < 0) {
+        fprintf(stderr, "N must be between 2 and %d, the max value and k positive.\n", MAX_ARRAY_SIZE);
+        return EXIT_FAILURE;
+    }
+    if (config.windowWidth < MIN_WINDOW_WIDTH) config.windowWidth = MIN_WINDOW_WIDTH;
+    if (config.windowHeight < MIN_WINDOW_HEIGHT) config.windowHeight = MIN_WINDOW_HEIGHT;
+
+    FrameWriter* writer = NULL;
+    int algorithm = 0;
+    if (recordPath != NULL) {
+        // by name, or by id (the menu order, 1 to 18 for the built-ins)
+        if (algorithmName != NULL) {
+            algorithm = findAlgorithm(algorithmName);
+            if (algorithm == 0 && algorithmInfo(atoi(algorithmName)) != NULL) algorithm = atoi(algorithmName);
+        }
+        if (algorithm == 0 || fps < 1) {
+            fprintf(stderr, "Recording needs a known --algo and a positive --fps.\n");
+            return EXIT_FAILURE;
+        }
+        config.headless = 1;
+        config.windowWidth &= ~1; // 4:2:0 video: even sizes
+        config.windowHeight &= ~1;
+        // opened first: with '-' the messages printed from now on go to stderr
+        writer = createFrameWriter(recordPath, recordFormat, config.windowWidth, config.windowHeight, fps);
+        if (writer == NULL) return EXIT_FAILURE;
+    }
 
     // Initialize everything (call to visual.c)
-    App_Window* app = initAppVisuals();
+    App_Window* app = initAppVisuals(&config);
     if (app == NULL) {
         fprintf(stderr, "Application failed to initialize. Exiting.\n");
+        closeFrameWriter(writer);
         return EXIT_FAILURE;
     }
 
-    // Run the application loop (call to utils.c)
-    runMainLoop(app);
+    int status = EXIT_SUCCESS;
+    if (writer != NULL) {
+        // Headless: render the whole sort into the video, then hold the result for a second
+        if (speed > 0) app->replaySpeed = speed;
+        if (runRecording(app, algorithm, writer, fps) != 0) status = EXIT_FAILURE;
+        if (closeFrameWriter(writer) != 0) status = EXIT_FAILURE;
+    } else {
+        // Run the application loop (call to utils.c)
+        runMainLoop(app);
+    }
 
     // Clean up all resources (call to visual.c)
     cleanupAppVisuals(app);
 
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    return status;
+}
@@ -0,0 +1,322 @@
+#include "network.h"
+#include "instrument.h"
+#include <limits.h>    // For INT_MAX (padding)
+#include <stdatomic.h>
+#include <string.h>    // For memcpy and strcmp
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NETWORK_X86 1
+#endif
+
+// -1 until the first use picks the best implementation
+static atomic_int currentMode = -1;
+
+/*
+----------------------------------------------------
+ CPU DISPATCH
+----------------------------------------------------
+*/
+static int bestMode(void) {
+#ifdef NETWORK_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return NETWORK_AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return NETWORK_SSE4;
+#endif
+    return NETWORK_SCALAR;
+}
+
+int networkMode(void) {
+    int mode = atomic_load_explicit(&currentMode, memory_order_relaxed);
+    if (mode < 0) {
+        mode = bestMode();
+        atomic_store_explicit(&currentMode, mode, memory_order_relaxed);
+    }
+    return mode;
+}
+
+int setNetworkMode(const char* name) {
+    int best = bestMode();
+    int mode;
+    if (strcmp(name, "auto") == 0) mode = best;
+    else if (strcmp(name, "avx2") == 0) mode = NETWORK_AVX2;
+    else if (strcmp(name, "sse4") == 0) mode = NETWORK_SSE4;
+    else if (strcmp(name, "scalar") == 0) mode = NETWORK_SCALAR;
+    else if (strcmp(name, "off") == 0) mode = NETWORK_OFF;
+    else return -1;
+
+    if (mode > best) return -1; // not supported by this CPU
+    atomic_store_explicit(&currentMode, mode, memory_order_relaxed);
+    return 0;
+}
+
+const char* networkModeName(void) {
+    static const char* names[] = { "off", "scalar", "sse4", "avx2" };
+    return names[networkMode()];
+}
+
+// Smallest block (power of two, at least 'minimum') holding 'size' elements
+static int blockSize(int size, int minimum) {
+    int block = minimum;
+    while (block < size) block *= 2;
+    return block;
+}
+
+// Compare-exchanges of a bitonic network on 'block' elements: n/2 per stage,
+// log2(n) * (log2(n) + 1) / 2 stages.
+static long long comparatorCount(int block) {
+    int k = 0;
+    while ((1 << k) < block) k++;
+    return (long long)(block / 2) * k * (k + 1) / 2;
+}
+
+/*
+----------------------------------------------------
+ SCALAR NETWORK
+----------------------------------------------------
+ Every comparator puts the min at the lower index. For each block size p:
+ one "flip" stage (i against its mirror in the p-block), then half-cleaner
+ stages at distance p/4, p/8, ..., 1. Pairs whose upper index is past 'size'
+ are skipped: that slot would hold padding (+infinity) and never move.
+----------------------------------------------------
+*/
+KERNEL_INLINE void scalarNetwork(int* tab, int size, long long* comparisons, const int counted) {
+    int n = blockSize(size, 2);
+    long long count = 0;
+
+    for (int p = 2; p <= n; p *= 2) {
+        for (int start = 0; start < size; start += p) {
+            for (int t = 0; t < p / 2; t++) {
+                int i = start + t, j = start + p - 1 - t;
+                if (j >= size) continue;
+                int a = tab[i], b = tab[j];
+                tab[i] = a < b ? a : b;
+                tab[j] = a < b ? b : a;
+                count++;
+            }
+        }
+        for (int d = p / 4; d >= 1; d /= 2) {
+            for (int i = 0; i + d < size; i++) {
+                if (i & d) continue;
+                int a = tab[i], b = tab[i + d];
+                tab[i] = a < b ? a : b;
+                tab[i + d] = a < b ? b : a;
+                count++;
+            }
+        }
+    }
+    if (counted) *comparisons += count;
+}
+
+#ifdef NETWORK_X86
+/*
+----------------------------------------------------
+ SSE4.1 NETWORK (4 lanes)
+----------------------------------------------------
+ Same stages on vectors of 4: distances of 4 and more are min/max between
+ whole vectors, shorter ones are done inside a vector (shuffle, min/max,
+ then blend the max into the upper lane of each pair).
+----------------------------------------------------
+*/
+// lane k against lane shuffle[k]; blend mask (16-bit lanes) selects the lanes keeping the max
+#define SSE_EXCHANGE(x, shuffle, mask) do { \
+        __m128i p_ = _mm_shuffle_epi32((x), (shuffle)); \
+        (x) = _mm_blend_epi16(_mm_min_epi32((x), p_), _mm_max_epi32((x), p_), (mask)); \
+    } while (0)
+
+#define SSE_REVERSE(x) _mm_shuffle_epi32((x), _MM_SHUFFLE(0, 1, 2, 3))
+
+__attribute__((target("sse4.1")))
+static void sse4Network(int* tab, int n) {
+    __m128i v[NETWORK_MAX_BLOCK / 4];
+    int count = n / 4;
+    for (int k = 0; k < count; k++) v[k] = _mm_loadu_si128((const __m128i*)(tab + 4 * k));
+
+    // p = 2 and 4 inside each vector
+    for (int k = 0; k < count; k++) {
+        SSE_EXCHANGE(v[k], _MM_SHUFFLE(2, 3, 0, 1), 0xCC);
+        SSE_EXCHANGE(v[k], _MM_SHUFFLE(0, 1, 2, 3), 0xF0);
+        SSE_EXCHANGE(v[k], _MM_SHUFFLE(2, 3, 0, 1), 0xCC);
+    }
+
+    for (int p = 8; p <= n; p *= 2) {
+        int vectors = p / 4;
+        // flip: vector t against the reversed mirror vector
+        for (int start = 0; start < count; start += vectors) {
+            for (int t = 0; t < vectors / 2; t++) {
+                __m128i a = v[start + t];
+                __m128i b = SSE_REVERSE(v[start + vectors - 1 - t]);
+                v[start + t] = _mm_min_epi32(a, b);
+                v[start + vectors - 1 - t] = SSE_REVERSE(_mm_max_epi32(a, b));
+            }
+        }
+        // half-cleaners at distance >= 4 elements: whole vectors
+        for (int d = vectors / 4; d >= 1; d /= 2) {
+            for (int k = 0; k < count; k++) {
+                if (k & d) continue;
+                __m128i a = v[k];
+                v[k] = _mm_min_epi32(a, v[k + d]);
+                v[k + d] = _mm_max_epi32(a, v[k + d]);
+            }
+        }
+        // distances 2 and 1 inside each vector
+        for (int k = 0; k < count; k++) {
+            SSE_EXCHANGE(v[k], _MM_SHUFFLE(1, 0, 3, 2), 0xF0);
+            SSE_EXCHANGE(v[k], _MM_SHUFFLE(2, 3, 0, 1), 0xCC);
+        }
+    }
+
+    for (int k = 0; k < count; k++) _mm_storeu_si128((__m128i*)(tab + 4 * k), v[k]);
+}
+
+/*
+----------------------------------------------------
+ AVX2 NETWORK (8 lanes)
+----------------------------------------------------
+*/
+#define AVX2_EXCHANGE(x, i0, i1, i2, i3, i4, i5, i6, i7, mask) do { \
+        __m256i p_ = _mm256_permutevar8x32_epi32((x), _mm256_setr_epi32(i0, i1, i2, i3, i4, i5, i6, i7)); \
+        (x) = _mm256_blend_epi32(_mm256_min_epi32((x), p_), _mm256_max_epi32((x), p_), (mask)); \
+    } while (0)
+
+#define AVX2_REVERSE(x) _mm256_permutevar8x32_epi32((x), _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0))
+
+__attribute__((target("avx2")))
+static void avx2Network(int* tab, int n) {
+    __m256i v[NETWORK_MAX_BLOCK / 8];
+    int count = n / 8;
+    for (int k = 0; k < count; k++) v[k] = _mm256_loadu_si256((const __m256i*)(tab + 8 * k));
+
+    // p = 2, 4 and 8 inside each vector
+    for (int k = 0; k < count; k++) {
+        AVX2_EXCHANGE(v[k], 1, 0, 3, 2, 5, 4, 7, 6, 0xAA);
+        AVX2_EXCHANGE(v[k], 3, 2, 1, 0, 7, 6, 5, 4, 0xCC);
+        AVX2_EXCHANGE(v[k], 1, 0, 3, 2, 5, 4, 7, 6, 0xAA);
+        AVX2_EXCHANGE(v[k], 7, 6, 5, 4, 3, 2, 1, 0, 0xF0);
+        AVX2_EXCHANGE(v[k], 2, 3, 0, 1, 6, 7, 4, 5, 0xCC);
+        AVX2_EXCHANGE(v[k], 1, 0, 3, 2, 5, 4, 7, 6, 0xAA);
+    }
+
+    for (int p = 16; p <= n; p *= 2) {
+        int vectors = p / 8;
+        for (int start = 0; start < count; start += vectors) {
+            for (int t = 0; t < vectors / 2; t++) {
+                __m256i a = v[start + t];
+                __m256i b = AVX2_REVERSE(v[start + vectors - 1 - t]);
+                v[start + t] = _mm256_min_epi32(a, b);
+                v[start + vectors - 1 - t] = AVX2_REVERSE(_mm256_max_epi32(a, b));
+            }
+        }
+        for (int d = vectors / 4; d >= 1; d /= 2) {
+            for (int k = 0; k < count; k++) {
+                if (k & d) continue;
+                __m256i a = v[k];
+                v[k] = _mm256_min_epi32(a, v[k + d]);
+                v[k + d] = _mm256_max_epi32(a, v[k + d]);
+            }
+        }
+        // distances 4, 2 and 1 inside each vector
+        for (int k = 0; k < count; k++) {
+            AVX2_EXCHANGE(v[k], 4, 5, 6, 7, 0, 1, 2, 3, 0xF0);
+            AVX2_EXCHANGE(v[k], 2, 3, 0, 1, 6, 7, 4, 5, 0xCC);
+            AVX2_EXCHANGE(v[k], 1, 0, 3, 2, 5, 4, 7, 6, 0xAA);
+        }
+    }
+
+    for (int k = 0; k < count; k++) _mm256_storeu_si256((__m256i*)(tab + 8 * k), v[k]);
+}
+#endif
+
+/*
+----------------------------------------------------
+ ENTRY POINTS
+----------------------------------------------------
+*/
+// Counted (network_sort) and raw (network_sort_raw) versions, instrument.h
+KERNEL_INLINE void networkSortBody(int* tab, int size, Stats_t* stats, const int counted) {
+    if (size < 2) return;
+    int mode = networkMode();
+    if (counted) stats->memoryAccesses += 2LL * size; // one read + one write per element
+
+#ifdef NETWORK_X86
+    if (mode == NETWORK_AVX2 || mode == NETWORK_SSE4) {
+        // vector networks work on whole blocks: pad with +infinity
+        int lanes = (mode == NETWORK_AVX2) ? 8 : 4;
+        int n = blockSize(size, lanes);
+        int block[NETWORK_MAX_BLOCK];
+        memcpy(block, tab, size * sizeof(int));
+        for (int i = size; i < n; i++) block[i] = INT_MAX;
+
+        if (mode == NETWORK_AVX2) avx2Network(block, n);
+        else sse4Network(block, n);
+
+        memcpy(tab, block, size * sizeof(int));
+        if (counted) stats->comparisons += comparatorCount(n);
+        return;
+    }
+#endif
+    (void)mode;
+    scalarNetwork(tab, size, counted ? &stats->comparisons : NULL, counted);
+}
+
+void network_sort(int* tab, int size, Stats_t* stats) {
+    networkSortBody(tab, size, stats, 1);
+}
+
+void network_sort_raw(int* tab, int size) {
+    networkSortBody(tab, size, NULL, 0);
+}
+
+static inline void emit(OpSink* sink, TraceOp op) {
+    if (sink != NULL) sink->push(sink->context, op);
+}
+
+static inline void traceExchange(int* tab, int i, int j, Stats_t* stats, OpSink* sink) {
+    stats->comparisons++;
+    stats->memoryAccesses += 2;
+    emit(sink, makeTraceOp(TRACE_COMPARE, i, j));
+    if (tab[j] < tab[i]) {
+        stats->memoryAccesses += 4; // 2 reads + 2 writes
+        int tmp = tab[i];
+        tab[i] = tab[j];
+        tab[j] = tmp;
+        emit(sink, makeTraceOp(TRACE_SWAP, i, j));
+    }
+}
+
+void network_sort_traced(int* tab, int low, int size, Stats_t* stats, OpSink* sink, int owner) {
+    if (size < 2) return;
+    int n = blockSize(size, 2);
+    int high = low + size - 1;
+    int stage = 0;
+
+    for (int p = 2; p <= n; p *= 2) {
+        emit(sink, makeOwnerOp(low, high, NETWORK_STAGE_COLOR + (stage++ & 1)));
+        for (int start = 0; start < size; start += p) {
+            for (int t = 0; t < p / 2; t++) {
+                int j = start + p - 1 - t;
+                if (j < size) traceExchange(tab, low + start + t, low + j, stats, sink);
+            }
+        }
+        for (int d = p / 4; d >= 1; d /= 2) {
+            emit(sink, makeOwnerOp(low, high, NETWORK_STAGE_COLOR + (stage++ & 1)));
+            for (int i = 0; i + d < size; i++) {
+                if (!(i & d)) traceExchange(tab, low + i, low + i + d, stats, sink);
+            }
+        }
+    }
+    if (owner >= 0) emit(sink, makeOwnerOp(low, high, owner));
+}
+
+int network_leaf(int* tab, int low, int size, Stats_t* stats, OpSink* sink, int owner) {
+    if (size > NETWORK_LEAF || networkMode() == NETWORK_OFF) return 0;
+    if (sink != NULL) network_sort_traced(tab, low, size, stats, sink, owner);
+    else network_sort(tab + low, size, stats);
+    return 1;
+}
+
+int network_leaf_raw(int* tab, int low, int size) {
+    if (size > NETWORK_LEAF || networkMode() == NETWORK_OFF) return 0;
+    network_sort_raw(tab + low, size);
+    return 1;
+}
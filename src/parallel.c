@@ -0,0 +1,394 @@
+#include "parallel.h"
+#include "network.h"
+#include <string.h> // For memset
+
+// Counters of one worker, on their own cache line (no false sharing)
+typedef struct {
+    _Alignas(64) long long comparisons;
+    long long memoryAccesses;
+} WorkerCounters;
+
+// Shared by every task of one sort
+typedef struct {
+    int* tab;
+    int* buffer; // merge sort only
+    int size;
+    int cutoff;
+    ThreadPool* pool;
+    OpSink* sink;
+    WorkerCounters counters[POOL_MAX_THREADS];
+} ParallelSort;
+
+// Task argument: a range of the array. Lives on the stack of the task
+// that spawned it, which waits for it before returning.
+typedef struct {
+    ParallelSort* ps;
+    int low;
+    int high;
+} RangeTask;
+
+static inline WorkerCounters* myCounters(ParallelSort* ps) {
+    return &ps->counters[poolWorkerId()];
+}
+
+static inline void emit(ParallelSort* ps, TraceOp op) {
+    if (ps->sink != NULL) ps->sink->push(ps->sink->context, op);
+}
+
+static inline void swapValues(ParallelSort* ps, WorkerCounters* c, int i, int j) {
+    c->memoryAccesses += 4; // 2 reads + 2 writes
+    int tmp = ps->tab[i];
+    ps->tab[i] = ps->tab[j];
+    ps->tab[j] = tmp;
+    emit(ps, makeTraceOp(TRACE_SWAP, i, j));
+}
+
+// Sorts tab[low .. low + count) with a sorting network when the range is a leaf.
+// return 0 if the caller must sort it itself.
+static int networkLeaf(ParallelSort* ps, WorkerCounters* c, int low, int count) {
+    Stats_t leaf;
+    memset(&leaf, 0, sizeof(leaf));
+    if (!network_leaf(ps->tab, low, count, &leaf, ps->sink, poolWorkerId())) return 0;
+    c->comparisons += leaf.comparisons;
+    c->memoryAccesses += leaf.memoryAccesses;
+    return 1;
+}
+
+// Sums the per-worker counters into 'stats'.
+static void collectCounters(ParallelSort* ps, Stats_t* stats) {
+    for (int w = 0; w < ps->pool->threadCount; w++) {
+        stats->comparisons += ps->counters[w].comparisons;
+        stats->memoryAccesses += ps->counters[w].memoryAccesses;
+    }
+}
+
+/*
+----------------------------------------------------
+ PARALLEL QUICK SORT
+----------------------------------------------------
+ Ninther pivot and Hoare partition (stops on keys equal to the pivot, so duplicates split
+ evenly), then the smaller side becomes a task that any idle worker can
+ steal while this worker loops on the larger side.
+----------------------------------------------------
+*/
+
+#define QUICK_MAX_SPAWNS 32 // tasks one quickTask keeps in flight; more are sorted in place
+
+#define QUICK_NINTHER_CUTOFF 128 // above this, the pivot is a median of three medians
+
+// Sorts tab[a], tab[b], tab[c] so that tab[b] holds their median.
+static void sort3(ParallelSort* ps, WorkerCounters* c, int a, int b, int d) {
+    int* tab = ps->tab;
+    c->comparisons += 3;
+    c->memoryAccesses += 6;
+    emit(ps, makeTraceOp(TRACE_COMPARE, a, b));
+    if (tab[b] < tab[a]) swapValues(ps, c, a, b);
+    emit(ps, makeTraceOp(TRACE_COMPARE, b, d));
+    if (tab[d] < tab[b]) swapValues(ps, c, b, d);
+    emit(ps, makeTraceOp(TRACE_COMPARE, a, b));
+    if (tab[b] < tab[a]) swapValues(ps, c, a, b);
+}
+
+// Moves the pivot (median of 3, or ninther) to tab[low], like introsort.c.
+static void choosePivot(ParallelSort* ps, WorkerCounters* c, int low, int high) {
+    int length = high - low + 1;
+    int mid = low + length / 2;
+
+    if (length > QUICK_NINTHER_CUTOFF) {
+        int step = length / 8;
+        sort3(ps, c, low, low + step, low + 2 * step);
+        sort3(ps, c, mid - step, mid, mid + step);
+        sort3(ps, c, high - 2 * step, high - step, high);
+        sort3(ps, c, low + step, mid, high - step);
+    } else {
+        sort3(ps, c, low, mid, high);
+    }
+    swapValues(ps, c, low, mid);
+}
+
+// Hoare partition around the chosen pivot, like introsort.c.
+// Returns j such that [low..j] <= pivot <= [j+1..high], with low <= j < high.
+static int parallelPartition(ParallelSort* ps, WorkerCounters* c, int low, int high) {
+    int* tab = ps->tab;
+    choosePivot(ps, c, low, high);
+
+    c->memoryAccesses++; // read pivot
+    int pivot = tab[low];
+    int i = low - 1;
+    int j = high + 1;
+
+    while (1) {
+        do {
+            i++;
+            c->comparisons++;
+            c->memoryAccesses++;
+            emit(ps, makeTraceOp(TRACE_COMPARE, i, low));
+        } while (tab[i] < pivot);
+
+        do {
+            j--;
+            c->comparisons++;
+            c->memoryAccesses++;
+            emit(ps, makeTraceOp(TRACE_COMPARE, j, low));
+        } while (tab[j] > pivot);
+
+        if (i >= j) return j;
+        swapValues(ps, c, i, j);
+    }
+}
+
+// Sequential quick sort of a small range (smaller side recursed, larger side looped).
+static void sequentialQuick(ParallelSort* ps, WorkerCounters* c, int low, int high) {
+    while (low < high) {
+        if (networkLeaf(ps, c, low, high - low + 1)) return;
+        int split = parallelPartition(ps, c, low, high);
+        if (split - low < high - split) {
+            sequentialQuick(ps, c, low, split);
+            low = split + 1;
+        } else {
+            sequentialQuick(ps, c, split + 1, high);
+            high = split;
+        }
+    }
+}
+
+static void quickTask(void* arg) {
+    RangeTask* task = (RangeTask*)arg;
+    ParallelSort* ps = task->ps;
+    int low = task->low, high = task->high;
+
+    if (low >= high) return;
+    emit(ps, makeOwnerOp(low, high, poolWorkerId()));
+
+    // smaller side: a task other workers can steal; larger side: this worker
+    TaskGroup group;
+    atomic_init(&group.pending, 0);
+    RangeTask spawned[QUICK_MAX_SPAWNS];
+    int spawnCount = 0;
+
+    while (high - low + 1 > ps->cutoff) {
+        int split = parallelPartition(ps, myCounters(ps), low, high);
+        int smallLow = low, smallHigh = split;
+        if (split - low >= high - split) {
+            smallLow = split + 1;
+            smallHigh = high;
+            high = split;
+        } else {
+            low = split + 1;
+        }
+
+        if (smallHigh - smallLow + 1 > ps->cutoff && spawnCount < QUICK_MAX_SPAWNS) {
+            spawned[spawnCount] = (RangeTask){ ps, smallLow, smallHigh };
+            poolSpawn(ps->pool, &group, quickTask, &spawned[spawnCount]);
+            spawnCount++;
+        } else {
+            sequentialQuick(ps, myCounters(ps), smallLow, smallHigh);
+        }
+    }
+    sequentialQuick(ps, myCounters(ps), low, high);
+    poolWait(ps->pool, &group);
+}
+
+int parallel_quick_sort(int* tab, int size, Stats_t* stats, ThreadPool* pool, int cutoff, OpSink* sink) {
+    ParallelSort ps;
+    memset(&ps, 0, sizeof(ps));
+    ps.tab = tab;
+    ps.size = size;
+    ps.cutoff = cutoff > 1 ? cutoff : 2;
+    ps.pool = pool;
+    ps.sink = sink;
+
+    RangeTask root = { &ps, 0, size - 1 };
+    poolRun(pool, quickTask, &root);
+    collectCounters(&ps, stats);
+    return 0;
+}
+
+/*
+----------------------------------------------------
+ PARALLEL MERGE SORT
+----------------------------------------------------
+ Sort both halves in parallel, merge them into the buffer in parallel,
+ then copy the merged range back into the array.
+----------------------------------------------------
+*/
+
+#define MERGE_INSERTION_CUTOFF 16 // runs this short are sorted by insertion (networks off)
+
+// Merge task: tab[low1..high1) and tab[low2..high2) into buffer[out ..).
+// 'leftFirst' tells which run comes first in the array (for stability).
+typedef struct {
+    ParallelSort* ps;
+    int low1, high1;
+    int low2, high2;
+    int out;
+    int leftFirst;
+} MergeTask;
+
+// Insertion sort of a small range tab[low..high).
+static void insertionRange(ParallelSort* ps, WorkerCounters* c, int low, int high) {
+    int* tab = ps->tab;
+    for (int i = low + 1; i < high; i++) {
+        c->memoryAccesses++; // read key
+        int key = tab[i];
+        int j = i - 1;
+        c->comparisons++;
+        c->memoryAccesses++;
+        emit(ps, makeTraceOp(TRACE_COMPARE, j, i));
+        while (j >= low && tab[j] > key) {
+            c->memoryAccesses += 2;
+            tab[j + 1] = tab[j];
+            emit(ps, makeTraceOp(TRACE_WRITE, j + 1, tab[j]));
+            j--;
+        }
+        c->memoryAccesses++; // write key
+        tab[j + 1] = key;
+        emit(ps, makeTraceOp(TRACE_WRITE, j + 1, key));
+    }
+}
+
+// First index in tab[low..high) whose value is >= value (or > value when 'strict').
+static int searchRun(ParallelSort* ps, WorkerCounters* c, int low, int high, int value, int strict) {
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        c->comparisons++;
+        c->memoryAccesses++;
+        if (ps->tab[mid] < value || (strict && ps->tab[mid] == value)) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+static void sequentialMerge(ParallelSort* ps, WorkerCounters* c, MergeTask* m) {
+    int* tab = ps->tab;
+    int i = m->low1, j = m->low2, k = m->out;
+
+    // when the runs were swapped, ties go to run 2 (it comes first in the array)
+    while (i < m->high1 && j < m->high2) {
+        c->comparisons++;
+        c->memoryAccesses += 3; // 2 reads + 1 write
+        emit(ps, makeTraceOp(TRACE_COMPARE, i, j));
+        int takeFirst = m->leftFirst ? (tab[i] <= tab[j]) : (tab[i] < tab[j]);
+        ps->buffer[k++] = takeFirst ? tab[i++] : tab[j++];
+    }
+    while (i < m->high1) { c->memoryAccesses += 2; ps->buffer[k++] = tab[i++]; }
+    while (j < m->high2) { c->memoryAccesses += 2; ps->buffer[k++] = tab[j++]; }
+}
+
+static void mergeTask(void* arg) {
+    MergeTask* m = (MergeTask*)arg;
+    ParallelSort* ps = m->ps;
+    WorkerCounters* c = myCounters(ps);
+    int length1 = m->high1 - m->low1;
+    int length2 = m->high2 - m->low2;
+
+    if (length1 + length2 <= ps->cutoff) {
+        sequentialMerge(ps, c, m);
+        return;
+    }
+
+    // split around the median of the larger run
+    if (length1 < length2) {
+        MergeTask swapped = { ps, m->low2, m->high2, m->low1, m->high1, m->out, !m->leftFirst };
+        mergeTask(&swapped);
+        return;
+    }
+    int mid1 = m->low1 + length1 / 2;
+    c->memoryAccesses++;
+    int pivot = ps->tab[mid1];
+    // run 1 first: run-2 elements equal to the pivot go after it (and before it otherwise)
+    int mid2 = searchRun(ps, c, m->low2, m->high2, pivot, !m->leftFirst);
+
+    int outMid = m->out + (mid1 - m->low1) + (mid2 - m->low2);
+    c->memoryAccesses++;
+    ps->buffer[outMid] = pivot;
+
+    TaskGroup group;
+    atomic_init(&group.pending, 0);
+    MergeTask lower = { ps, m->low1, mid1, m->low2, mid2, m->out, m->leftFirst };
+    MergeTask upper = { ps, mid1 + 1, m->high1, mid2, m->high2, outMid + 1, m->leftFirst };
+    poolSpawn(ps->pool, &group, mergeTask, &lower);
+    mergeTask(&upper);
+    poolWait(ps->pool, &group);
+}
+
+// Copies buffer[low..high) back into the array, in parallel chunks.
+static void copyBackTask(void* arg) {
+    RangeTask* task = (RangeTask*)arg;
+    ParallelSort* ps = task->ps;
+
+    if (task->high - task->low > 4 * ps->cutoff) {
+        int mid = task->low + (task->high - task->low) / 2;
+        TaskGroup group;
+        atomic_init(&group.pending, 0);
+        RangeTask left = { ps, task->low, mid };
+        RangeTask right = { ps, mid, task->high };
+        poolSpawn(ps->pool, &group, copyBackTask, &left);
+        copyBackTask(&right);
+        poolWait(ps->pool, &group);
+        return;
+    }
+
+    WorkerCounters* c = myCounters(ps);
+    for (int i = task->low; i < task->high; i++) {
+        ps->tab[i] = ps->buffer[i];
+        emit(ps, makeTraceOp(TRACE_WRITE, i, ps->buffer[i]));
+    }
+    c->memoryAccesses += 2LL * (task->high - task->low);
+}
+
+// Sorts tab[low..high). Splits are spawned as tasks only above the cutoff.
+static void mergeSortTask(void* arg) {
+    RangeTask* task = (RangeTask*)arg;
+    ParallelSort* ps = task->ps;
+    int low = task->low, high = task->high;
+
+    if (high - low < 2) return;
+    emit(ps, makeOwnerOp(low, high - 1, poolWorkerId()));
+
+    if (networkLeaf(ps, myCounters(ps), low, high - low)) return;
+    if (high - low <= MERGE_INSERTION_CUTOFF) {
+        insertionRange(ps, myCounters(ps), low, high);
+        return;
+    }
+
+    int mid = low + (high - low) / 2;
+    RangeTask left = { ps, low, mid };
+    RangeTask right = { ps, mid, high };
+    if (high - low > ps->cutoff) {
+        TaskGroup group;
+        atomic_init(&group.pending, 0);
+        poolSpawn(ps->pool, &group, mergeSortTask, &left);
+        mergeSortTask(&right);
+        poolWait(ps->pool, &group);
+    } else {
+        mergeSortTask(&left);
+        mergeSortTask(&right);
+    }
+
+    // both halves sorted: merge then copy back
+    emit(ps, makeOwnerOp(low, high - 1, poolWorkerId()));
+    MergeTask merge = { ps, low, mid, mid, high, low, 1 };
+    mergeTask(&merge);
+    RangeTask copy = { ps, low, high };
+    copyBackTask(&copy);
+}
+
+int parallel_merge_sort(int* tab, int size, Stats_t* stats, ThreadPool* pool, Arena* arena, int cutoff, OpSink* sink) {
+    ParallelSort ps;
+    memset(&ps, 0, sizeof(ps));
+    ps.tab = tab;
+    ps.size = size;
+    ps.cutoff = cutoff > 1 ? cutoff : 2;
+    ps.pool = pool;
+    ps.sink = sink;
+    ps.buffer = (int*)arenaAlloc(arena, size * sizeof(int), stats);
+    if (ps.buffer == NULL) return -1;
+
+    RangeTask root = { &ps, 0, size };
+    poolRun(pool, mergeSortTask, &root);
+    collectCounters(&ps, stats);
+
+    arenaFree(arena, ps.buffer, size * sizeof(int), stats);
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include "perf.h"
+#include <stdio.h>  // For the warning on stderr
+#include <string.h> // For memset
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static int perfEnabled = 1;
+static int warned = 0; // the reason counters are missing is printed once
+
+static const char* names[HW_COUNTER_COUNT] = {
+    "cycles", "instructions", "branch_misses", "l1d_misses", "llc_misses", "dtlb_misses",
+};
+
+void setPerfEnabled(int enabled) {
+    perfEnabled = enabled;
+}
+
+const char* perfCounterName(int counter) {
+    if (counter < 0 || counter >= HW_COUNTER_COUNT) return "unknown";
+    return names[counter];
+}
+
+#ifdef __linux__
+
+// perf_event_attr type / config of each counter
+static void counterEvent(int counter, struct perf_event_attr* attr) {
+    // generic cache events: cache | (operation << 8) | (result << 16)
+    unsigned long long readMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr->type = PERF_TYPE_HARDWARE;
+    switch (counter) {
+        case HW_CYCLES:        attr->config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case HW_INSTRUCTIONS:  attr->config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case HW_BRANCH_MISSES: attr->config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        case HW_LLC_MISSES:    attr->config = PERF_COUNT_HW_CACHE_MISSES; break;
+        case HW_L1D_MISSES:
+            attr->type = PERF_TYPE_HW_CACHE;
+            attr->config = PERF_COUNT_HW_CACHE_L1D | readMiss;
+            break;
+        default: // HW_DTLB_MISSES
+            attr->type = PERF_TYPE_HW_CACHE;
+            attr->config = PERF_COUNT_HW_CACHE_DTLB | readMiss;
+            break;
+    }
+}
+
+static int openCounter(int counter, int thread) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    counterEvent(counter, &attr);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1; // allowed with the default perf_event_paranoid (2)
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, thread, -1, -1, 0);
+}
+
+static void warn(int error) {
+    if (warned) return;
+    warned = 1;
+    if (error == EACCES || error == EPERM) {
+        fprintf(stderr, "Hardware counters: not allowed (see /proc/sys/kernel/perf_event_paranoid).\n");
+    } else if (error == ENOSYS) {
+        fprintf(stderr, "Hardware counters: perf_event_open is not available.\n");
+    } else {
+        fprintf(stderr, "Hardware counters: some are not supported here (%s).\n", strerror(error));
+    }
+}
+
+unsigned int perfOpen(PerfCounters* perf, ThreadPool* pool) {
+    memset(perf->fds, -1, sizeof(perf->fds));
+    perf->opened = 0;
+    perf->threadCount = 0;
+    if (!perfEnabled) return 0;
+
+    // calling thread first (worker 0 of the pool), then the other workers
+    int threads[POOL_MAX_THREADS];
+    threads[perf->threadCount++] = 0;
+    for (int w = 1; pool != NULL && w < pool->threadCount; w++) {
+        if (pool->systemIds[w] != 0) threads[perf->threadCount++] = pool->systemIds[w];
+    }
+
+    unsigned int opened = (1u << HW_COUNTER_COUNT) - 1;
+    int error = 0;
+    for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+        for (int t = 0; t < perf->threadCount && (opened & (1u << c)); t++) {
+            perf->fds[t][c] = openCounter(c, threads[t]);
+            if (perf->fds[t][c] < 0) {
+                error = errno;
+                opened &= ~(1u << c);
+            }
+        }
+    }
+    if (opened != (1u << HW_COUNTER_COUNT) - 1) warn(error);
+
+    // a counter missing on one thread is not used at all
+    for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+        if (opened & (1u << c)) continue;
+        for (int t = 0; t < perf->threadCount; t++) {
+            if (perf->fds[t][c] >= 0) close(perf->fds[t][c]);
+            perf->fds[t][c] = -1;
+        }
+    }
+    perf->opened = opened;
+    return opened;
+}
+
+static void perfControl(PerfCounters* perf, unsigned long request) {
+    for (int t = 0; t < perf->threadCount; t++) {
+        for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+            if (perf->fds[t][c] >= 0) ioctl(perf->fds[t][c], request, 0);
+        }
+    }
+}
+
+void perfEnable(PerfCounters* perf) {
+    perfControl(perf, PERF_EVENT_IOC_ENABLE);
+}
+
+void perfDisable(PerfCounters* perf) {
+    perfControl(perf, PERF_EVENT_IOC_DISABLE);
+}
+
+void perfRead(PerfCounters* perf, Stats_t* stats) {
+    for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+        if (!(perf->opened & (1u << c))) continue;
+
+        double total = 0.0;
+        int measured = 0;
+        for (int t = 0; t < perf->threadCount; t++) {
+            unsigned long long values[3]; // value, time enabled, time running
+            if (read(perf->fds[t][c], values, sizeof(values)) != (ssize_t)sizeof(values)) continue;
+            if (values[2] == 0) continue; // never scheduled on the PMU
+            // multiplexed: extrapolate to the whole time the counter was enabled
+            total += (double)values[0] * ((double)values[1] / (double)values[2]);
+            measured = 1;
+        }
+        if (measured) {
+            stats->hardware[c] += (long long)(total + 0.5);
+            stats->hardwareValid |= 1u << c;
+        }
+    }
+}
+
+void perfClose(PerfCounters* perf) {
+    for (int t = 0; t < perf->threadCount; t++) {
+        for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+            if (perf->fds[t][c] >= 0) close(perf->fds[t][c]);
+            perf->fds[t][c] = -1;
+        }
+    }
+    perf->threadCount = 0;
+    perf->opened = 0;
+}
+
+#else // no perf_event_open: nothing is ever measured
+
+unsigned int perfOpen(PerfCounters* perf, ThreadPool* pool) {
+    (void)pool;
+    memset(perf, 0, sizeof(*perf));
+    if (perfEnabled && !warned) {
+        warned = 1;
+        fprintf(stderr, "Hardware counters: only available on Linux.\n");
+    }
+    return 0;
+}
+
+void perfEnable(PerfCounters* perf) { (void)perf; }
+void perfDisable(PerfCounters* perf) { (void)perf; }
+void perfRead(PerfCounters* perf, Stats_t* stats) { (void)perf; (void)stats; }
+void perfClose(PerfCounters* perf) { (void)perf; }
+
+#endif
@@ -0,0 +1,272 @@
+#define _GNU_SOURCE // For CPU_SET and pthread_setaffinity_np (Linux)
+#include "pool.h"
+#include <sched.h>  // For sched_yield
+#include <stdlib.h> // For malloc/free
+#include <string.h> // For memset
+#include <unistd.h> // For sysconf
+#ifdef __linux__
+#include <sys/syscall.h> // For SYS_gettid
+#endif
+
+static _Thread_local int currentWorker = 0;
+
+// Worker thread argument
+typedef struct {
+    ThreadPool* pool;
+    int id;
+} WorkerStart;
+
+/*
+----------------------------------------------------
+ DEQUE
+----------------------------------------------------
+ A mutex per deque is enough here: tasks are coarse (thousands of elements)
+ so the lock is taken rarely compared to the sorting work.
+----------------------------------------------------
+*/
+static int dequeInit(TaskDeque* deque) {
+    deque->capacity = 256;
+    deque->tasks = (Task*)malloc(deque->capacity * sizeof(Task));
+    deque->top = 0;
+    deque->bottom = 0;
+    pthread_mutex_init(&deque->lock, NULL);
+    return deque->tasks != NULL ? 0 : -1;
+}
+
+static void dequePush(TaskDeque* deque, Task task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom - deque->top == deque->capacity) {
+        // grow: unwrap the ring into a buffer twice as large
+        Task* grown = (Task*)malloc(deque->capacity * 2 * sizeof(Task));
+        if (grown == NULL) {
+            pthread_mutex_unlock(&deque->lock);
+            task.fn(task.arg); // no room: run it now
+            atomic_fetch_sub(&task.group->pending, 1);
+            return;
+        }
+        for (int i = deque->top; i < deque->bottom; i++) {
+            grown[i - deque->top] = deque->tasks[i & (deque->capacity - 1)];
+        }
+        free(deque->tasks);
+        deque->tasks = grown;
+        deque->bottom -= deque->top;
+        deque->top = 0;
+        deque->capacity *= 2;
+    }
+    deque->tasks[deque->bottom & (deque->capacity - 1)] = task;
+    deque->bottom++;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+// Owner side: newest task.
+static int dequePop(TaskDeque* deque, Task* out) {
+    int found = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom > deque->top) {
+        deque->bottom--;
+        *out = deque->tasks[deque->bottom & (deque->capacity - 1)];
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+// Thief side: oldest task.
+static int dequeSteal(TaskDeque* deque, Task* out) {
+    int found = 0;
+    if (pthread_mutex_trylock(&deque->lock) != 0) return 0; // busy: try another victim
+    if (deque->bottom > deque->top) {
+        *out = deque->tasks[deque->top & (deque->capacity - 1)];
+        deque->top++;
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+/*
+----------------------------------------------------
+ SCHEDULER
+----------------------------------------------------
+*/
+// Runs one task from the own deque or stolen from another worker.
+// return 0 if there was nothing to do.
+static int runOneTask(ThreadPool* pool, int id, unsigned int* seed) {
+    Task task;
+    int found = dequePop(&pool->deques[id], &task);
+
+    // steal, starting from a random victim
+    if (!found && pool->threadCount > 1) {
+        *seed = *seed * 1103515245u + 12345u;
+        int start = (int)((*seed >> 16) % (unsigned int)pool->threadCount);
+        for (int k = 0; k < pool->threadCount && !found; k++) {
+            int victim = (start + k) % pool->threadCount;
+            if (victim != id) found = dequeSteal(&pool->deques[victim], &task);
+        }
+    }
+    if (!found) return 0;
+
+    task.fn(task.arg);
+    if (pool->syncHook != NULL) pool->syncHook(pool->syncContext);
+    atomic_fetch_sub_explicit(&task.group->pending, 1, memory_order_release);
+    return 1;
+}
+
+static void* workerMain(void* data) {
+    WorkerStart* start = (WorkerStart*)data;
+    ThreadPool* pool = start->pool;
+    int id = start->id;
+    unsigned int seed = (unsigned int)id * 2654435761u;
+    free(start);
+
+    currentWorker = id;
+    pool->systemIds[id] = poolSystemThreadId();
+    atomic_fetch_add(&pool->started, 1);
+    while (!atomic_load(&pool->shutdown)) {
+        if (!atomic_load(&pool->running)) {
+            // nothing submitted: sleep until poolRun() or shutdown
+            pthread_mutex_lock(&pool->sleepLock);
+            while (!atomic_load(&pool->running) && !atomic_load(&pool->shutdown)) {
+                pthread_cond_wait(&pool->wake, &pool->sleepLock);
+            }
+            pthread_mutex_unlock(&pool->sleepLock);
+            continue;
+        }
+        if (!runOneTask(pool, id, &seed)) sched_yield();
+    }
+    return NULL;
+}
+
+int poolSystemThreadId(void) {
+#ifdef __linux__
+    return (int)syscall(SYS_gettid);
+#else
+    return 0;
+#endif
+}
+
+int poolPinThread(pthread_t thread, int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % poolCoreCount(), &set);
+    return pthread_setaffinity_np(thread, sizeof(set), &set) == 0 ? 0 : -1;
+#else
+    (void)thread;
+    (void)cpu;
+    return -1;
+#endif
+}
+
+int poolPinWorkers(ThreadPool* pool, int firstCpu) {
+    int status = 0;
+    for (int i = 1; i < pool->threadCount; i++) {
+        if (poolPinThread(pool->threads[i], firstCpu + i) != 0) status = -1;
+    }
+    return status;
+}
+
+int poolCoreCount(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+ThreadPool* createThreadPool(int threads) {
+    if (threads <= 0) threads = poolCoreCount();
+    if (threads > POOL_MAX_THREADS) threads = POOL_MAX_THREADS;
+
+    ThreadPool* pool = (ThreadPool*)malloc(sizeof(ThreadPool));
+    if (pool == NULL) return NULL;
+    memset(pool, 0, sizeof(ThreadPool));
+
+    pool->threadCount = threads;
+    pthread_mutex_init(&pool->sleepLock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    atomic_init(&pool->running, 0);
+    atomic_init(&pool->shutdown, 0);
+    atomic_init(&pool->started, 0);
+
+    for (int i = 0; i < threads; i++) {
+        if (dequeInit(&pool->deques[i]) != 0) {
+            pool->threadCount = i + 1; // so freeThreadPool cleans what exists
+            freeThreadPool(pool);
+            return NULL;
+        }
+    }
+
+    // worker 0 is the thread calling poolRun()
+    for (int i = 1; i < threads; i++) {
+        WorkerStart* start = (WorkerStart*)malloc(sizeof(WorkerStart));
+        if (start != NULL) {
+            start->pool = pool;
+            start->id = i;
+        }
+        if (start == NULL || pthread_create(&pool->threads[i], NULL, workerMain, start) != 0) {
+            free(start);
+            pool->threadCount = i; // run with the workers we got
+            break;
+        }
+    }
+    // every id known before the pool is used (counters are opened per thread)
+    while (atomic_load(&pool->started) < pool->threadCount - 1) sched_yield();
+    return pool;
+}
+
+void freeThreadPool(ThreadPool* pool) {
+    if (pool == NULL) return;
+
+    pthread_mutex_lock(&pool->sleepLock);
+    atomic_store(&pool->shutdown, 1);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->sleepLock);
+
+    for (int i = 1; i < pool->threadCount; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (int i = 0; i < pool->threadCount; i++) {
+        free(pool->deques[i].tasks);
+        pthread_mutex_destroy(&pool->deques[i].lock);
+    }
+    pthread_mutex_destroy(&pool->sleepLock);
+    pthread_cond_destroy(&pool->wake);
+    free(pool);
+}
+
+void poolSpawn(ThreadPool* pool, TaskGroup* group, TaskFn fn, void* arg) {
+    Task task = { fn, arg, group };
+    atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+    if (pool->syncHook != NULL) pool->syncHook(pool->syncContext);
+    dequePush(&pool->deques[currentWorker], task);
+}
+
+void poolSetSyncHook(ThreadPool* pool, void (*hook)(void* context), void* context) {
+    pool->syncHook = hook;
+    pool->syncContext = context;
+}
+
+void poolWait(ThreadPool* pool, TaskGroup* group) {
+    unsigned int seed = (unsigned int)currentWorker * 2654435761u + 1;
+    // help instead of blocking: the awaited tasks are probably in our own deque
+    while (atomic_load_explicit(&group->pending, memory_order_acquire) > 0) {
+        if (!runOneTask(pool, currentWorker, &seed)) sched_yield();
+    }
+}
+
+void poolRun(ThreadPool* pool, TaskFn fn, void* arg) {
+    int previous = currentWorker;
+    currentWorker = 0;
+
+    pthread_mutex_lock(&pool->sleepLock);
+    atomic_store(&pool->running, 1);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->sleepLock);
+
+    fn(arg);
+
+    atomic_store(&pool->running, 0);
+    currentWorker = previous;
+}
+
+int poolWorkerId(void) {
+    return currentWorker;
+}
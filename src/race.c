@@ -0,0 +1,202 @@
+#include "race.h"
+#include "visual.h" // For the bar caches
+#include "registry.h" // For the algorithm names
+#include <stdio.h>  // For error messages
+#include <stdlib.h> // For malloc/free
+#include <string.h> // For memcpy and memmove
+
+#define RACE_DRAIN_CHUNK 4096
+#define RACE_LOOKAHEAD (1 << 18) // minimum ops a lane's trace may hold beyond its replay
+
+Race* createRace(void) {
+    Race* race = (Race*)malloc(sizeof(Race));
+    if (race == NULL) return NULL;
+    memset(race, 0, sizeof(Race));
+    return race;
+}
+
+static void freeLane(RaceLane* lane) {
+    freeSortWorker(lane->worker); // stops the sort thread first
+    freeArena(lane->arena);
+    freeTrace(lane->trace);
+    freeStats(lane->stats);
+    freeBarCache(lane->bars);
+    free(lane->array);
+    free(lane->owners);
+    memset(lane, 0, sizeof(RaceLane));
+}
+
+void freeRace(Race* race) {
+    if (race == NULL) return;
+    for (int l = 0; l < race->laneCount; l++) freeLane(&race->lanes[l]);
+    free(race);
+}
+
+int hasRaceLane(const Race* race, int algorithm) {
+    for (int l = 0; l < race->laneCount; l++) {
+        if (race->lanes[l].algorithm == algorithm) return 1;
+    }
+    return 0;
+}
+
+int toggleRaceLane(Race* race, int algorithm) {
+    stopRace(race);
+    for (int l = 0; l < race->laneCount; l++) {
+        if (race->lanes[l].algorithm != algorithm) continue;
+        freeLane(&race->lanes[l]);
+        memmove(&race->lanes[l], &race->lanes[l + 1], (race->laneCount - l - 1) * sizeof(RaceLane));
+        race->laneCount--;
+        memset(&race->lanes[race->laneCount], 0, sizeof(RaceLane));
+        return 0;
+    }
+    if (race->laneCount == RACE_MAX_LANES) return -1;
+
+    RaceLane* lane = &race->lanes[race->laneCount];
+    memset(lane, 0, sizeof(RaceLane));
+    lane->algorithm = algorithm;
+    lane->bars = createBarCache();
+    lane->stats = createStats();
+    lane->arena = createArena(0);
+    lane->trace = createTrace();
+    lane->worker = createSortWorker(1 << 16);
+    lane->highlight1 = -1;
+    lane->highlight2 = -1;
+    if (!lane->bars || !lane->stats || !lane->arena || !lane->trace || !lane->worker) {
+        freeLane(lane);
+        return -1;
+    }
+    race->laneCount++;
+    return 0;
+}
+
+int startRace(Race* race, const int* array, int size, int k) {
+    stopRace(race);
+    // the lanes run at once: their pools split the cores instead of each taking them all
+    int threads = poolCoreCount() / (race->laneCount > 0 ? race->laneCount : 1);
+    if (threads < 1) threads = 1;
+    for (int l = 0; l < race->laneCount; l++) {
+        RaceLane* lane = &race->lanes[l];
+        if (lane->size != size) {
+            free(lane->array);
+            free(lane->owners);
+            lane->array = (int*)malloc(size * sizeof(int));
+            lane->owners = (unsigned char*)malloc(size);
+            lane->size = (lane->array && lane->owners) ? size : 0;
+            if (lane->size == 0) {
+                stopRace(race);
+                return -1;
+            }
+        }
+        if (setSortWorkerThreads(lane->worker, threads) != 0) {
+            fprintf(stderr, "Race: failed to resize the thread pool of %s.\n", algorithmInfo(lane->algorithm)->label);
+        }
+        memcpy(lane->array, array, size * sizeof(int));
+        memset(lane->owners, 0, size);
+        markAllBarsDirty(lane->bars);
+        resetStats(lane->stats);
+
+        // same array, same moment: the lanes only differ by their algorithm
+        if (startSortWorker(lane->worker, lane->algorithm, array, size, k, lane->stats, lane->arena) != 0) {
+            fprintf(stderr, "Race: failed to start %s.\n", algorithmInfo(lane->algorithm)->label);
+            stopRace(race);
+            return -1;
+        }
+        resetTrace(lane->trace, array, size);
+    }
+    race->started = 1;
+    return 0;
+}
+
+void stopRace(Race* race) {
+    for (int l = 0; l < race->laneCount; l++) {
+        RaceLane* lane = &race->lanes[l];
+        stopSortWorker(lane->worker);
+        resetTrace(lane->trace, NULL, 0);
+        lane->replayCursor = 0;
+        lane->highlight1 = -1;
+        lane->highlight2 = -1;
+    }
+    race->started = 0;
+}
+
+void pauseRace(Race* race, int paused) {
+    for (int l = 0; l < race->laneCount; l++) pauseSortWorker(race->lanes[l].worker, paused);
+}
+
+int raceLaneFinished(const RaceLane* lane) {
+    return atomic_load(&lane->worker->finished) && ringSize(lane->worker->ring) == 0;
+}
+
+// Moves the ops of the lane's sort thread into its trace (up to the lookahead)
+static void drainLane(RaceLane* lane, size_t lookahead) {
+    TraceOp chunk[RACE_DRAIN_CHUNK];
+    while (lane->trace->count < lane->replayCursor + lookahead && !lane->trace->failed) {
+        size_t n = ringPop(lane->worker->ring, chunk, RACE_DRAIN_CHUNK);
+        if (n == 0) break;
+        traceAppend(lane->trace, chunk, n);
+    }
+    if (lane->trace->failed) {
+        fprintf(stderr, "Race: trace of %s truncated (out of memory), sort stopped.\n",
+                algorithmInfo(lane->algorithm)->label);
+        stopSortWorker(lane->worker);
+    }
+    if (lane->worker->thread != NULL) readSortWorkerStats(lane->worker, lane->stats);
+}
+
+int updateRace(Race* race, int speed) {
+    int playing = 0;
+    size_t lookahead = (size_t)speed * 8;
+    if (lookahead < RACE_LOOKAHEAD) lookahead = RACE_LOOKAHEAD;
+    for (int l = 0; l < race->laneCount; l++) {
+        RaceLane* lane = &race->lanes[l];
+        if (lane->trace->keyframeCount == 0) continue; // not started
+        drainLane(lane, lookahead);
+
+        size_t next = lane->replayCursor + (size_t)speed;
+        if (next > lane->trace->count) next = lane->trace->count;
+        traceApply(lane->trace, lane->replayCursor, next, lane->array, lane->owners,
+                   &lane->highlight1, &lane->highlight2);
+        markTraceDirty(lane->bars, lane->trace, lane->replayCursor, next, lane->size);
+        lane->replayCursor = next;
+
+        if (raceLaneFinished(lane) && next == lane->trace->count) {
+            lane->highlight1 = -1; // done: clean bars
+            lane->highlight2 = -1;
+        } else {
+            playing = 1;
+        }
+    }
+    return playing;
+}
+
+void seekRace(Race* race, long long position, long long delta) {
+    for (int l = 0; l < race->laneCount; l++) {
+        RaceLane* lane = &race->lanes[l];
+        if (lane->trace->keyframeCount == 0) continue;
+        long long target = position;
+        if (position == -1) target = (long long)lane->trace->count;
+        else if (position == -2) target = (long long)lane->replayCursor + delta;
+        if (target < 0) target = 0;
+        if (target > (long long)lane->trace->count) target = (long long)lane->trace->count;
+
+        traceSeek(lane->trace, (size_t)target, lane->array, lane->owners, &lane->highlight1, &lane->highlight2);
+        markAllBarsDirty(lane->bars);
+        lane->replayCursor = (size_t)target;
+    }
+}
+
+int raceLaneRank(const Race* race, int lane) {
+    const RaceLane* self = &race->lanes[lane];
+    if (!race->started || !atomic_load(&self->worker->finished)) return 0;
+    int rank = 1;
+    for (int l = 0; l < race->laneCount; l++) {
+        const RaceLane* other = &race->lanes[l];
+        if (l == lane || !atomic_load(&other->worker->finished)) continue;
+        // ties broken by lane order so that two lanes never share a place
+        if (other->stats->executionTime < self->stats->executionTime ||
+            (other->stats->executionTime == self->stats->executionTime && l < lane)) {
+            rank++;
+        }
+    }
+    return rank;
+}
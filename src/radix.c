@@ -0,0 +1,301 @@
+#include "radix.h"
+#include <string.h> // For memset and memcpy
+
+#define RADIX_BUCKETS 256            // one byte per pass
+#define HISTOGRAM_MIN_CHUNK 16384    // smaller chunks cost more to merge than to count
+#define COUNTING_MAX_RANGE (1 << 27) // 512 MB of counts
+#define COUNTING_PARALLEL_RANGE 65536 // wider ranges: one histogram only
+
+// One chunk of the histogram pass. Exactly one of tab32 / tab64 is set.
+typedef struct {
+    const int* tab32;
+    const int64_t* tab64;
+    int minValue;   // counting sort: value of counts[0]
+    int low;
+    int high;       // exclusive
+    uint32_t* counts; // bytes per key * RADIX_BUCKETS, or range for counting sort
+    OpSink* sink;
+} HistogramTask;
+
+// All the chunks, spawned from inside poolRun()
+typedef struct {
+    ThreadPool* pool;
+    HistogramTask* tasks;
+    int taskCount;
+    TaskFn fn;
+} HistogramJob;
+
+static inline void emit(OpSink* sink, TraceOp op) {
+    if (sink != NULL) sink->push(sink->context, op);
+}
+
+// Signed keys flipped so that their unsigned order is the signed order
+static inline uint32_t key32(int value) {
+    return (uint32_t)value ^ 0x80000000u;
+}
+
+static inline uint64_t key64(int64_t value) {
+    return (uint64_t)value ^ 0x8000000000000000ull;
+}
+
+static void radixHistogramTask(void* arg) {
+    HistogramTask* task = (HistogramTask*)arg;
+    uint32_t* counts = task->counts;
+    emit(task->sink, makeOwnerOp(task->low, task->high - 1, poolWorkerId()));
+
+    if (task->tab32 != NULL) {
+        for (int i = task->low; i < task->high; i++) {
+            uint32_t key = key32(task->tab32[i]);
+            emit(task->sink, makeTraceOp(TRACE_READ, i, 0));
+            counts[0 * RADIX_BUCKETS + (key & 0xFF)]++;
+            counts[1 * RADIX_BUCKETS + ((key >> 8) & 0xFF)]++;
+            counts[2 * RADIX_BUCKETS + ((key >> 16) & 0xFF)]++;
+            counts[3 * RADIX_BUCKETS + (key >> 24)]++;
+        }
+    } else {
+        for (int i = task->low; i < task->high; i++) {
+            uint64_t key = key64(task->tab64[i]);
+            for (int pass = 0; pass < 8; pass++) {
+                counts[pass * RADIX_BUCKETS + ((key >> (8 * pass)) & 0xFF)]++;
+            }
+        }
+    }
+}
+
+static void countingHistogramTask(void* arg) {
+    HistogramTask* task = (HistogramTask*)arg;
+    uint32_t* counts = task->counts;
+    emit(task->sink, makeOwnerOp(task->low, task->high - 1, poolWorkerId()));
+
+    for (int i = task->low; i < task->high; i++) {
+        counts[task->tab32[i] - task->minValue]++;
+        emit(task->sink, makeTraceOp(TRACE_READ, i, 0));
+    }
+}
+
+static void histogramRoot(void* arg) {
+    HistogramJob* job = (HistogramJob*)arg;
+    TaskGroup group;
+    atomic_init(&group.pending, 0);
+    for (int t = 1; t < job->taskCount; t++) {
+        poolSpawn(job->pool, &group, job->fn, &job->tasks[t]);
+    }
+    job->fn(&job->tasks[0]);
+    poolWait(job->pool, &group);
+}
+
+// Splits [0, size) into at most maxTasks chunks, counts them (in parallel
+// when there is a pool) and sums the chunks into base->counts ('width'
+// counters). 'base' holds the fields shared by every chunk.
+static int runHistogram(HistogramTask* base, int size, int width, int maxTasks,
+                        ThreadPool* pool, Arena* arena, Stats_t* stats, TaskFn fn) {
+    int taskCount = size / HISTOGRAM_MIN_CHUNK;
+    if (taskCount > maxTasks) taskCount = maxTasks;
+    if (taskCount < 1 || pool == NULL) taskCount = 1;
+
+    size_t tasksBytes = taskCount * sizeof(HistogramTask);
+    size_t countsBytes = (size_t)taskCount * width * sizeof(uint32_t);
+    HistogramTask* tasks = (HistogramTask*)arenaAlloc(arena, tasksBytes, stats);
+    uint32_t* counts = (uint32_t*)arenaAlloc(arena, countsBytes, stats);
+    if (tasks == NULL || counts == NULL) {
+        arenaFree(arena, tasks, tasksBytes, stats);
+        arenaFree(arena, counts, countsBytes, stats);
+        return -1;
+    }
+    memset(counts, 0, countsBytes);
+
+    for (int t = 0; t < taskCount; t++) {
+        tasks[t] = *base;
+        tasks[t].low = (int)((long long)size * t / taskCount);
+        tasks[t].high = (int)((long long)size * (t + 1) / taskCount);
+        tasks[t].counts = counts + (size_t)t * width;
+    }
+
+    if (taskCount == 1) {
+        fn(&tasks[0]);
+    } else {
+        HistogramJob job = { pool, tasks, taskCount, fn };
+        poolRun(pool, histogramRoot, &job);
+        for (int t = 1; t < taskCount; t++) {
+            for (int b = 0; b < width; b++) counts[b] += tasks[t].counts[b];
+        }
+    }
+
+    memcpy(base->counts, counts, width * sizeof(uint32_t));
+    arenaFree(arena, tasks, tasksBytes, stats);
+    arenaFree(arena, counts, countsBytes, stats);
+    return 0;
+}
+
+/*
+----------------------------------------------------
+ COUNTING SORT
+----------------------------------------------------
+*/
+int counting_sort(int* tab, int size, Stats_t* stats, ThreadPool* pool, Arena* arena, OpSink* sink) {
+    if (size < 2) return 0;
+
+    // 1. value range
+    int minValue = tab[0], maxValue = tab[0];
+    emit(sink, makeTraceOp(TRACE_READ, 0, 0));
+    for (int i = 1; i < size; i++) {
+        stats->comparisons++;
+        emit(sink, makeTraceOp(TRACE_READ, i, 0));
+        if (tab[i] < minValue) {
+            minValue = tab[i];
+        } else {
+            stats->comparisons++;
+            if (tab[i] > maxValue) maxValue = tab[i];
+        }
+    }
+    stats->memoryAccesses += size;
+
+    long long range = (long long)maxValue - minValue + 1;
+    if (range > COUNTING_MAX_RANGE) return -1;
+
+    // 2. histogram (private copies per chunk only while they stay small)
+    size_t countsBytes = range * sizeof(uint32_t);
+    uint32_t* counts = (uint32_t*)arenaAlloc(arena, countsBytes, stats);
+    if (counts == NULL) return -1;
+    HistogramTask base;
+    memset(&base, 0, sizeof(base));
+    base.tab32 = tab;
+    base.minValue = minValue;
+    base.counts = counts;
+    base.sink = sink;
+    int maxTasks = (range <= COUNTING_PARALLEL_RANGE && pool != NULL) ? pool->threadCount : 1;
+    if (runHistogram(&base, size, (int)range, maxTasks, pool, arena, stats, countingHistogramTask) != 0) {
+        arenaFree(arena, counts, countsBytes, stats);
+        return -1;
+    }
+    stats->memoryAccesses += size;
+
+    // 3. rewrite the array from the counts
+    int position = 0;
+    for (long long v = 0; v < range; v++) {
+        int value = (int)(v + minValue);
+        for (uint32_t c = counts[v]; c > 0; c--) {
+            tab[position] = value;
+            emit(sink, makeTraceOp(TRACE_WRITE, position, value));
+            position++;
+        }
+    }
+    stats->memoryAccesses += size;
+
+    arenaFree(arena, counts, countsBytes, stats);
+    return 0;
+}
+
+/*
+----------------------------------------------------
+ LSD RADIX SORT
+----------------------------------------------------
+ The ops are emitted as reads and writes of the array itself, whichever of
+ the array and the buffer a pass goes from and to: after each pass the
+ window shows the array ordered by the bytes sorted so far.
+----------------------------------------------------
+*/
+int radix_sort(int* tab, int size, Stats_t* stats, ThreadPool* pool, Arena* arena, OpSink* sink) {
+    if (size < 2) return 0;
+
+    uint32_t counts[4 * RADIX_BUCKETS];
+    HistogramTask base;
+    memset(&base, 0, sizeof(base));
+    base.tab32 = tab;
+    base.counts = counts;
+    base.sink = sink;
+    if (runHistogram(&base, size, 4 * RADIX_BUCKETS, pool ? pool->threadCount : 1, pool, arena, stats,
+                     radixHistogramTask) != 0) {
+        return -1;
+    }
+    stats->memoryAccesses += size;
+
+    int* buffer = (int*)arenaAlloc(arena, size * sizeof(int), stats);
+    if (buffer == NULL) return -1;
+    int* src = tab;
+    int* dst = buffer;
+
+    for (int pass = 0; pass < 4; pass++) {
+        uint32_t* count = counts + pass * RADIX_BUCKETS;
+        int shift = 8 * pass;
+        if (count[(key32(src[0]) >> shift) & 0xFF] == (uint32_t)size) continue; // same byte everywhere
+
+        // prefix sums: first slot of each bucket
+        size_t offsets[RADIX_BUCKETS];
+        size_t sum = 0;
+        for (int b = 0; b < RADIX_BUCKETS; b++) {
+            offsets[b] = sum;
+            sum += count[b];
+        }
+
+        for (int i = 0; i < size; i++) {
+            int value = src[i];
+            emit(sink, makeTraceOp(TRACE_READ, i, 0));
+            size_t slot = offsets[(key32(value) >> shift) & 0xFF]++;
+            dst[slot] = value;
+            emit(sink, makeTraceOp(TRACE_WRITE, (uint32_t)slot, value));
+        }
+        stats->memoryAccesses += 2LL * size; // read + write
+
+        int* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != tab) {
+        memcpy(tab, src, size * sizeof(int)); // odd number of passes
+        stats->memoryAccesses += 2LL * size;
+    }
+    arenaFree(arena, buffer, size * sizeof(int), stats);
+    return 0;
+}
+
+int radix_sort64(int64_t* tab, int size, Stats_t* stats, ThreadPool* pool, Arena* arena) {
+    if (size < 2) return 0;
+
+    uint32_t counts[8 * RADIX_BUCKETS];
+    HistogramTask base;
+    memset(&base, 0, sizeof(base));
+    base.tab64 = tab;
+    base.counts = counts;
+    if (runHistogram(&base, size, 8 * RADIX_BUCKETS, pool ? pool->threadCount : 1, pool, arena, stats,
+                     radixHistogramTask) != 0) {
+        return -1;
+    }
+    stats->memoryAccesses += size;
+
+    int64_t* buffer = (int64_t*)arenaAlloc(arena, size * sizeof(int64_t), stats);
+    if (buffer == NULL) return -1;
+    int64_t* src = tab;
+    int64_t* dst = buffer;
+
+    for (int pass = 0; pass < 8; pass++) {
+        uint32_t* count = counts + pass * RADIX_BUCKETS;
+        int shift = 8 * pass;
+        if (count[(key64(src[0]) >> shift) & 0xFF] == (uint32_t)size) continue;
+
+        size_t offsets[RADIX_BUCKETS];
+        size_t sum = 0;
+        for (int b = 0; b < RADIX_BUCKETS; b++) {
+            offsets[b] = sum;
+            sum += count[b];
+        }
+
+        for (int i = 0; i < size; i++) {
+            int64_t value = src[i];
+            dst[offsets[(key64(value) >> shift) & 0xFF]++] = value;
+        }
+        stats->memoryAccesses += 2LL * size;
+
+        int64_t* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != tab) {
+        memcpy(tab, src, size * sizeof(int64_t));
+        stats->memoryAccesses += 2LL * size;
+    }
+    arenaFree(arena, buffer, size * sizeof(int64_t), stats);
+    return 0;
+}
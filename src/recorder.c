@@ -0,0 +1,243 @@
+#include "recorder.h"
+#include <stdlib.h> // For malloc/free
+#include <string.h> // For strcmp and memcpy
+#include <unistd.h> // For dup/dup2 (standard output)
+
+#define BAND_ROWS 32 // rows converted by one task (even: 4:2:0 takes rows in pairs)
+
+// One band of rows of the frame being converted
+typedef struct {
+    FrameWriter* writer;
+    const unsigned char* pixels;
+    int pitch;
+    int low;
+    int high; // exclusive
+    unsigned char* out;
+} ConvertTask;
+
+typedef struct {
+    ThreadPool* pool;
+    ConvertTask* tasks;
+    int taskCount;
+} ConvertJob;
+
+static inline uint32_t pixelAt(const unsigned char* pixels, int pitch, int x, int y) {
+    return ((const uint32_t*)(pixels + (size_t)y * pitch))[x];
+}
+
+// BT.601, limited range (what players assume for Y4M without a color tag)
+static inline unsigned char lumaOf(int r, int g, int b) {
+    return (unsigned char)(16 + ((66 * r + 129 * g + 25 * b + 128) >> 8));
+}
+
+static void convertY4M(ConvertTask* task) {
+    FrameWriter* writer = task->writer;
+    int width = writer->width, height = writer->height;
+    unsigned char* yPlane = task->out + writer->headerBytes;
+    unsigned char* uPlane = yPlane + (size_t)width * height;
+    unsigned char* vPlane = uPlane + (size_t)(width / 2) * (height / 2);
+
+    for (int y = task->low; y < task->high; y += 2) {
+        for (int x = 0; x < width; x += 2) {
+            // one chroma sample from the mean of the 2x2 block
+            int r = 0, g = 0, b = 0;
+            for (int dy = 0; dy < 2; dy++) {
+                for (int dx = 0; dx < 2; dx++) {
+                    uint32_t p = pixelAt(task->pixels, task->pitch, x + dx, y + dy);
+                    int pr = (p >> 16) & 0xFF, pg = (p >> 8) & 0xFF, pb = p & 0xFF;
+                    yPlane[(size_t)(y + dy) * width + x + dx] = lumaOf(pr, pg, pb);
+                    r += pr;
+                    g += pg;
+                    b += pb;
+                }
+            }
+            r = (r + 2) >> 2;
+            g = (g + 2) >> 2;
+            b = (b + 2) >> 2;
+            size_t c = (size_t)(y / 2) * (width / 2) + x / 2;
+            uPlane[c] = (unsigned char)(128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8));
+            vPlane[c] = (unsigned char)(128 + ((112 * r - 94 * g - 18 * b + 128) >> 8));
+        }
+    }
+}
+
+static void convertPPM(ConvertTask* task) {
+    FrameWriter* writer = task->writer;
+    for (int y = task->low; y < task->high; y++) {
+        unsigned char* row = task->out + writer->headerBytes + (size_t)y * writer->width * 3;
+        for (int x = 0; x < writer->width; x++) {
+            uint32_t p = pixelAt(task->pixels, task->pitch, x, y);
+            row[3 * x] = (p >> 16) & 0xFF;
+            row[3 * x + 1] = (p >> 8) & 0xFF;
+            row[3 * x + 2] = p & 0xFF;
+        }
+    }
+}
+
+static void convertTask(void* arg) {
+    ConvertTask* task = (ConvertTask*)arg;
+    if (task->writer->format == FRAME_Y4M) convertY4M(task);
+    else convertPPM(task);
+}
+
+static void convertRoot(void* arg) {
+    ConvertJob* job = (ConvertJob*)arg;
+    TaskGroup group;
+    atomic_init(&group.pending, 0);
+    for (int t = 1; t < job->taskCount; t++) poolSpawn(job->pool, &group, convertTask, &job->tasks[t]);
+    convertTask(&job->tasks[0]);
+    poolWait(job->pool, &group);
+}
+
+// Writer thread: sends the converted buffers to the file in order
+static void* writerMain(void* arg) {
+    FrameWriter* writer = (FrameWriter*)arg;
+    int current = 0;
+    pthread_mutex_lock(&writer->lock);
+    while (1) {
+        while (!writer->pending[current] && !writer->stop) pthread_cond_wait(&writer->changed, &writer->lock);
+        if (!writer->pending[current]) break; // stopped with nothing left
+        pthread_mutex_unlock(&writer->lock);
+
+        int failed = fwrite(writer->buffers[current], 1, writer->frameBytes, writer->file) != writer->frameBytes;
+
+        pthread_mutex_lock(&writer->lock);
+        if (failed) writer->failed = 1;
+        writer->pending[current] = 0;
+        pthread_cond_broadcast(&writer->changed);
+        current = 1 - current;
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+int frameFormatFromName(const char* name) {
+    if (strcmp(name, "y4m") == 0) return FRAME_Y4M;
+    if (strcmp(name, "ppm") == 0) return FRAME_PPM;
+    return -1;
+}
+
+// Standard output for the video only: the program's messages go to stderr
+static FILE* openStandardOutput(void) {
+    fflush(stdout);
+    int fd = dup(STDOUT_FILENO);
+    if (fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) return NULL;
+    return fdopen(fd, "wb");
+}
+
+FrameWriter* createFrameWriter(const char* path, int format, int width, int height, int fps) {
+    width &= ~1;
+    height &= ~1;
+    if (width < 2 || height < 2 || fps < 1) {
+        fprintf(stderr, "Recording: invalid frame size or rate.\n");
+        return NULL;
+    }
+    FrameWriter* writer = (FrameWriter*)malloc(sizeof(FrameWriter));
+    if (writer == NULL) return NULL;
+    memset(writer, 0, sizeof(FrameWriter));
+    writer->format = format;
+    writer->width = width;
+    writer->height = height;
+
+    char header[64];
+    if (format == FRAME_Y4M) {
+        writer->headerBytes = 6; // "FRAME\n"
+        writer->frameBytes = writer->headerBytes + (size_t)width * height * 3 / 2;
+    } else {
+        writer->headerBytes = (size_t)snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+        writer->frameBytes = writer->headerBytes + (size_t)width * height * 3;
+    }
+
+    writer->file = (strcmp(path, "-") == 0) ? openStandardOutput() : fopen(path, "wb");
+    writer->pool = createThreadPool(0);
+    for (int b = 0; b < 2; b++) writer->buffers[b] = (unsigned char*)malloc(writer->frameBytes);
+    if (writer->file == NULL || writer->pool == NULL || writer->buffers[0] == NULL || writer->buffers[1] == NULL) {
+        fprintf(stderr, "Recording: cannot open %s or out of memory.\n", path);
+        if (writer->file != NULL) fclose(writer->file);
+        freeThreadPool(writer->pool);
+        free(writer->buffers[0]);
+        free(writer->buffers[1]);
+        free(writer);
+        return NULL;
+    }
+
+    // the frame header never changes: written once into both buffers
+    for (int b = 0; b < 2; b++) {
+        if (format == FRAME_Y4M) memcpy(writer->buffers[b], "FRAME\n", 6);
+        else memcpy(writer->buffers[b], header, writer->headerBytes);
+    }
+    if (format == FRAME_Y4M) {
+        fprintf(writer->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+    }
+
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->changed, NULL);
+    if (pthread_create(&writer->thread, NULL, writerMain, writer) != 0) {
+        fprintf(stderr, "Recording: failed to create the writer thread.\n");
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->changed);
+        fclose(writer->file);
+        freeThreadPool(writer->pool);
+        free(writer->buffers[0]);
+        free(writer->buffers[1]);
+        free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+int writeFrame(FrameWriter* writer, const void* pixels, int pitch) {
+    int b = writer->next;
+
+    // the buffer is free again once the writer is done with the frame before last
+    pthread_mutex_lock(&writer->lock);
+    while (writer->pending[b]) pthread_cond_wait(&writer->changed, &writer->lock);
+    int failed = writer->failed;
+    pthread_mutex_unlock(&writer->lock);
+    if (failed) return -1;
+
+    ConvertTask tasks[(4096 + BAND_ROWS - 1) / BAND_ROWS];
+    int maxTasks = (int)(sizeof(tasks) / sizeof(tasks[0]));
+    int bandRows = BAND_ROWS;
+    while ((writer->height + bandRows - 1) / bandRows > maxTasks) bandRows *= 2; // very tall frames
+    int taskCount = 0;
+    for (int low = 0; low < writer->height; low += bandRows) {
+        ConvertTask* task = &tasks[taskCount++];
+        task->writer = writer;
+        task->pixels = (const unsigned char*)pixels;
+        task->pitch = pitch;
+        task->low = low;
+        task->high = (low + bandRows < writer->height) ? low + bandRows : writer->height;
+        task->out = writer->buffers[b];
+    }
+    ConvertJob job = { writer->pool, tasks, taskCount };
+    poolRun(writer->pool, convertRoot, &job);
+
+    pthread_mutex_lock(&writer->lock);
+    writer->pending[b] = 1;
+    pthread_cond_broadcast(&writer->changed);
+    pthread_mutex_unlock(&writer->lock);
+    writer->next = 1 - b;
+    writer->frames++;
+    return 0;
+}
+
+int closeFrameWriter(FrameWriter* writer) {
+    if (writer == NULL) return 0;
+    pthread_mutex_lock(&writer->lock);
+    writer->stop = 1;
+    pthread_cond_broadcast(&writer->changed);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL); // writes what is still pending first
+
+    int status = writer->failed ? -1 : 0;
+    if (fclose(writer->file) != 0) status = -1;
+    if (status != 0) fprintf(stderr, "Recording: write error, the video is truncated.\n");
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->changed);
+    freeThreadPool(writer->pool);
+    free(writer->buffers[0]);
+    free(writer->buffers[1]);
+    free(writer);
+    return status;
+}
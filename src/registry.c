@@ -0,0 +1,296 @@
+#include "registry.h"
+#include "kernels.h"
+#include "parallel.h"
+#include "introsort.h"
+#include "radix.h"
+#include "external.h"
+#include "adaptive.h"
+#include "strsort.h"
+#include <ctype.h>  // For toupper
+#include <dlfcn.h>  // For dlopen
+#include <stdio.h>  // For error messages
+#include <string.h> // For strcmp and strchr
+
+/*
+----------------------------------------------------
+ BUILT-IN ENTRY POINTS
+----------------------------------------------------
+ The kernels keep their own signatures; these adapt them to SortEntry.
+ The step-machine sorts (1 to 4) run their headless kernel (kernels.h)
+ here: the window steps them through sorting.c instead.
+----------------------------------------------------
+*/
+static int runBubble(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)context; (void)sink;
+    kernel_bubble_sort(tab, size, stats);
+    return 0;
+}
+
+static int runSelection(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)context; (void)sink;
+    kernel_selection_sort(tab, size, stats);
+    return 0;
+}
+
+static int runInsertion(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)context; (void)sink;
+    kernel_insertion_sort(tab, size, stats);
+    return 0;
+}
+
+static int runQuick(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)context; (void)sink;
+    kernel_quick_sort(tab, size, stats);
+    return 0;
+}
+
+static int runParallelQuick(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    return parallel_quick_sort(tab, size, stats, context->pool, context->cutoff, sink);
+}
+
+static int runParallelMerge(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    return parallel_merge_sort(tab, size, stats, context->pool, context->arena, context->cutoff, sink);
+}
+
+static int runIntro(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)context;
+    intro_sort(tab, size, stats, sink);
+    return 0;
+}
+
+static int runCounting(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    return counting_sort(tab, size, stats, context->pool, context->arena, sink);
+}
+
+static int runRadix(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    return radix_sort(tab, size, stats, context->pool, context->arena, sink);
+}
+
+// 8 runs: each one formed in place, then one 8-way loser tree merge
+static int runExternal(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    return external_sort(tab, size, (size + 7) / 8, stats, context->arena, sink);
+}
+
+static int runTim(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    return tim_sort(tab, size, stats, context->arena, sink);
+}
+
+static int runPdq(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    (void)context;
+    pdq_sort(tab, size, stats, sink);
+    return 0;
+}
+
+static int runQuickSelect(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    quick_select(tab, size, context->k, stats, sink);
+    return 0;
+}
+
+static int runHeapTopK(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    heap_top_k(tab, size, context->k, stats, sink);
+    return 0;
+}
+
+static int runPartialSort(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    partial_sort(tab, size, context->k, stats, sink);
+    return 0;
+}
+
+// String sorts: the ints are sorted as their keys (strsort.h, same order),
+// built from the context's arena inside the run like the bench's conversions
+static int runStringSort(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink, int algorithm) {
+    const char** keys = createStringKeys(tab, size, stringShape(), context->arena);
+    if (keys == NULL) return -1;
+    if (algorithm == 0) string_multikey_sort(keys, tab, size, stats, sink);
+    else if (algorithm == 1) return string_msd_radix_sort(keys, tab, size, stats, context->arena, sink);
+    else string_intro_sort(keys, tab, size, stats, sink);
+    return 0;
+}
+
+static int runMultikey(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    return runStringSort(tab, size, context, stats, sink, 0);
+}
+
+static int runStringRadix(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    return runStringSort(tab, size, context, stats, sink, 1);
+}
+
+static int runStringIntro(int* tab, int size, const SortContext* context, Stats_t* stats, OpSink* sink) {
+    return runStringSort(tab, size, context, stats, sink, 2);
+}
+
+static int rawStringSort(int* tab, int size, const SortContext* context, int algorithm) {
+    const char** keys = createStringKeys(tab, size, stringShape(), context->arena);
+    if (keys == NULL) return -1;
+    if (algorithm == 0) string_multikey_sort_raw(keys, tab, size);
+    else if (algorithm == 1) return string_msd_radix_sort_raw(keys, tab, size, context->arena);
+    else string_intro_sort_raw(keys, tab, size);
+    return 0;
+}
+
+static int rawBubble(int* tab, int size, const SortContext* context) { (void)context; kernel_bubble_sort_raw(tab, size); return 0; }
+static int rawSelection(int* tab, int size, const SortContext* context) { (void)context; kernel_selection_sort_raw(tab, size); return 0; }
+static int rawInsertion(int* tab, int size, const SortContext* context) { (void)context; kernel_insertion_sort_raw(tab, size); return 0; }
+static int rawQuick(int* tab, int size, const SortContext* context) { (void)context; kernel_quick_sort_raw(tab, size); return 0; }
+static int rawIntro(int* tab, int size, const SortContext* context) { (void)context; intro_sort_raw(tab, size); return 0; }
+static int rawTim(int* tab, int size, const SortContext* context) { (void)context; return tim_sort_raw(tab, size); }
+static int rawPdq(int* tab, int size, const SortContext* context) { (void)context; pdq_sort_raw(tab, size); return 0; }
+static int rawQuickSelect(int* tab, int size, const SortContext* context) { quick_select_raw(tab, size, context->k); return 0; }
+static int rawHeapTopK(int* tab, int size, const SortContext* context) { heap_top_k_raw(tab, size, context->k); return 0; }
+static int rawPartialSort(int* tab, int size, const SortContext* context) { partial_sort_raw(tab, size, context->k); return 0; }
+static int rawMultikey(int* tab, int size, const SortContext* context) { return rawStringSort(tab, size, context, 0); }
+static int rawStringRadix(int* tab, int size, const SortContext* context) { return rawStringSort(tab, size, context, 1); }
+static int rawStringIntro(int* tab, int size, const SortContext* context) { return rawStringSort(tab, size, context, 2); }
+
+#define ALL_KEYS (KEY_INT32 | KEY_INT64 | KEY_FLOAT64 | KEY_RECORD) // intro and merge: typed.h
+
+static const AlgorithmInfo builtins[] = {
+    // name          label               key  machine run               raw             stable memory                keyTypes               flags               failure
+    { "bubble",      "Bubble Sort",      '1', 1, runBubble,        rawBubble,      1, ALGO_MEMORY_CONSTANT, KEY_INT32,             ALGO_QUADRATIC,     NULL },
+    { "selection",   "Selection Sort",   '2', 2, runSelection,     rawSelection,   0, ALGO_MEMORY_CONSTANT, KEY_INT32,             ALGO_QUADRATIC,     NULL },
+    { "insertion",   "Insertion Sort",   '3', 3, runInsertion,     rawInsertion,   1, ALGO_MEMORY_CONSTANT, KEY_INT32,             ALGO_QUADRATIC,     NULL },
+    { "quick",       "Quick Sort",       '4', 4, runQuick,         rawQuick,       0, ALGO_MEMORY_LOG,      KEY_INT32,             ALGO_ADVERSARIAL,   NULL },
+    { "pquick",      "Parallel Quick",   '5', 0, runParallelQuick, NULL,           0, ALGO_MEMORY_LOG,      KEY_INT32,             ALGO_PARALLEL,      NULL },
+    { "pmerge",      "Parallel Merge",   '6', 0, runParallelMerge, NULL,           0, ALGO_MEMORY_LINEAR,   KEY_INT32,             ALGO_PARALLEL,
+      "failed to allocate the merge buffer" },
+    { "intro",       "Intro Sort",       '7', 0, runIntro,         rawIntro,       0, ALGO_MEMORY_LOG,      ALL_KEYS,              0,                  NULL },
+    { "counting",    "Counting Sort",    '8', 0, runCounting,      NULL,           0, ALGO_MEMORY_RANGE,    KEY_INT32,             ALGO_PARALLEL,
+      "value range too wide or out of memory" },
+    { "radix",       "Radix Sort",       '9', 0, runRadix,         NULL,           1, ALGO_MEMORY_LINEAR,   KEY_INT32 | KEY_INT64, ALGO_PARALLEL,
+      "failed to allocate the buffer" },
+    { "external",    "External Merge",   '0', 0, runExternal,      NULL,           0, ALGO_MEMORY_LINEAR,   KEY_INT32,             0,
+      "failed to allocate the merge buffer" },
+    { "tim",         "TimSort",          'T', 0, runTim,           rawTim,         1, ALGO_MEMORY_LINEAR,   KEY_INT32,             0,
+      "failed to allocate the merge buffer" },
+    { "pdq",         "Pdq Sort",         'P', 0, runPdq,           rawPdq,         0, ALGO_MEMORY_LOG,      KEY_INT32,             0,                  NULL },
+    { "quickselect", "Quickselect",      'M', 0, runQuickSelect,   rawQuickSelect, 0, ALGO_MEMORY_CONSTANT, KEY_INT32,             ALGO_SELECT_NTH,    NULL },
+    { "topk",        "Heap Top-k",       'K', 0, runHeapTopK,      rawHeapTopK,    0, ALGO_MEMORY_CONSTANT, KEY_INT32,             ALGO_SELECT_PREFIX, NULL },
+    { "partial",     "Partial Sort",     'L', 0, runPartialSort,   rawPartialSort, 0, ALGO_MEMORY_LOG,      KEY_INT32,             ALGO_SELECT_PREFIX, NULL },
+    { "multikey",    "String Multikey",  'Q', 0, runMultikey,      rawMultikey,    0, ALGO_MEMORY_LOG,      KEY_STRING,            0,
+      "out of memory for the keys" },
+    { "msd",         "String MSD Radix", 'X', 0, runStringRadix,   rawStringRadix, 1, ALGO_MEMORY_LINEAR,   KEY_STRING,            0,
+      "out of memory" },
+    { "strintro",    "String Intro",     'I', 0, runStringIntro,   rawStringIntro, 0, ALGO_MEMORY_LOG,      KEY_STRING,            0,
+      "out of memory for the keys" },
+};
+
+/*
+----------------------------------------------------
+ TABLE
+----------------------------------------------------
+ Filled with the built-ins on first use, then only appended to (at
+ startup, before any sort thread runs): descriptors never move.
+----------------------------------------------------
+*/
+static AlgorithmInfo table[ALGO_MAX];
+static int tableCount = 0;
+
+static void addBuiltins(void) {
+    if (tableCount > 0) return;
+    for (size_t b = 0; b < sizeof(builtins) / sizeof(builtins[0]); b++) table[tableCount++] = builtins[b];
+}
+
+int algorithmCount(void) {
+    addBuiltins();
+    return tableCount;
+}
+
+const AlgorithmInfo* algorithmInfo(int id) {
+    addBuiltins();
+    return (id >= 1 && id <= tableCount) ? &table[id - 1] : NULL;
+}
+
+int findAlgorithm(const char* name) {
+    addBuiltins();
+    for (int i = 0; i < tableCount; i++) {
+        if (strcmp(table[i].name, name) == 0) return i + 1;
+    }
+    return 0;
+}
+
+int findAlgorithmByKey(int key) {
+    addBuiltins();
+    if (key <= 0 || key > 127) return 0; // SDL keycodes of the other keys
+    key = toupper(key);
+    for (int i = 0; i < tableCount; i++) {
+        if (table[i].key == key) return i + 1;
+    }
+    return 0;
+}
+
+// 'key' is a menu key nobody has
+static int keyIsFree(char key) {
+    if (!isdigit((unsigned char)key) && !isupper((unsigned char)key)) return 0;
+    if (strchr(ALGO_RESERVED_KEYS, key) != NULL) return 0;
+    return findAlgorithmByKey(key) == 0;
+}
+
+int registerAlgorithm(const AlgorithmInfo* info) {
+    addBuiltins();
+    if (info->name == NULL || info->name[0] == '\0' || info->run == NULL) {
+        fprintf(stderr, "Algorithm '%s' has no name or no entry point.\n", info->name ? info->name : "");
+        return -1;
+    }
+    if (findAlgorithm(info->name) != 0) {
+        fprintf(stderr, "Algorithm '%s' is already registered.\n", info->name);
+        return -1;
+    }
+    if (tableCount == ALGO_MAX) {
+        fprintf(stderr, "Algorithm '%s': at most %d algorithms.\n", info->name, ALGO_MAX);
+        return -1;
+    }
+
+    AlgorithmInfo entry = *info;
+    if (entry.label == NULL) entry.label = entry.name;
+    entry.machine = 0; // the state machines are sorting.c's own
+    if (entry.key == ALGO_NO_KEY) {
+        entry.key = 0;
+    } else {
+        entry.key = (char)toupper((unsigned char)entry.key);
+        if (entry.key != 0 && !keyIsFree(entry.key)) entry.key = 0;
+        for (char letter = 'A'; letter <= 'Z' && entry.key == 0; letter++) {
+            if (keyIsFree(letter)) entry.key = letter; // the first free letter
+        }
+    }
+    table[tableCount++] = entry;
+    return tableCount;
+}
+
+int loadAlgorithmPlugin(const char* path) {
+    void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL) {
+        fprintf(stderr, "Plugin %s: %s\n", path, dlerror());
+        return -1;
+    }
+    SortPluginFn entry;
+    *(void**)&entry = dlsym(handle, SORT_PLUGIN_SYMBOL); // object -> function pointer (POSIX)
+    if (entry == NULL) {
+        fprintf(stderr, "Plugin %s: no %s().\n", path, SORT_PLUGIN_SYMBOL);
+        dlclose(handle);
+        return -1;
+    }
+    int count = 0;
+    const AlgorithmInfo* infos = entry(SORT_PLUGIN_ABI, &count);
+    if (infos == NULL) {
+        fprintf(stderr, "Plugin %s: built for another version (ABI %d expected).\n", path, SORT_PLUGIN_ABI);
+        dlclose(handle);
+        return -1;
+    }
+
+    // kept loaded for the whole run: the table points into it
+    int registered = 0;
+    for (int i = 0; i < count; i++) {
+        if (registerAlgorithm(&infos[i]) > 0) registered++;
+    }
+    return registered;
+}
+
+const char* algorithmMemoryName(int memory) {
+    switch (memory) {
+        case ALGO_MEMORY_CONSTANT: return "O(1)";
+        case ALGO_MEMORY_LOG: return "O(log n)";
+        case ALGO_MEMORY_LINEAR: return "O(n)";
+        case ALGO_MEMORY_RANGE: return "O(n + range)";
+        default: return "?";
+    }
+}
@@ -0,0 +1,80 @@
+#include "ring.h"
+#include <stdlib.h> // For aligned_alloc and free
+#include <string.h> // For memcpy
+
+OpRing* createOpRing(size_t capacity) {
+    size_t rounded = 1;
+    while (rounded < capacity) rounded <<= 1;
+
+    OpRing* ring = (OpRing*)aligned_alloc(RING_CACHE_LINE, sizeof(OpRing));
+    if (ring == NULL) return NULL;
+
+    ring->ops = (TraceOp*)malloc(rounded * sizeof(TraceOp));
+    if (ring->ops == NULL) {
+        free(ring);
+        return NULL;
+    }
+    ring->capacity = rounded;
+    ring->mask = rounded - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    return ring;
+}
+
+void freeOpRing(OpRing* ring) {
+    if (ring != NULL) {
+        free(ring->ops);
+        free(ring);
+    }
+}
+
+// Copies 'count' ops into the ring storage starting at logical position 'pos' (handles wrap-around).
+static void copyIn(OpRing* ring, size_t pos, const TraceOp* ops, size_t count) {
+    size_t start = pos & ring->mask;
+    size_t first = ring->capacity - start;
+    if (first > count) first = count;
+    memcpy(ring->ops + start, ops, first * sizeof(TraceOp));
+    memcpy(ring->ops, ops + first, (count - first) * sizeof(TraceOp));
+}
+
+size_t ringPush(OpRing* ring, const TraceOp* ops, size_t count) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire); // slots freed by the consumer
+
+    size_t space = ring->capacity - (head - tail);
+    if (count > space) count = space;
+    if (count == 0) return 0;
+
+    copyIn(ring, head, ops, count);
+    atomic_store_explicit(&ring->head, head + count, memory_order_release); // publish the ops
+    return count;
+}
+
+size_t ringPop(OpRing* ring, TraceOp* out, size_t max) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire); // ops published by the producer
+
+    size_t available = head - tail;
+    if (max > available) max = available;
+    if (max == 0) return 0;
+
+    size_t start = tail & ring->mask;
+    size_t first = ring->capacity - start;
+    if (first > max) first = max;
+    memcpy(out, ring->ops + start, first * sizeof(TraceOp));
+    memcpy(out + first, ring->ops, (max - first) * sizeof(TraceOp));
+
+    atomic_store_explicit(&ring->tail, tail + max, memory_order_release); // give the slots back
+    return max;
+}
+
+size_t ringSize(OpRing* ring) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    return head - tail;
+}
+
+void ringClear(OpRing* ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    atomic_store_explicit(&ring->tail, head, memory_order_release);
+}
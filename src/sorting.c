@@ -1,8 +1,26 @@
 #include "sorting.h"
-#include "visual.h" 
-#include "utils.h" 
 #include "stats.h"
-#include <SDL2/SDL_ttf.h>
+#include "trace.h"
+#include <stdint.h> // For uint32_t
+#include <stdlib.h> // For malloc, realloc and free
+#include <string.h> // For memcpy and memset
+
+// Phases shared by the state machines
+enum {
+    PHASE_COMPARE,   // bubble/selection: next comparison
+    PHASE_SWAP,      // swap decided by the last comparison
+    PHASE_START,     // insertion: pick the next key
+    PHASE_SHIFT,     // insertion: shift larger elements right
+    PHASE_INSERT,    // insertion: write the key
+    PHASE_POP,       // quick: take the next range from the stack
+    PHASE_PARTITION, // quick: compare tab[j] with the pivot
+    PHASE_PLACE      // quick: put the pivot in its final place
+};
+
+// Records one operation in the output batch of the current stepSort() call.
+static inline void emit(SortMachine* m, uint32_t type, int a, int b) {
+    m->out[m->outCount++] = makeTraceOp(type, a, b);
+}
 
 /*
 ----------------------------------------------------
@@ -12,302 +30,328 @@
  After each pass, the largest element “bubbles up” to the end of the array.
 ----------------------------------------------------
 */
-void bubble_sort(App_Window* app) {
-    int running = 1; // local flag to check if the user closes the window
-    int actionCode = 0; // need to stop the sort
-    int size= N; // array size from main.h
-    int* tab = app->array;
-
-    for (int i = 0; i < size - 1; i++) {
-        int swapped = 0; // early-exit optimization
-
-        for (int j = 0; j < size - 1 - i; j++) {
-            // keep UI responsive; allow early stop
-            actionCode = handleEvents(&running); // keep window responsive
-            if (!running) { app->running = 0; return; } //stop everything if 'X' clicked
-            if (actionCode == 50) { 
-                Uint64 now = SDL_GetPerformanceCounter();
-                Uint64 frequency = SDL_GetPerformanceFrequency();
-
-                app->stats->executionTime += (double)(now - app->stats->startTicks) / frequency;
-                app->stats->startTicks = 0; 
-                return;
-            }
-
-            // stats: compare tab[j] vs tab[j+1]
-            app->stats->comparisons++; 
-            app->stats->memoryAccesses += 2;
-
-            // visual: highlight j (red) and j+1 (green)
-            renderApp(app, j, j + 1);
-            SDL_Delay(1); // short delay to make animation visible
-
-            // swap if out of order
-            if (tab[j] > tab[j + 1]) {
-                app->stats->memoryAccesses += 4; // 2 reads + 2 writes for a swap
-
-                //swap
-                int tmp = tab[j];
-                tab[j] = tab[j + 1];
-                tab[j + 1] = tmp;
-                swapped = 1;
-
-                //check events after swap
-                if (!running) { app->running = 0; return; }
-                if (actionCode == 50) { 
-                    Uint64 now = SDL_GetPerformanceCounter();
-                    Uint64 frequency = SDL_GetPerformanceFrequency();
-
-                    app->stats->executionTime += (double)(now - app->stats->startTicks) / frequency;
-                    app->stats->startTicks = 0; 
-                    return;
-                }
-                // visual : show swap result
-                renderApp(app, j, j + 1);
-                SDL_Delay(1);
-            }
-        }
+// One operation. i = pass, j = position in the pass.
+static void bubble_step(SortMachine* m) {
+    int* tab = m->tab;
+
+    if (m->phase == PHASE_SWAP) {
+        m->stats->memoryAccesses += 4; // 2 reads + 2 writes for a swap
+        int tmp = tab[m->j];
+        tab[m->j] = tab[m->j + 1];
+        tab[m->j + 1] = tmp;
+        m->swapped = 1;
+        emit(m, TRACE_SWAP, m->j, m->j + 1);
+
+        m->j++;
+        m->phase = PHASE_COMPARE;
+        return;
+    }
 
-        if (!swapped) break; // already sorted
+    // end of a pass
+    while (m->j >= m->size - 1 - m->i) {
+        if (!m->swapped || m->i >= m->size - 2) { m->done = 1; return; } // already sorted
+        m->i++;
+        m->j = 0;
+        m->swapped = 0; // early-exit optimization
     }
 
-    // Final clean frame (no highlights)
-    renderApp(app, -1, -1);
+    // stats: compare tab[j] vs tab[j+1]
+    m->stats->comparisons++;
+    m->stats->memoryAccesses += 2;
+    emit(m, TRACE_COMPARE, m->j, m->j + 1); // replay highlights j (red) and j+1 (green)
+
+    // swap if out of order (next step)
+    if (tab[m->j] > tab[m->j + 1]) {
+        m->phase = PHASE_SWAP;
+    } else {
+        m->j++;
+    }
 }
 
 /*
 ----------------------------------------------------
- SELECTION SORT VISUALIZATION
+ SELECTION SORT
 ----------------------------------------------------
 Scans the array to find the smallest element and places it at the beginning.
 Repeats the process for the remaining unsorted part.
 ----------------------------------------------------
 */
-void selection_sort(App_Window* app) {
-    int running = 1;
-    int actionCode = 0;
-    int size = N;
-    int* tab = app->array;
-
-    for (int i = 0; i < size - 1; i++) {
-        int minimum = i; // Index of the smallest element in the unsorted part
-
-        // Find smallest element in the remaining array
-        for (int j = i + 1; j < size; j++) {
-            app->stats->comparisons++;
-            app->stats->memoryAccesses += 2; // read tab[j] and tab[minimum]
-
-            if (tab[j] < tab[minimum]) {
-                minimum = j;    
-            }
-        }
+// One operation. i = place to fill, j = scan position.
+static void selection_step(SortMachine* m) {
+    int* tab = m->tab;
 
-        // visual: show current i and candidate minimum
-        actionCode = handleEvents(&running);
-        if (!running) { app->running = 0; return; }
-        if (actionCode == 50) { 
-            Uint64 now = SDL_GetPerformanceCounter();
-            Uint64 frequency = SDL_GetPerformanceFrequency();
+    if (m->phase == PHASE_SWAP) {
+        // place the minimum at position i
+        m->stats->memoryAccesses += 4; // 2 reads + 2 writes for swap
+        int tmp = tab[m->i];
+        tab[m->i] = tab[m->minimum];
+        tab[m->minimum] = tmp;
+        emit(m, TRACE_SWAP, m->i, m->minimum);
+
+        m->i++;
+        m->j = m->i + 1;
+        m->minimum = m->i;
+        m->phase = PHASE_COMPARE;
+        return;
+    }
 
-            app->stats->executionTime += (double)(now - app->stats->startTicks) / frequency;
-            app->stats->startTicks = 0; 
+    // scan finished: swap (if needed) and move to the next position
+    while (m->j >= m->size) {
+        if (m->minimum != m->i) {
+            m->phase = PHASE_SWAP;
+            selection_step(m);
             return;
-            }
-        renderApp(app, i, minimum);
-        SDL_Delay(20);
+        }
+        m->i++;
+        m->j = m->i + 1;
+        m->minimum = m->i;
+        if (m->i >= m->size - 1) { m->done = 1; return; }
+    }
 
-        // place the minimum at position i
-        if (minimum != i) {
-            app->stats->memoryAccesses += 4; // 2 reads + 2 writes for swap
-
-            int tmp = tab[i];
-            tab[i] = tab[minimum];
-            tab[minimum] = tmp;
-
-            // visual: show after-swap state
-            actionCode = handleEvents(&running);
-            if (!running) { app->running = 0; return; }
-            if (actionCode == 50) { 
-                Uint64 now = SDL_GetPerformanceCounter();
-                Uint64 frequency = SDL_GetPerformanceFrequency();
-
-                app->stats->executionTime += (double)(now - app->stats->startTicks) / frequency;
-                app->stats->startTicks = 0; 
-                return;
-            }
-            renderApp(app, i, minimum);
-            SDL_Delay(20);
-        }   
+    // Find smallest element in the remaining array
+    m->stats->comparisons++;
+    m->stats->memoryAccesses += 2; // read tab[j] and tab[minimum]
+    emit(m, TRACE_COMPARE, m->j, m->minimum);
+
+    if (tab[m->j] < tab[m->minimum]) {
+        m->minimum = m->j;
     }
+    m->j++;
 }
 
 /*
 ----------------------------------------------------
- INSERTION SORT VISUALIZATION
+ INSERTION SORT
 ----------------------------------------------------
 Builds the sorted part of the array one element at a time.
 Each new element is inserted into its correct position within the sorted portion.
 ----------------------------------------------------
 */
-void insertion_sort(App_Window* app) {
-
-    int running = 1;
-    int actionCode = 0;
-    int size = N;
-    int* tab = app->array;
-
-    for (int i = 1; i < size; i++) {
-        app->stats->memoryAccesses++; // read key
-        int key = tab[i];
-        int j = i - 1;
-
-        // visual: show (j, i) before shifting
-        actionCode = handleEvents(&running);
-        if (!running) { app->running = 0; return; }
-        if (actionCode == 50) { 
-            Uint64 now = SDL_GetPerformanceCounter();
-            Uint64 frequency = SDL_GetPerformanceFrequency();
-
-            app->stats->executionTime += (double)(now - app->stats->startTicks) / frequency;
-            app->stats->startTicks = 0; 
+// One operation. i = element being inserted, j = slot compared with the key.
+static void insertion_step(SortMachine* m) {
+    int* tab = m->tab;
+
+    switch (m->phase) {
+        case PHASE_START:
+            if (m->i >= m->size) { m->done = 1; return; }
+
+            m->stats->memoryAccesses++; // read key
+            m->key = tab[m->i];
+            m->j = m->i - 1;
+
+            // first comparison counted here:
+            m->stats->comparisons++;
+            m->stats->memoryAccesses++;
+            emit(m, TRACE_COMPARE, m->j, m->i);
+            m->phase = PHASE_SHIFT;
             return;
-        }
-        renderApp(app, j, i);
-        SDL_Delay(5);
-
-        // first comparison counted here:
-        app->stats->comparisons++;
-        app->stats->memoryAccesses++;
-
-        // shift larger elements to the right
-        while (j >= 0 && tab[j] > key) {
-            app->stats->memoryAccesses += 2; // write tab[j+1], read tab[j] already accounted loosely
-            tab[j + 1] = tab[j];
-            j--;
-
-            // visual: show shifting progress (j moves left)
-            actionCode = handleEvents(&running);
-            if (!running) { app->running = 0; return; }
-            if (actionCode == 50) { 
-                Uint64 now = SDL_GetPerformanceCounter();
-                Uint64 frequency = SDL_GetPerformanceFrequency();
-
-                app->stats->executionTime += (double)(now - app->stats->startTicks) / frequency;
-                app->stats->startTicks = 0; 
+
+        case PHASE_SHIFT:
+            // shift larger elements to the right
+            if (m->j >= 0 && tab[m->j] > m->key) {
+                m->stats->memoryAccesses += 2; // write tab[j+1], read tab[j] already accounted loosely
+                tab[m->j + 1] = tab[m->j];
+                emit(m, TRACE_WRITE, m->j + 1, tab[m->j]);
+                m->j--;
                 return;
             }
-            renderApp(app, j, i);
-            SDL_Delay(5);
+            m->phase = PHASE_INSERT;
+            /* fall through */
 
-            // (optional accuracy) count next comparison for next loop test:
-            // app->stats->comparisons += 1; app->stats->memoryAccesses += 1;
-        }
+        default: // PHASE_INSERT
+            // insert the key at its position
+            m->stats->memoryAccesses++; // write key
+            tab[m->j + 1] = m->key;
+            emit(m, TRACE_WRITE, m->j + 1, m->key);
 
-        // insert the key at its position
-        app->stats->memoryAccesses++; // write key
-        tab[j + 1] = key;
+            m->i++;
+            m->phase = PHASE_START;
+            return;
     }
 }
 
 /*
 ----------------------------------------------------
- INSERTION SORT VISUALIZATION
+ QUICK SORT
 ----------------------------------------------------
 Chooses a pivot, then partitions the array into two parts:
     -Elements smaller than the pivot
     -Elements greater than the pivot
-Recursively sorts both sides.
+Sorts both sides. The recursion is replaced by an explicit stack of
+ranges so the sort can stop after any operation and resume later.
 ----------------------------------------------------
 */
+// Adds [low..high] to the ranges left to sort (ranges of 0 or 1 element are skipped).
+static int push_range(SortMachine* m, int low, int high) {
+    if (low >= high) return 0;
+
+    if (m->stackTop == m->stackCapacity) {
+        int newCapacity = m->stackCapacity ? m->stackCapacity * 2 : 64;
+        SortRange* grown = (SortRange*)realloc(m->stack, newCapacity * sizeof(SortRange));
+        if (grown == NULL) return -1;
+        m->stack = grown;
+        m->stackCapacity = newCapacity;
+    }
+    m->stack[m->stackTop].low = low;
+    m->stack[m->stackTop].high = high;
+    m->stackTop++;
+    return 0;
+}
 
-// Partition around pivot = tab[high]. Returns pivot's final index.
-// Returns -1 if the user stops/quit to abort the sort gracefully.
-static int partition(App_Window* app, int low, int high) {
-    int* tab = app->array;
-    int running = 1;
-    int actionCode = 0;
-
-    app->stats->memoryAccesses++; // read pivot
-    int pivot_value = tab[high]; 
-    
-    int i = (low - 1); // boundary of "elements < pivot"
-
-    for (int j = low; j < high; j++) {
-        actionCode = handleEvents(&running);
-        if (!running) { app->running = 0; return -1; }
-        if (actionCode == 50) { 
-            Uint64 now = SDL_GetPerformanceCounter();
-            Uint64 frequency = SDL_GetPerformanceFrequency();
-
-            app->stats->executionTime += (double)(now - app->stats->startTicks) / frequency;
-            app->stats->startTicks = 0; 
-            return -1;
+// One operation of the Lomuto partition (pivot = tab[high]).
+static void quick_step(SortMachine* m) {
+    int* tab = m->tab;
+
+    switch (m->phase) {
+        case PHASE_POP:
+            if (m->stackTop == 0) { m->done = 1; return; }
+            m->stackTop--;
+            m->low = m->stack[m->stackTop].low;
+            m->high = m->stack[m->stackTop].high;
+
+            m->stats->memoryAccesses++; // read pivot
+            m->pivot = tab[m->high];
+            m->i = m->low - 1; // boundary of "elements < pivot"
+            m->j = m->low;
+            m->phase = PHASE_PARTITION;
+            /* fall through */
+
+        case PHASE_PARTITION:
+            if (m->j < m->high) {
+                m->stats->comparisons++;
+                m->stats->memoryAccesses++; // read tab[j]
+                emit(m, TRACE_COMPARE, m->j, m->high);
+
+                if (tab[m->j] < m->pivot) {
+                    m->i++;
+                    m->phase = PHASE_SWAP;
+                } else {
+                    m->j++;
+                }
+                return;
+            }
+            m->phase = PHASE_PLACE;
+            /* fall through */
+
+        case PHASE_PLACE: {
+            // place pivot at i+1 (its final position)
+            m->stats->memoryAccesses += 4; // swap pivot into place
+            int p = m->i + 1;
+            int temp = tab[p];
+            tab[p] = tab[m->high];
+            tab[m->high] = temp;
+            emit(m, TRACE_SWAP, p, m->high);
+
+            // right side pushed first so the left side is sorted first (same order as the recursion)
+            if (push_range(m, p + 1, m->high) != 0 || push_range(m, m->low, p - 1) != 0) {
+                m->done = 1; // out of memory: give up
+                return;
+            }
+            m->phase = PHASE_POP;
+            return;
         }
 
-        app->stats->comparisons++;
-        app->stats->memoryAccesses++; // read tab[j]
+        default: { // PHASE_SWAP: swap tab[i] and tab[j]
+            m->stats->memoryAccesses += 4; // 2 reads + 2 writes
+            int temp = tab[m->i];
+            tab[m->i] = tab[m->j];
+            tab[m->j] = temp;
+            emit(m, TRACE_SWAP, m->i, m->j);
 
-        if (tab[j] < pivot_value) {
-            i++; 
-            // swap tab[i] and tab[j]
-            app->stats->memoryAccesses += 4; // 2 reads + 2 writes
-            int temp = tab[i];
-            tab[i] = tab[j];
-            tab[j] = temp;
+            m->j++;
+            m->phase = PHASE_PARTITION;
+            return;
         }
+    }
+}
 
-        renderApp(app, j, high);
-        SDL_Delay(5);
+/*
+----------------------------------------------------
+ MACHINE
+----------------------------------------------------
+*/
+SortMachine* createSortMachine(size_t batchCapacity) {
+    SortMachine* machine = (SortMachine*)malloc(sizeof(SortMachine));
+    if (machine == NULL) return NULL;
+    memset(machine, 0, sizeof(SortMachine));
+
+    machine->out = (TraceOp*)malloc(batchCapacity * sizeof(TraceOp));
+    if (machine->out == NULL) {
+        free(machine);
+        return NULL;
     }
+    machine->outCapacity = batchCapacity;
+    return machine;
+}
 
-    // place pivot at i+1 (its final position)
-    app->stats->memoryAccesses += 4; // swap pivot into place
-    int temp = tab[i + 1];
-    tab[i + 1] = tab[high];
-    tab[high] = temp;
-    
-    // One last visual update on the final swap
-    actionCode = handleEvents(&running);
-    if (!running) { app->running = 0; return -1; }
-    if (actionCode == 50) { 
-        Uint64 now = SDL_GetPerformanceCounter();
-        Uint64 frequency = SDL_GetPerformanceFrequency();
-
-        app->stats->executionTime += (double)(now - app->stats->startTicks) / frequency;
-        app->stats->startTicks = 0; 
-        return -1;
+int startSort(SortMachine* machine, int algorithm, const int* array, int size, Stats_t* stats) {
+    stopSort(machine);
+
+    machine->tab = (int*)malloc(size * sizeof(int));
+    if (machine->tab == NULL) return -1;
+    memcpy(machine->tab, array, size * sizeof(int));
+
+    machine->algorithm = algorithm;
+    machine->size = size;
+    machine->stats = stats;
+    machine->outCount = 0;
+
+    switch (algorithm) {
+        case 1:
+        case 2:
+            machine->phase = PHASE_COMPARE;
+            machine->i = 0;
+            machine->j = (algorithm == 2) ? 1 : 0;
+            machine->minimum = 0;
+            machine->swapped = 0;
+            break;
+        case 3:
+            machine->phase = PHASE_START;
+            machine->i = 1;
+            break;
+        case 4:
+            machine->phase = PHASE_POP;
+            machine->stackTop = 0;
+            if (push_range(machine, 0, size - 1) != 0) return -1;
+            break;
     }
-    
-    renderApp(app, i + 1, high);
-    SDL_Delay(5);
 
-    return (i + 1);
+    // arrays of 0 or 1 element are already sorted
+    machine->done = (size < 2);
+    return 0;
 }
 
-// Recursive helper: sorts range [low..high] if app->running is true.
-static void quick_sort_recursive(App_Window* app, int low, int high) {
-    if (low < high && app->running) {   
-        // find the pivot
-        int pivot_index = partition(app, low, high);
-        if (pivot_index == -1) return;
-
-        // sort the left side (before the pivot)
-        quick_sort_recursive(app, low, pivot_index - 1);
-        
-        // sort the right side (after the pivot)
-        quick_sort_recursive(app, pivot_index + 1, high);
+int stepSort(SortMachine* machine, long long budget) {
+    // every step records at most one op, so the batch bounds the budget
+    machine->outCount = 0;
+    if (budget > (long long)machine->outCapacity) budget = (long long)machine->outCapacity;
+
+    while (!machine->done && budget > 0) {
+        switch (machine->algorithm) {
+            case 1: bubble_step(machine); break;
+            case 2: selection_step(machine); break;
+            case 3: insertion_step(machine); break;
+            case 4: quick_step(machine); break;
+            default: machine->done = 1; break; // idle
+        }
+        budget--;
     }
+    return machine->done;
 }
 
-// public entry point for Quick Sort (called from main loop)
-void quick_sort(App_Window* app) {
-    int size = N; // global length from main.h
-
-    //start the recursive sort on the entire array (0 to size - 1)
-    quick_sort_recursive(app, 0, size - 1);
+void stopSort(SortMachine* machine) {
+    free(machine->tab);
+    machine->tab = NULL;
+    machine->algorithm = 0;
+    machine->done = 1;
+    machine->stackTop = 0;
+}
 
-    // final render (only if the sort wasn't stopped)
-    if (app->running) {
-        renderApp(app, -1, -1);
+void freeSortMachine(SortMachine* machine) {
+    if (machine != NULL) {
+        free(machine->tab);
+        free(machine->stack);
+        free(machine->out);
+        free(machine);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,507 @@
+#include "strsort.h"
+#include "instrument.h"
+#include <stdatomic.h> // For the shape shared by the threads
+#include <string.h>    // For memcpy, memset and strcmp
+
+#define INTRO_CUTOFF 16 // baseline: ranges this short finish by insertion sort
+#define STACK_SIZE 64   // baseline: > log2(INT_MAX), the smaller side goes first
+
+/*
+----------------------------------------------------
+ KEY GENERATOR
+----------------------------------------------------
+ Paths: the value is cut into 5-bit digits, most significant first. The
+ first directory tells how many digits there are, then every digit picks
+ a name in a sorted table (and the last one a file name plus an extension
+ taken from the value). A name that is a prefix of another is followed by
+ '/' or '.', below every letter and digit, so the strings sort like the
+ digits: like the values.
+ Ids: one constant prefix, then the value in base 36 on 7 digits.
+----------------------------------------------------
+*/
+static const char* pathRoots[7] = { "boot", "home", "mnt", "opt", "srv", "usr", "var" };
+
+static const char* pathNames[32] = {
+    "apps", "assets", "bin", "build", "cache", "config", "core", "data",
+    "docs", "etc", "include", "lib", "lib64", "local", "logs", "media",
+    "modules", "net", "opt", "packages", "private", "public", "res", "run",
+    "scripts", "share", "src", "static", "sys", "tmp", "user", "vendor",
+};
+
+static const char* pathExtensions[4] = { ".c", ".h", ".json", ".txt" };
+
+#define ID_PREFIX "customer-0042/invoice-"
+#define ID_DIGITS 7 // 36^7 > 2^32
+
+static atomic_int currentShape = STRING_PATHS;
+
+int setStringShape(const char* name) {
+    for (int shape = 0; shape < STRING_SHAPE_COUNT; shape++) {
+        if (strcmp(name, stringShapeName(shape)) == 0) {
+            atomic_store_explicit(&currentShape, shape, memory_order_relaxed);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int stringShape(void) {
+    return atomic_load_explicit(&currentShape, memory_order_relaxed);
+}
+
+const char* stringShapeName(int shape) {
+    static const char* names[STRING_SHAPE_COUNT] = { "paths", "ids" };
+    return (shape >= 0 && shape < STRING_SHAPE_COUNT) ? names[shape] : "?";
+}
+
+// Appends 'text' at out[length]
+static int appendText(char* out, int length, const char* text) {
+    size_t n = strlen(text);
+    memcpy(out + length, text, n);
+    return length + (int)n;
+}
+
+int formatStringKey(int value, int shape, char* out) {
+    uint32_t v = (uint32_t)value;
+    int length = 0;
+    if (shape == STRING_IDS) {
+        static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+        length = appendText(out, 0, ID_PREFIX);
+        for (int d = ID_DIGITS - 1; d >= 0; d--) {
+            out[length + d] = digits[v % 36];
+            v /= 36;
+        }
+        length += ID_DIGITS;
+    } else {
+        int levels = 1;
+        while (levels < 7 && (v >> (5 * levels)) != 0) levels++;
+        out[length++] = '/';
+        length = appendText(out, length, pathRoots[levels - 1]);
+        for (int level = levels - 1; level >= 0; level--) {
+            out[length++] = '/';
+            length = appendText(out, length, pathNames[(v >> (5 * level)) & 31]);
+        }
+        length = appendText(out, length, pathExtensions[(v * 2654435761u) >> 30]);
+    }
+    out[length] = '\0';
+    return length;
+}
+
+const char** createStringKeys(const int* values, int size, int shape, Arena* arena) {
+    char key[STRING_KEY_MAX];
+    size_t bytes = 0;
+    for (int i = 0; i < size; i++) bytes += (size_t)formatStringKey(values[i], shape, key) + 1;
+
+    const char** keys = (const char**)arenaAlloc(arena, (size_t)size * sizeof(char*), NULL);
+    char* text = (char*)arenaAlloc(arena, bytes, NULL);
+    if (keys == NULL || text == NULL) {
+        arenaFree(arena, keys, (size_t)size * sizeof(char*), NULL);
+        arenaFree(arena, text, bytes, NULL);
+        return NULL;
+    }
+    for (int i = 0; i < size; i++) {
+        keys[i] = text;
+        text += formatStringKey(values[i], shape, text) + 1;
+    }
+    return keys;
+}
+
+/*
+----------------------------------------------------
+ SHARED STEPS
+----------------------------------------------------
+ Inlined into the counted and the raw entry points (instrument.h).
+----------------------------------------------------
+*/
+typedef struct {
+    const char** keys;
+    int* values;       // moved with the keys (NULL: none)
+    Counters counters;
+    long long chars;   // characters examined, for stats->charComparisons
+    OpSink* sink;
+} StringSort;
+
+KERNEL_INLINE void emit(StringSort* s, TraceOp op, const int counted) {
+    if (counted && s->sink != NULL) s->sink->push(s->sink->context, op);
+}
+
+KERNEL_INLINE void flushStringCounters(StringSort* s, Stats_t* stats, const int counted) {
+    if (!counted) return;
+    stats->charComparisons += s->chars;
+    s->chars = 0;
+    flushCounters(&s->counters, stats, counted);
+}
+
+// Character 'depth' of key i (0 past its end)
+KERNEL_INLINE int charAt(StringSort* s, int i, int depth, const int counted) {
+    COUNT_ACCESSES(&s->counters, 1);
+    if (counted) s->chars++;
+    return (unsigned char)s->keys[i][depth];
+}
+
+// strcmp of keys i and j from character 'depth' on (both share what is before)
+KERNEL_INLINE int compareFrom(StringSort* s, const char* a, const char* b, int i, int j, int depth,
+                              const int counted) {
+    const unsigned char* x = (const unsigned char*)a + depth;
+    const unsigned char* y = (const unsigned char*)b + depth;
+    COUNT_COMPARISONS(&s->counters, 1);
+    COUNT_ACCESSES(&s->counters, 2);
+    emit(s, makeTraceOp(TRACE_COMPARE, i, j), counted);
+    long long examined = 1;
+    while (*x == *y && *x != '\0') {
+        x++;
+        y++;
+        examined++;
+    }
+    if (counted) s->chars += examined;
+    return (int)*x - (int)*y;
+}
+
+KERNEL_INLINE void swapKeys(StringSort* s, int i, int j, const int counted) {
+    const char* key = s->keys[i];
+    s->keys[i] = s->keys[j];
+    s->keys[j] = key;
+    COUNT_ACCESSES(&s->counters, 4); // 2 reads + 2 writes
+    if (s->values != NULL) {
+        int value = s->values[i];
+        s->values[i] = s->values[j];
+        s->values[j] = value;
+        COUNT_ACCESSES(&s->counters, 4);
+    }
+    emit(s, makeTraceOp(TRACE_SWAP, i, j), counted);
+}
+
+// Key (and value) to position i
+KERNEL_INLINE void writeKey(StringSort* s, int i, const char* key, int value, const int counted) {
+    s->keys[i] = key;
+    COUNT_ACCESSES(&s->counters, 1);
+    if (s->values != NULL) {
+        s->values[i] = value;
+        COUNT_ACCESSES(&s->counters, 1);
+        emit(s, makeTraceOp(TRACE_WRITE, i, value), counted);
+    }
+}
+
+// Swaps the blocks [i, i + n) and [j, j + n)
+KERNEL_INLINE void swapBlocks(StringSort* s, int i, int j, int n, const int counted) {
+    for (int k = 0; k < n; k++) swapKeys(s, i + k, j + k, counted);
+}
+
+// Insertion sort of keys [low, high], equal up to character 'depth'
+KERNEL_INLINE void insertionFrom(StringSort* s, int low, int high, int depth, const int counted) {
+    for (int i = low + 1; i <= high; i++) {
+        const char* key = s->keys[i];
+        int value = s->values != NULL ? s->values[i] : 0;
+        COUNT_ACCESSES(&s->counters, 1); // read key
+        int j = i - 1;
+        while (j >= low && compareFrom(s, s->keys[j], key, j, i, depth, counted) > 0) {
+            writeKey(s, j + 1, s->keys[j], s->values != NULL ? s->values[j] : 0, counted);
+            j--;
+        }
+        if (j + 1 != i) writeKey(s, j + 1, key, value, counted);
+    }
+}
+
+// Owner color of the range whose keys share a prefix ending in 'c'
+KERNEL_INLINE void markPrefix(StringSort* s, int low, int high, int c, const int counted) {
+    if (low < high) emit(s, makeOwnerOp(low, high, c % STRING_PREFIX_COLORS), counted);
+}
+
+/*
+----------------------------------------------------
+ MULTIKEY QUICKSORT
+----------------------------------------------------
+ Bentley-Sedgewick: keys equal to the pivot's character are swapped to
+ both ends while scanning, then moved to the middle. The two smaller
+ parts recurse and the largest is looped on, so the recursion never goes
+ deeper than log2(n).
+----------------------------------------------------
+*/
+static void multikeyCounted(StringSort* s, int low, int n, int depth);
+static void multikeyRaw(StringSort* s, int low, int n, int depth);
+
+// Index among a, b, c of the median of their characters at 'depth'
+KERNEL_INLINE int medianOf3(StringSort* s, int a, int b, int c, int depth, const int counted) {
+    int va = charAt(s, a, depth, counted), vb = charAt(s, b, depth, counted), vc = charAt(s, c, depth, counted);
+    COUNT_COMPARISONS(&s->counters, 3);
+    if (va < vb) return vb < vc ? b : (va < vc ? c : a);
+    return va < vc ? a : (vb < vc ? c : b);
+}
+
+KERNEL_INLINE void multikey(StringSort* s, int low, int n, int depth, const int counted) {
+    while (n > STRING_MULTIKEY_CUTOFF) {
+        int last = low + n - 1;
+        swapKeys(s, low, medianOf3(s, low, low + n / 2, last, depth, counted), counted);
+        int pivot = (unsigned char)s->keys[low][depth];
+
+        // [low, a): equal, [a, b): less, (c, d]: greater, (d, last]: equal
+        int a = low + 1, b = low + 1, c = last, d = last;
+        while (1) {
+            int r;
+            while (b <= c && (r = charAt(s, b, depth, counted) - pivot) <= 0) {
+                COUNT_COMPARISONS(&s->counters, 1);
+                emit(s, makeTraceOp(TRACE_COMPARE, b, low), counted);
+                if (r == 0) swapKeys(s, a++, b, counted);
+                b++;
+            }
+            while (b <= c && (r = charAt(s, c, depth, counted) - pivot) >= 0) {
+                COUNT_COMPARISONS(&s->counters, 1);
+                emit(s, makeTraceOp(TRACE_COMPARE, c, low), counted);
+                if (r == 0) swapKeys(s, c, d--, counted);
+                c--;
+            }
+            if (b > c) break;
+            swapKeys(s, b++, c--, counted);
+        }
+        int r = (a - low < b - a) ? a - low : b - a;
+        swapBlocks(s, low, b - r, r, counted);
+        r = (d - c < last - d) ? d - c : last - d;
+        swapBlocks(s, b, last - r + 1, r, counted);
+
+        int less = b - a, greater = d - c;
+        int equal = n - less - greater;
+        if (pivot == 0) equal = 0; // all ended: equal keys, done
+        else markPrefix(s, low + less, low + less + equal - 1, pivot, counted);
+
+        // parts: [low, +less) at depth, [low + less, +equal) at depth + 1, the rest at depth
+        int starts[3] = { low, low + less, low + n - greater };
+        int sizes[3] = { less, equal, greater };
+        int depths[3] = { depth, depth + 1, depth };
+        int largest = (sizes[0] >= sizes[1] && sizes[0] >= sizes[2]) ? 0 : (sizes[1] >= sizes[2] ? 1 : 2);
+        for (int p = 0; p < 3; p++) {
+            if (p == largest || sizes[p] < 2) continue;
+            if (counted) multikeyCounted(s, starts[p], sizes[p], depths[p]);
+            else multikeyRaw(s, starts[p], sizes[p], depths[p]);
+        }
+        low = starts[largest];
+        n = sizes[largest];
+        depth = depths[largest];
+    }
+    if (n > 1) insertionFrom(s, low, low + n - 1, depth, counted);
+}
+
+static void multikeyCounted(StringSort* s, int low, int n, int depth) { multikey(s, low, n, depth, 1); }
+static void multikeyRaw(StringSort* s, int low, int n, int depth) { multikey(s, low, n, depth, 0); }
+
+void string_multikey_sort(const char** keys, int* values, int size, Stats_t* stats, OpSink* sink) {
+    StringSort s = { keys, values, { 0, 0 }, 0, sink };
+    multikeyCounted(&s, 0, size, 0);
+    flushStringCounters(&s, stats, 1);
+}
+
+void string_multikey_sort_raw(const char** keys, int* values, int size) {
+    StringSort s = { keys, values, { 0, 0 }, 0, NULL };
+    multikeyRaw(&s, 0, size, 0);
+}
+
+/*
+----------------------------------------------------
+ MSD RADIX SORT
+----------------------------------------------------
+ One pass reads the character of every key into 'bytes' and counts them,
+ a second one moves the keys to their bucket in 'auxKeys' (the bytes say
+ where, the strings are not read again) and they are copied back. The
+ buffers are indexed from the start of the range: a bucket is only sorted
+ once its parent is done with them. The largest bucket is looped on, the
+ others recurse (at most half the range each: log2(n) deep).
+----------------------------------------------------
+*/
+typedef struct {
+    const char** auxKeys;
+    int* auxValues;       // NULL without values
+    unsigned char* bytes;
+} RadixBuffers;
+
+static void msdCounted(StringSort* s, const RadixBuffers* buffers, int low, int n, int depth);
+static void msdRaw(StringSort* s, const RadixBuffers* buffers, int low, int n, int depth);
+
+KERNEL_INLINE void msd(StringSort* s, const RadixBuffers* buffers, int low, int n, int depth, const int counted) {
+    int count[256];
+    while (n > STRING_MSD_CUTOFF) {
+        memset(count, 0, sizeof(count));
+        for (int i = 0; i < n; i++) {
+            int c = charAt(s, low + i, depth, counted);
+            buffers->bytes[i] = (unsigned char)c;
+            count[c]++;
+        }
+        if (count[0] == n) return; // every key ended: all equal
+        if (count[buffers->bytes[0]] == n) {
+            depth++; // one shared character: nothing to move
+            continue;
+        }
+
+        int start[256];
+        int next = 0;
+        for (int c = 0; c < 256; c++) {
+            start[c] = next;
+            next += count[c];
+        }
+        for (int i = 0; i < n; i++) {
+            int p = start[buffers->bytes[i]]++;
+            buffers->auxKeys[p] = s->keys[low + i];
+            if (buffers->auxValues != NULL) buffers->auxValues[p] = s->values[low + i];
+        }
+        COUNT_ACCESSES(&s->counters, (s->values != NULL ? 2 : 1) * (long long)n); // reads into the buffer
+        for (int i = 0; i < n; i++) {
+            writeKey(s, low + i, buffers->auxKeys[i], buffers->auxValues != NULL ? buffers->auxValues[i] : 0, counted);
+        }
+
+        // bucket 0 (keys that ended) is sorted; start[c] is now the end of bucket c
+        int largest = 1;
+        for (int c = 1; c < 256; c++) {
+            if (count[c] > count[largest]) largest = c;
+        }
+        for (int c = 1; c < 256; c++) {
+            if (count[c] < 2) continue;
+            markPrefix(s, low + start[c] - count[c], low + start[c] - 1, c, counted);
+            if (c == largest) continue;
+            if (counted) msdCounted(s, buffers, low + start[c] - count[c], count[c], depth + 1);
+            else msdRaw(s, buffers, low + start[c] - count[c], count[c], depth + 1);
+        }
+        low += start[largest] - count[largest];
+        n = count[largest];
+        depth++;
+    }
+    if (n > 1) insertionFrom(s, low, low + n - 1, depth, counted);
+}
+
+static void msdCounted(StringSort* s, const RadixBuffers* buffers, int low, int n, int depth) {
+    msd(s, buffers, low, n, depth, 1);
+}
+
+static void msdRaw(StringSort* s, const RadixBuffers* buffers, int low, int n, int depth) {
+    msd(s, buffers, low, n, depth, 0);
+}
+
+KERNEL_INLINE int msdBody(const char** keys, int* values, int size, Stats_t* stats, Arena* arena, OpSink* sink,
+                          const int counted) {
+    size_t keyBytes = (size_t)size * sizeof(char*);
+    size_t valueBytes = values != NULL ? (size_t)size * sizeof(int) : 0;
+    RadixBuffers buffers;
+    buffers.auxKeys = (const char**)arenaAlloc(arena, keyBytes, stats);
+    buffers.auxValues = values != NULL ? (int*)arenaAlloc(arena, valueBytes, stats) : NULL;
+    buffers.bytes = (unsigned char*)arenaAlloc(arena, (size_t)size, stats);
+    int failed = buffers.auxKeys == NULL || buffers.bytes == NULL || (values != NULL && buffers.auxValues == NULL);
+    if (!failed) {
+        StringSort s = { keys, values, { 0, 0 }, 0, sink };
+        if (counted) msdCounted(&s, &buffers, 0, size, 0);
+        else msdRaw(&s, &buffers, 0, size, 0);
+        flushStringCounters(&s, stats, counted);
+    }
+    arenaFree(arena, buffers.bytes, (size_t)size, stats);
+    arenaFree(arena, buffers.auxValues, valueBytes, stats);
+    arenaFree(arena, (void*)buffers.auxKeys, keyBytes, stats);
+    return failed ? -1 : 0;
+}
+
+int string_msd_radix_sort(const char** keys, int* values, int size, Stats_t* stats, Arena* arena, OpSink* sink) {
+    return msdBody(keys, values, size, stats, arena, sink, 1);
+}
+
+int string_msd_radix_sort_raw(const char** keys, int* values, int size, Arena* arena) {
+    return msdBody(keys, values, size, NULL, arena, NULL, 0);
+}
+
+/*
+----------------------------------------------------
+ COMPARISON BASELINE
+----------------------------------------------------
+ Intro sort as in introsort.c (median of three, Hoare partition, heap
+ sort fallback, insertion sort leaves), every comparison a whole strcmp.
+----------------------------------------------------
+*/
+typedef struct {
+    int low;
+    int high;
+    int depth;
+} StringRange;
+
+KERNEL_INLINE int lessKey(StringSort* s, int i, int j, const int counted) {
+    return compareFrom(s, s->keys[i], s->keys[j], i, j, 0, counted) < 0;
+}
+
+KERNEL_INLINE void siftDownKeys(StringSort* s, int low, int root, int count, const int counted) {
+    while (1) {
+        int child = 2 * root + 1;
+        if (child >= count) return;
+        if (child + 1 < count && lessKey(s, low + child, low + child + 1, counted)) child++;
+        if (!lessKey(s, low + root, low + child, counted)) return;
+        swapKeys(s, low + root, low + child, counted);
+        root = child;
+    }
+}
+
+KERNEL_INLINE void heapSortKeys(StringSort* s, int low, int high, const int counted) {
+    int count = high - low + 1;
+    for (int root = count / 2 - 1; root >= 0; root--) siftDownKeys(s, low, root, count, counted);
+    for (int end = count - 1; end > 0; end--) {
+        swapKeys(s, low, low + end, counted);
+        siftDownKeys(s, low, 0, end, counted);
+    }
+}
+
+// Median of tab[low], tab[mid], tab[high] to tab[low]; tab[high] >= it stops the left scan
+KERNEL_INLINE int partitionKeys(StringSort* s, int low, int high, const int counted) {
+    int mid = low + (high - low) / 2;
+    if (lessKey(s, mid, low, counted)) swapKeys(s, low, mid, counted);
+    if (lessKey(s, high, mid, counted)) swapKeys(s, mid, high, counted);
+    if (lessKey(s, mid, low, counted)) swapKeys(s, low, mid, counted);
+    swapKeys(s, low, mid, counted);
+
+    int i = low, j = high + 1;
+    while (1) {
+        do i++; while (i < high && lessKey(s, i, low, counted));
+        do j--; while (lessKey(s, low, j, counted));
+        if (i >= j) break;
+        swapKeys(s, i, j, counted);
+    }
+    swapKeys(s, low, j, counted);
+    return j;
+}
+
+KERNEL_INLINE void introKeysBody(const char** keys, int* values, int size, Stats_t* stats, OpSink* sink,
+                                 const int counted) {
+    StringSort s = { keys, values, { 0, 0 }, 0, sink };
+    StringRange stack[STACK_SIZE];
+    int top = 0;
+    int depthLimit = 0;
+    for (int n = size; n > 1; n >>= 1) depthLimit += 2;
+
+    int low = 0, high = size - 1, depth = depthLimit;
+    while (1) {
+        while (high - low + 1 > INTRO_CUTOFF) {
+            if (depth == 0) {
+                heapSortKeys(&s, low, high, counted);
+                low = high;
+                break;
+            }
+            depth--;
+            int split = partitionKeys(&s, low, high, counted);
+            // smaller side now, larger side on the stack (the pivot is in place)
+            if (split - low < high - split) {
+                stack[top].low = split + 1; stack[top].high = high; stack[top].depth = depth;
+                high = split - 1;
+            } else {
+                stack[top].low = low; stack[top].high = split - 1; stack[top].depth = depth;
+                low = split + 1;
+            }
+            top++;
+        }
+        if (low < high) insertionFrom(&s, low, high, 0, counted);
+        flushStringCounters(&s, stats, counted);
+
+        if (top == 0) break;
+        top--;
+        low = stack[top].low;
+        high = stack[top].high;
+        depth = stack[top].depth;
+    }
+}
+
+void string_intro_sort(const char** keys, int* values, int size, Stats_t* stats, OpSink* sink) {
+    introKeysBody(keys, values, size, stats, sink, 1);
+}
+
+void string_intro_sort_raw(const char** keys, int* values, int size) {
+    introKeysBody(keys, values, size, NULL, NULL, 0);
+}
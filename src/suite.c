@@ -0,0 +1,172 @@
+#include "suite.h"
+#include <math.h>   // For log, fabs
+#include <stdio.h>  // For the baseline file
+#include <stdlib.h> // For qsort, malloc
+#include <string.h> // For strstr, strcmp
+
+#define MAD_TO_SIGMA 1.4826 // MAD of a normal distribution * this = its standard deviation
+#define NOISE_SIGMAS 3.0
+#define LINE_MAX_LENGTH 4096
+
+/*
+----------------------------------------------------
+ SUMMARY
+----------------------------------------------------
+*/
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Median of a sorted array
+static double sortedMedian(const double* values, int count) {
+    if (count % 2 == 1) return values[count / 2];
+    return (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+
+void summarizeTimings(double* seconds, int count, TimingSummary* summary) {
+    summary->reps = count;
+    if (count <= 0) {
+        summary->median = summary->mad = summary->p99 = summary->min = 0.0;
+        return;
+    }
+    qsort(seconds, count, sizeof(double), compareDoubles);
+    summary->median = sortedMedian(seconds, count);
+    summary->min = seconds[0];
+
+    // nearest rank: the smallest timing with at least 99% of the runs at or below it
+    int rank = (int)ceil(0.99 * count);
+    summary->p99 = seconds[(rank > 0 ? rank : 1) - 1];
+
+    double* deviations = (double*)malloc(count * sizeof(double));
+    if (deviations == NULL) {
+        summary->mad = 0.0;
+        return;
+    }
+    for (int i = 0; i < count; i++) deviations[i] = fabs(seconds[i] - summary->median);
+    qsort(deviations, count, sizeof(double), compareDoubles);
+    summary->mad = sortedMedian(deviations, count);
+    free(deviations);
+}
+
+double fitExponent(const double* n, const double* seconds, int count) {
+    double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+    int points = 0;
+    for (int i = 0; i < count; i++) {
+        if (n[i] <= 0.0 || seconds[i] <= 0.0) continue; // below the clock resolution
+        double x = log(n[i]), y = log(seconds[i]);
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+        points++;
+    }
+    double denominator = points * sumXX - sumX * sumX;
+    if (points < 2 || denominator == 0.0) return 0.0;
+    return (points * sumXY - sumX * sumY) / denominator;
+}
+
+/*
+----------------------------------------------------
+ BASELINE
+----------------------------------------------------
+ Not a general JSON parser: the bench prints one point per line, so each
+ line is searched for the keys it needs.
+----------------------------------------------------
+*/
+static int jsonString(const char* line, const char* key, char* out, size_t size) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": \"", key);
+    const char* start = strstr(line, pattern);
+    if (start == NULL) return 0;
+    start += strlen(pattern);
+    const char* end = strchr(start, '"');
+    if (end == NULL || (size_t)(end - start) >= size) return 0;
+    memcpy(out, start, end - start);
+    out[end - start] = '\0';
+    return 1;
+}
+
+static int jsonNumber(const char* line, const char* key, double* out) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    const char* start = strstr(line, pattern);
+    if (start == NULL) return 0;
+    char* end;
+    *out = strtod(start + strlen(pattern), &end);
+    return end != start + strlen(pattern);
+}
+
+// Seeds use all 64 bits: read as an integer, not through a double
+static void jsonSeed(const char* line, unsigned long long* out) {
+    const char* start = strstr(line, "\"seed\": ");
+    *out = (start != NULL) ? strtoull(start + strlen("\"seed\": "), NULL, 10) : 0;
+}
+
+Baseline* loadBaseline(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot open the baseline '%s'.\n", path);
+        return NULL;
+    }
+    Baseline* baseline = (Baseline*)calloc(1, sizeof(Baseline));
+    int capacity = 0;
+    char line[LINE_MAX_LENGTH];
+    while (baseline != NULL && fgets(line, sizeof(line), file) != NULL) {
+        BaselineEntry entry;
+        double threads, n, mad = 0.0;
+        if (!jsonString(line, "algorithm", entry.algorithm, sizeof(entry.algorithm))) continue;
+        if (!jsonString(line, "distribution", entry.distribution, sizeof(entry.distribution))) continue;
+        if (!jsonNumber(line, "threads", &threads) || !jsonNumber(line, "n", &n)) continue;
+        if (!jsonNumber(line, "seconds", &entry.median)) continue;
+        jsonNumber(line, "mad", &mad); // older files: no spread known
+        jsonSeed(line, &entry.seed);
+        entry.threads = (int)threads;
+        entry.n = (long long)n;
+        entry.mad = mad;
+
+        if (baseline->count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            BaselineEntry* grown = (BaselineEntry*)realloc(baseline->entries, capacity * sizeof(BaselineEntry));
+            if (grown == NULL) {
+                freeBaseline(baseline);
+                baseline = NULL;
+                break;
+            }
+            baseline->entries = grown;
+        }
+        baseline->entries[baseline->count++] = entry;
+    }
+    fclose(file);
+
+    if (baseline == NULL || baseline->count == 0) {
+        fprintf(stderr, "No bench point in the baseline '%s' (expected --format json output).\n", path);
+        freeBaseline(baseline);
+        return NULL;
+    }
+    return baseline;
+}
+
+const BaselineEntry* findBaseline(const Baseline* baseline, const char* algorithm, const char* distribution,
+                                  int threads, long long n) {
+    for (int i = 0; i < baseline->count; i++) {
+        const BaselineEntry* entry = &baseline->entries[i];
+        if (entry->threads == threads && entry->n == n && strcmp(entry->algorithm, algorithm) == 0
+            && strcmp(entry->distribution, distribution) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+int isRegression(const TimingSummary* now, const BaselineEntry* base, double tolerance) {
+    double difference = now->median - base->median;
+    double noise = NOISE_SIGMAS * MAD_TO_SIGMA * (now->mad > base->mad ? now->mad : base->mad);
+    return difference > tolerance * base->median && difference > noise;
+}
+
+void freeBaseline(Baseline* baseline) {
+    if (baseline == NULL) return;
+    free(baseline->entries);
+    free(baseline);
+}
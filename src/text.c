@@ -0,0 +1,169 @@
+#include "text.h"
+#include <stdio.h>  // For error messages
+#include <stdlib.h> // For malloc/free
+#include <string.h> // For strcmp and memset
+
+#define ATLAS_ROW_WIDTH 512 // glyphs are packed in rows of this width
+#define MAX_BATCH_CHARS 128 // longest string drawn in one batch
+
+GlyphAtlas* createGlyphAtlas(SDL_Renderer* renderer, TTF_Font* font) {
+    GlyphAtlas* atlas = (GlyphAtlas*)malloc(sizeof(GlyphAtlas));
+    if (atlas == NULL) {
+        fprintf(stderr, "Failed to allocate memory for glyph atlas.\n");
+        return NULL;
+    }
+    memset(atlas, 0, sizeof(GlyphAtlas));
+    atlas->font = font;
+    atlas->lineHeight = TTF_FontHeight(font);
+
+    // Render every glyph once (white, anti-aliased; color comes from the vertices)
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface* glyphSurfaces[ATLAS_GLYPHS];
+    int penX = 0, penY = 0, rowHeight = 0;
+
+    for (int c = 0; c < ATLAS_GLYPHS; c++) {
+        Uint16 ch = (Uint16)(ATLAS_FIRST_CHAR + c);
+        int advance = 0;
+        TTF_GlyphMetrics(font, ch, NULL, NULL, NULL, NULL, &advance);
+        atlas->glyphs[c].advance = advance;
+
+        glyphSurfaces[c] = TTF_RenderGlyph_Blended(font, ch, white);
+        int w = glyphSurfaces[c] ? glyphSurfaces[c]->w : 0;
+        int h = glyphSurfaces[c] ? glyphSurfaces[c]->h : 0;
+
+        // next row when this one is full
+        if (penX + w > ATLAS_ROW_WIDTH) {
+            penX = 0;
+            penY += rowHeight;
+            rowHeight = 0;
+        }
+        SDL_Rect rect = { penX, penY, w, h };
+        atlas->glyphs[c].rect = rect;
+        penX += w;
+        if (h > rowHeight) rowHeight = h;
+    }
+    atlas->width = ATLAS_ROW_WIDTH;
+    atlas->height = penY + rowHeight;
+
+    // Copy all glyphs into one surface, then upload it once
+    SDL_Surface* sheet = SDL_CreateRGBSurfaceWithFormat(0, atlas->width, atlas->height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (sheet != NULL) {
+        SDL_FillRect(sheet, NULL, 0); // fully transparent
+        for (int c = 0; c < ATLAS_GLYPHS; c++) {
+            if (glyphSurfaces[c] == NULL) continue;
+            SDL_SetSurfaceBlendMode(glyphSurfaces[c], SDL_BLENDMODE_NONE); // copy alpha as is
+            SDL_Rect dst = atlas->glyphs[c].rect;
+            SDL_BlitSurface(glyphSurfaces[c], NULL, sheet, &dst);
+        }
+        atlas->texture = SDL_CreateTextureFromSurface(renderer, sheet);
+        SDL_FreeSurface(sheet);
+    }
+    for (int c = 0; c < ATLAS_GLYPHS; c++) {
+        if (glyphSurfaces[c]) SDL_FreeSurface(glyphSurfaces[c]);
+    }
+
+    if (atlas->texture == NULL) {
+        fprintf(stderr, "Failed to create glyph atlas: %s\n", SDL_GetError());
+        free(atlas);
+        return NULL;
+    }
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    return atlas;
+}
+
+void freeGlyphAtlas(GlyphAtlas* atlas) {
+    if (atlas == NULL) return;
+
+    for (int i = 0; i < atlas->cacheCount; i++) {
+        SDL_DestroyTexture(atlas->cache[i].texture);
+    }
+    if (atlas->texture) SDL_DestroyTexture(atlas->texture);
+    free(atlas);
+}
+
+int drawAtlasText(SDL_Renderer* renderer, GlyphAtlas* atlas, const char* text, int x, int y, SDL_Color color) {
+    SDL_Vertex vertices[MAX_BATCH_CHARS * 4];
+    int indices[MAX_BATCH_CHARS * 6];
+    int quads = 0;
+    int penX = x;
+    float invW = 1.0f / atlas->width;
+    float invH = 1.0f / atlas->height;
+
+    for (const char* p = text; *p != '\0' && quads < MAX_BATCH_CHARS; p++) {
+        int c = (unsigned char)*p;
+        if (c < ATLAS_FIRST_CHAR || c > ATLAS_LAST_CHAR) c = '?';
+        const Glyph* g = &atlas->glyphs[c - ATLAS_FIRST_CHAR];
+
+        if (g->rect.w > 0) {
+            // one quad per glyph: 4 corners, 2 triangles
+            float x0 = (float)penX, y0 = (float)y;
+            float x1 = x0 + g->rect.w, y1 = y0 + g->rect.h;
+            float u0 = g->rect.x * invW, v0 = g->rect.y * invH;
+            float u1 = (g->rect.x + g->rect.w) * invW, v1 = (g->rect.y + g->rect.h) * invH;
+
+            SDL_Vertex* v = &vertices[quads * 4];
+            v[0].position.x = x0; v[0].position.y = y0; v[0].tex_coord.x = u0; v[0].tex_coord.y = v0;
+            v[1].position.x = x1; v[1].position.y = y0; v[1].tex_coord.x = u1; v[1].tex_coord.y = v0;
+            v[2].position.x = x1; v[2].position.y = y1; v[2].tex_coord.x = u1; v[2].tex_coord.y = v1;
+            v[3].position.x = x0; v[3].position.y = y1; v[3].tex_coord.x = u0; v[3].tex_coord.y = v1;
+            for (int k = 0; k < 4; k++) v[k].color = color;
+
+            int* idx = &indices[quads * 6];
+            int base = quads * 4;
+            idx[0] = base; idx[1] = base + 1; idx[2] = base + 2;
+            idx[3] = base; idx[4] = base + 2; idx[5] = base + 3;
+            quads++;
+        }
+        penX += g->advance;
+    }
+
+    if (quads > 0) {
+        SDL_RenderGeometry(renderer, atlas->texture, vertices, quads * 4, indices, quads * 6);
+    }
+    return penX - x;
+}
+
+void drawStaticText(SDL_Renderer* renderer, GlyphAtlas* atlas, const char* text, int x, int y, SDL_Color color, int* w, int* h) {
+    StaticText* entry = NULL;
+
+    // look for this line in the cache
+    for (int i = 0; i < atlas->cacheCount; i++) {
+        StaticText* e = &atlas->cache[i];
+        if (e->color.r == color.r && e->color.g == color.g && e->color.b == color.b &&
+            (e->text == text || strcmp(e->text, text) == 0)) {
+            entry = e;
+            break;
+        }
+    }
+
+    // first use: render it once with TTF
+    if (entry == NULL) {
+        if (atlas->cacheCount == STATIC_TEXT_CACHE) {
+            // cache full: fall back to the atlas
+            int width = drawAtlasText(renderer, atlas, text, x, y, color);
+            if (w) *w = width;
+            if (h) *h = atlas->lineHeight;
+            return;
+        }
+        SDL_Surface* surface = TTF_RenderText_Blended(atlas->font, text, color);
+        if (surface == NULL) return;
+        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+        if (texture == NULL) {
+            SDL_FreeSurface(surface);
+            return;
+        }
+
+        entry = &atlas->cache[atlas->cacheCount++];
+        entry->text = text;
+        entry->color = color;
+        entry->texture = texture;
+        entry->w = surface->w;
+        entry->h = surface->h;
+        SDL_FreeSurface(surface);
+    }
+
+    SDL_Rect destRect = { x, y, entry->w, entry->h };
+    SDL_RenderCopy(renderer, entry->texture, NULL, &destRect);
+    if (w) *w = entry->w;
+    if (h) *h = entry->h;
+}
@@ -0,0 +1,200 @@
+#include "trace.h"
+#include <stdlib.h> // For malloc, realloc and free
+#include <string.h> // For memcpy and memset
+
+// Smallest distance between keyframes; larger arrays use one keyframe every
+// 'size' ops so that keyframes cost about as much memory as the ops themselves.
+#define MIN_KEYFRAME_INTERVAL 256
+
+Trace* createTrace(void) {
+    Trace* trace = (Trace*)malloc(sizeof(Trace));
+    if (trace == NULL) {
+        return NULL;
+    }
+    memset(trace, 0, sizeof(Trace));
+    return trace;
+}
+
+// Copies the shadow array (and owners) into a new keyframe.
+static void pushKeyframe(Trace* trace) {
+    size_t size = (size_t)trace->size;
+
+    if (trace->keyframeCount == trace->keyframeCapacity) {
+        size_t newCapacity = trace->keyframeCapacity ? trace->keyframeCapacity * 2 : 16;
+        int* grown = (int*)realloc(trace->keyframes, newCapacity * size * sizeof(int));
+        if (grown == NULL) {
+            trace->failed = 1;
+            return;
+        }
+        trace->keyframes = grown;
+
+        if (trace->hasOwners) {
+            unsigned char* grownOwners = (unsigned char*)realloc(trace->ownerKeyframes, newCapacity * size);
+            if (grownOwners == NULL) {
+                trace->failed = 1;
+                return;
+            }
+            trace->ownerKeyframes = grownOwners;
+        }
+        trace->keyframeCapacity = newCapacity;
+    }
+    memcpy(trace->keyframes + trace->keyframeCount * size, trace->shadow, size * sizeof(int));
+    if (trace->hasOwners) {
+        memcpy(trace->ownerKeyframes + trace->keyframeCount * size, trace->ownerShadow, size);
+    }
+    trace->keyframeCount++;
+}
+
+// First TRACE_OWNER op: start tracking owners (earlier keyframes have none).
+static int enableOwners(Trace* trace) {
+    size_t size = (size_t)trace->size;
+    trace->ownerShadow = (unsigned char*)calloc(size, 1);
+    trace->ownerKeyframes = (unsigned char*)calloc(trace->keyframeCapacity * size, 1);
+    if (trace->ownerShadow == NULL || trace->ownerKeyframes == NULL) {
+        trace->failed = 1;
+        return -1;
+    }
+    trace->hasOwners = 1;
+    return 0;
+}
+
+// Frees the buffers whose size depends on the array length.
+static void freeArrayBuffers(Trace* trace) {
+    free(trace->keyframes);
+    free(trace->shadow);
+    free(trace->ownerShadow);
+    free(trace->ownerKeyframes);
+    trace->keyframes = NULL;
+    trace->shadow = NULL;
+    trace->ownerShadow = NULL;
+    trace->ownerKeyframes = NULL;
+    trace->keyframeCapacity = 0;
+}
+
+void resetTrace(Trace* trace, const int* array, int size) {
+    if (trace == NULL) return;
+
+    // Drop the array-sized buffers if the array size changed or owners were tracked
+    if (size != trace->size || trace->hasOwners) {
+        freeArrayBuffers(trace);
+    }
+
+    trace->count = 0;
+    trace->keyframeCount = 0;
+    trace->failed = 0;
+    trace->hasOwners = 0;
+    trace->size = size;
+    trace->keyframeInterval = size > MIN_KEYFRAME_INTERVAL ? (size_t)size : MIN_KEYFRAME_INTERVAL;
+
+    // Keyframe 0 is the unsorted input
+    if (array != NULL && size > 0) {
+        if (trace->shadow == NULL) trace->shadow = (int*)malloc(size * sizeof(int));
+        if (trace->shadow == NULL) {
+            trace->failed = 1;
+            return;
+        }
+        memcpy(trace->shadow, array, size * sizeof(int));
+        pushKeyframe(trace);
+    }
+}
+
+void freeTrace(Trace* trace) {
+    if (trace != NULL) {
+        free(trace->ops);
+        freeArrayBuffers(trace);
+        free(trace);
+    }
+}
+
+void traceAppend(Trace* trace, const TraceOp* ops, size_t count) {
+    if (trace->failed || trace->shadow == NULL) return; // stop recording once memory ran out
+
+    for (size_t k = 0; k < count; k++) {
+        if (trace->count == trace->capacity) {
+            size_t newCapacity = trace->capacity ? trace->capacity * 2 : 4096;
+            TraceOp* grown = (TraceOp*)realloc(trace->ops, newCapacity * sizeof(TraceOp));
+            if (grown == NULL) {
+                trace->failed = 1;
+                return;
+            }
+            trace->ops = grown;
+            trace->capacity = newCapacity;
+        }
+        if ((ops[k].head >> TRACE_TYPE_SHIFT) == TRACE_OWNER && !trace->hasOwners) {
+            if (enableOwners(trace) != 0) return;
+        }
+        trace->ops[trace->count++] = ops[k];
+
+        // keep the shadow in step, it feeds the keyframes
+        int h1, h2;
+        traceApply(trace, trace->count - 1, trace->count, trace->shadow, trace->ownerShadow, &h1, &h2);
+
+        if (trace->count % trace->keyframeInterval == 0) {
+            pushKeyframe(trace);
+        }
+    }
+}
+
+void traceApply(const Trace* trace, size_t from, size_t to, int* array, unsigned char* owners,
+                int* highlight1, int* highlight2) {
+    if (to > trace->count) to = trace->count;
+
+    for (size_t k = from; k < to; k++) {
+        TraceOp op = trace->ops[k];
+        int a = (int)(op.head & TRACE_INDEX_MASK);
+
+        switch (op.head >> TRACE_TYPE_SHIFT) {
+            case TRACE_SWAP: {
+                int tmp = array[a];
+                array[a] = array[op.arg];
+                array[op.arg] = tmp;
+                break;
+            }
+            case TRACE_WRITE:
+                array[a] = (int)op.arg;
+                break;
+            case TRACE_OWNER:
+                if (owners != NULL) {
+                    int high = (int)(op.arg & TRACE_INDEX_MASK);
+                    unsigned char owner = (unsigned char)((op.arg >> TRACE_TYPE_SHIFT) + 1);
+                    if (high >= trace->size) high = trace->size - 1;
+                    for (int i = a; i <= high; i++) owners[i] = owner;
+                }
+                break;
+            default: // TRACE_COMPARE and TRACE_READ change nothing
+                break;
+        }
+    }
+
+    // Highlight what the last replayed op touched
+    *highlight1 = -1;
+    *highlight2 = -1;
+    if (to > 0) {
+        TraceOp last = trace->ops[to - 1];
+        unsigned type = last.head >> TRACE_TYPE_SHIFT;
+        if (type != TRACE_OWNER) {
+            *highlight1 = (int)(last.head & TRACE_INDEX_MASK);
+            if (type != TRACE_WRITE && type != TRACE_READ) {
+                *highlight2 = (int)last.arg;
+            }
+        }
+    }
+}
+
+void traceSeek(const Trace* trace, size_t position, int* array, unsigned char* owners,
+               int* highlight1, int* highlight2) {
+    if (trace->keyframeCount == 0) return; // nothing recorded
+
+    if (position > trace->count) position = trace->count;
+
+    size_t keyframe = position / trace->keyframeInterval;
+    if (keyframe >= trace->keyframeCount) keyframe = trace->keyframeCount - 1;
+
+    size_t size = (size_t)trace->size;
+    memcpy(array, trace->keyframes + keyframe * size, size * sizeof(int));
+    if (owners != NULL) {
+        if (trace->hasOwners) memcpy(owners, trace->ownerKeyframes + keyframe * size, size);
+        else memset(owners, 0, size);
+    }
+    traceApply(trace, keyframe * trace->keyframeInterval, position, array, owners, highlight1, highlight2);
+}
@@ -0,0 +1,80 @@
+#include "typed.h"
+#include "instrument.h"
+#include <string.h> // For memcpy
+
+/*
+----------------------------------------------------
+ 64-BIT KEYS
+----------------------------------------------------
+*/
+#define SORT_NAME i64
+#define SORT_TYPE int64_t
+#define SORT_LESS(a, b) (*(a) < *(b))
+#include "sort_template.h"
+
+/*
+----------------------------------------------------
+ DOUBLES
+----------------------------------------------------
+ '<' alone is not an order once NaN is there (every comparison with NaN is
+ false, so a partition can stop anywhere). NaNs go last instead.
+----------------------------------------------------
+*/
+#define SORT_NAME f64
+#define SORT_TYPE double
+#define SORT_LESS(a, b) f64Less(*(a), *(b))
+#include "sort_template.h"
+
+/*
+----------------------------------------------------
+ RECORDS (16-byte key + payload)
+----------------------------------------------------
+*/
+#define RECORD_LESS(a, b) ((a)->keyHigh < (b)->keyHigh || \
+                           ((a)->keyHigh == (b)->keyHigh && (a)->keyLow < (b)->keyLow))
+
+#define SORT_NAME record
+#define SORT_TYPE Record
+#define SORT_LESS(a, b) RECORD_LESS(a, b)
+#include "sort_template.h"
+
+// Key and position of a record: 24 bytes moved instead of 64
+typedef struct {
+    uint64_t keyHigh;
+    uint64_t keyLow;
+    int index;
+} RecordTag;
+
+#define SORT_NAME tag
+#define SORT_TYPE RecordTag
+#define SORT_SCOPE static __attribute__((unused)) // only tag_intro_sort is used
+#define SORT_LESS(a, b) RECORD_LESS(a, b)
+#include "sort_template.h"
+
+int record_tag_sort(Record* tab, int size, Stats_t* stats, Arena* arena) {
+    size_t tagsBytes = (size_t)size * sizeof(RecordTag);
+    size_t sortedBytes = (size_t)size * sizeof(Record);
+    RecordTag* tags = (RecordTag*)arenaAlloc(arena, tagsBytes, stats);
+    Record* sorted = (Record*)arenaAlloc(arena, sortedBytes, stats);
+    if (tags == NULL || sorted == NULL) {
+        arenaFree(arena, tags, tagsBytes, stats);
+        arenaFree(arena, sorted, sortedBytes, stats);
+        return -1;
+    }
+
+    for (int i = 0; i < size; i++) {
+        tags[i].keyHigh = tab[i].keyHigh;
+        tags[i].keyLow = tab[i].keyLow;
+        tags[i].index = i;
+    }
+    tag_intro_sort(tags, size, stats);
+
+    // every record moved once: gathered in order, then copied back
+    for (int i = 0; i < size; i++) sorted[i] = tab[tags[i].index];
+    memcpy(tab, sorted, (size_t)size * sizeof(Record));
+    stats->memoryAccesses += 4LL * size; // tag build, gather (read + write), copy back
+
+    arenaFree(arena, tags, tagsBytes, stats);
+    arenaFree(arena, sorted, sortedBytes, stats);
+    return 0;
+}
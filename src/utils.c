@@ -3,75 +3,331 @@
 #include "visual.h"
 #include "sorting.h"
 #include "stats.h"
+#include "race.h"
+#include "introsort.h" // For selectRank
+#include "registry.h"  // For the algorithm keys
 #include <time.h>   
-#include <stdlib.h> // For rand() and malloc()
+#include <stdlib.h> // For malloc()
+#include <string.h> // For memset
 #include <SDL2/SDL.h>
 
+#define FRAME_MS 16      // target frame time (~60 fps)
+#define DRAIN_CHUNK 4096 // ops copied from the ring at a time
+#define MIN_LOOKAHEAD (1 << 20) // ops the trace may hold beyond the replay cursor
+
+// Moves the ops produced by the sort thread into the trace.
+// Stops once the trace is far enough ahead of the replay, so a fast sort
+// waits on its ring instead of filling memory.
+static void drainWorker(App_Window* app) {
+    TraceOp chunk[DRAIN_CHUNK];
+    size_t lookahead = (size_t)app->replaySpeed * 8;
+    if (lookahead < MIN_LOOKAHEAD) lookahead = MIN_LOOKAHEAD;
+
+    while (app->trace->count < app->replayCursor + lookahead && !app->trace->failed) {
+        size_t n = ringPop(app->worker->ring, chunk, DRAIN_CHUNK);
+        if (n == 0) break;
+        traceAppend(app->trace, chunk, n);
+        accessMapRecord(app->access, chunk, n);
+    }
+    if (app->trace->failed) {
+        fprintf(stderr, "Trace truncated (out of memory), sort stopped.\n");
+        stopSortWorker(app->worker);
+    }
+
+    if (app->worker->thread != NULL) {
+        readSortWorkerStats(app->worker, app->stats);
+    }
+}
+
+// 1 when the sort thread is done and all of its ops are in the trace.
+static int sortFinished(App_Window* app) {
+    return atomic_load(&app->worker->finished) && ringSize(app->worker->ring) == 0;
+}
+
+// Moves the replay to 'position' (clamped to what is recorded so far).
+static void seekReplay(App_Window* app, long long position) {
+    if (position < 0) position = 0;
+    if (position > (long long)app->trace->count) position = (long long)app->trace->count;
+
+    traceSeek(app->trace, (size_t)position, app->array, app->owners, &app->highlight1, &app->highlight2);
+    markAllBarsDirty(app->bars);
+    app->replayCursor = (size_t)position;
+}
+
+int arrayMaxValue(const App_Window* app) {
+    return app->maxValue > 0 ? app->maxValue : app->size;
+}
+
+int createAppArray(App_Window* app) {
+    free(app->array);
+    free(app->owners);
+    // large arrays are generated on the sort pool (same array whatever the core count)
+    ThreadPool* pool = (app->worker != NULL) ? app->worker->pool : NULL;
+    app->array = createDataset(app->size, arrayMaxValue(app), app->distribution, 0, app->seed, pool);
+    app->owners = (unsigned char*)calloc(app->size, 1);
+    if (app->array == NULL || app->owners == NULL) return -1;
+    return 0;
+}
+
+// Replays the next replaySpeed ops onto the array (stops at the end of a finished sort).
+static void advanceReplay(App_Window* app) {
+    size_t next = app->replayCursor + (size_t)app->replaySpeed;
+    if (next >= app->trace->count) {
+        next = app->trace->count;
+        if (sortFinished(app)) app->playing = 0; // finished
+    }
+    traceApply(app->trace, app->replayCursor, next, app->array, app->owners,
+               &app->highlight1, &app->highlight2);
+    markTraceDirty(app->bars, app->trace, app->replayCursor, next, app->size);
+    app->replayCursor = next;
+    if (!app->playing) {
+        app->highlight1 = -1; // final clean frame (no highlights)
+        app->highlight2 = -1;
+    }
+}
+
+// Drops the current sort; the next 'S' starts from the array as shown now.
+static void dropSort(App_Window* app) {
+    stopSortWorker(app->worker);
+    resetTrace(app->trace, NULL, 0);
+    resetAccessMap(app->access, app->size);
+    memset(app->owners, 0, app->size);
+    app->replayCursor = 0;
+    app->playing = 0;
+}
+
+// Race mode keys: the number keys pick the lanes, S/E/arrows drive all of
+// them at once. Return 1 if 'actionCode' was a race action.
+static int handleRaceAction(App_Window* app, int actionCode) {
+    Race* race = app->race;
+    if (algorithmInfo(actionCode) != NULL) {
+        // picking lanes starts over from the input
+        app->playing = 0;
+        if (toggleRaceLane(race, actionCode) != 0) {
+            printf("A race holds at most %d algorithms.\n", RACE_MAX_LANES);
+        }
+    }
+    else if (actionCode == 100) { // 'S' = Start / Resume
+        if (!race->started) {
+            if (race->laneCount < 2) {
+                printf("Pick at least 2 algorithms to race!\n");
+            } else if (startRace(race, app->array, app->size, selectRank(app->selectK, app->size)) != 0) {
+                fprintf(stderr, "Failed to start the race.\n");
+            } else {
+                app->playing = 1;
+            }
+        } else {
+            // replay again from the start once every lane is over
+            if (!updateRace(race, 0)) seekRace(race, 0, 0);
+            pauseRace(race, 0);
+            app->playing = 1;
+        }
+    }
+    else if (actionCode == 50) { // 'E' = Pause
+        app->playing = 0;
+        pauseRace(race, 1);
+    }
+    else if (actionCode >= 60 && actionCode <= 65) {
+        if (actionCode == 62) { // Up = faster
+            if (app->replaySpeed < (1 << 24)) app->replaySpeed *= 2;
+        } else if (actionCode == 63) { // Down = slower
+            if (app->replaySpeed > 1) app->replaySpeed /= 2;
+        } else {
+            app->playing = 0;
+            if (actionCode == 60) seekRace(race, -2, -app->replaySpeed);
+            else if (actionCode == 61) seekRace(race, -2, app->replaySpeed);
+            else seekRace(race, actionCode == 64 ? 0 : -1, 0);
+        }
+    }
+    else {
+        return 0;
+    }
+    return 1;
+}
+
 void runMainLoop(App_Window* app) {
     int actionCode = 0; //stores the user's keyboard input
 
-    printf("Press 1, 2, or 3. Then 'S' to Start. 'R' to Reset. 'E' to Stop. '\n");
+    printf("Algorithms:");
+    for (int id = 1; id <= algorithmCount(); id++) {
+        const AlgorithmInfo* info = algorithmInfo(id);
+        if (info->key != 0) printf("%s %c %s", id > 1 ? "," : "", info->key, info->label);
+    }
+    printf("\nPress the key of an algorithm, then 'S' to Start/Resume. 'R' to Reset. 'E' to Pause.\n");
+    printf("Left/Right to step, Up/Down to change speed, Home/End to jump.\n");
+    printf("'N' multiplies the array size by 10, Shift+N divides it by 10.\n");
+    printf("'H' shows where and when the sort reads and writes the array.\n");
+    printf("'C' toggles race mode: pick 2 to %d algorithms, then 'S' sorts them side by side.\n", RACE_MAX_LANES);
     
     while (app->running) {
+        Uint32 frameStart = SDL_GetTicks();
         
         // EVENT HANDLING
         //check for user input
         actionCode = handleEvents(&app->running);
         
         // LOGIC
+        if (app->raceMode && handleRaceAction(app, actionCode)) {
+            // handled by the race
+        }
+        else if (actionCode == 75) { // 'C' = race mode on / off
+            dropSort(app);
+            stopRace(app->race);
+            app->raceMode = !app->raceMode;
+            app->selectedAlgorithm = 0;
+            markAllBarsDirty(app->bars);
+        }
+        else if (actionCode == 85) { // 'H' = access heatmap on / off
+            app->showAccess = !app->showAccess;
+            markAllBarsDirty(app->bars); // the bars change height
+        }
         // user pressed
-        if (actionCode > 0 && actionCode < 10) {
+        else if (algorithmInfo(actionCode) != NULL) {
             app->selectedAlgorithm = actionCode; // store the choice
+            dropSort(app);
         }
-        else if (actionCode == 99) { // 'R' = Reset
-            free(app->array);
-            app->array = createRandomArray(N, WINDOW_HEIGHT);
+        else if (actionCode == 99 || actionCode == 70 || actionCode == 80 || actionCode == 81) {
+            // 'R' = Reset, 'D' = next input shape, 'N' / Shift+N = 10x more / fewer elements
+            dropSort(app);
+            stopRace(app->race); // the lanes show the new input
+            if (actionCode == 99) app->seed++; // new array, the session stays reproducible
+            else if (actionCode == 70) app->distribution = (app->distribution + 1) % DATASET_COUNT;
+            else if (actionCode == 80) app->size = (app->size > MAX_ARRAY_SIZE / 10) ? MIN_ARRAY_SIZE : app->size * 10;
+            else app->size = (app->size / 10 < MIN_ARRAY_SIZE) ? MAX_ARRAY_SIZE : app->size / 10;
             app->selectedAlgorithm = 0;
-            if (app->array == NULL) {
+            if (createAppArray(app) != 0) {
                 fprintf(stderr, "Failed to reset array.\n");
                 app->running = 0; // Exit on error
             }
             resetStats(app->stats); //reset stats to 0
+            markAllBarsDirty(app->bars);
+            app->highlight1 = -1;
+            app->highlight2 = -1;
         }
 
-        else if (actionCode == 100) { // 'S' = Start
-            // start timer
-            app->stats->startTicks = SDL_GetPerformanceCounter();
-            
-            switch (app->selectedAlgorithm) {
-                case 1:
-                    bubble_sort(app); 
-                    break;
-                case 2:
-                    selection_sort(app); 
-                    break;
-                case 3:
-                    insertion_sort(app);
-                    break;
-                case 4:
-                    quick_sort(app);
-                    break;
-                default:
+        else if (actionCode == 100) { // 'S' = Start / Resume
+            if (app->trace->keyframeCount == 0) {
+                if (app->selectedAlgorithm == 0) {
                     printf("No algorithm selected!\n");
-                    app->stats->startTicks = 0;
-                    break;
-            }
-            //Stop the timer and save the time
-            if (app->stats->startTicks != 0) { 
-                Uint64 endTicks = SDL_GetPerformanceCounter();
-                Uint64 frequency = SDL_GetPerformanceFrequency();
-                
-                //add the elapsed time to the total
-                app->stats->executionTime += (double)(endTicks - app->stats->startTicks) / frequency;
-
-                app->stats->startTicks = 0;  //disarm the timer
+                } else if (startSortWorker(app->worker, app->selectedAlgorithm, app->array, app->size,
+                                           selectRank(app->selectK, app->size), app->stats, app->arena) != 0) {
+                    fprintf(stderr, "Failed to start the sort.\n");
+                } else {
+                    resetTrace(app->trace, app->array, app->size);
+                    resetAccessMap(app->access, app->size);
+                    app->replayCursor = 0;
+                    app->playing = 1;
+                }
+            } else {
+                // replay again from the start if it already reached the end
+                if (sortFinished(app) && app->replayCursor >= app->trace->count) seekReplay(app, 0);
+                pauseSortWorker(app->worker, 0);
+                app->playing = 1;
             }
         }
+        else if (actionCode == 50) { // 'E' = Pause (resume with 'S')
+            app->playing = 0;
+            pauseSortWorker(app->worker, 1);
+        }
+        else if (actionCode == 60) { // Left = step back one frame
+            app->playing = 0;
+            seekReplay(app, (long long)app->replayCursor - app->replaySpeed);
+        }
+        else if (actionCode == 61) { // Right = step forward one frame
+            app->playing = 0;
+            seekReplay(app, (long long)app->replayCursor + app->replaySpeed);
+        }
+        else if (actionCode == 62) { // Up = faster
+            if (app->replaySpeed < (1 << 24)) app->replaySpeed *= 2;
+        }
+        else if (actionCode == 63) { // Down = slower
+            if (app->replaySpeed > 1) app->replaySpeed /= 2;
+        }
+        else if (actionCode == 64) { // Home = jump to the start
+            seekReplay(app, 0);
+        }
+        else if (actionCode == 65) { // End = jump to the last recorded op
+            seekReplay(app, (long long)app->trace->count);
+        }
+        else if (actionCode == 90) { // window resized: the bars follow the new size
+            SDL_GetWindowSize(app->window, &app->windowWidth, &app->windowHeight);
+            markAllBarsDirty(app->bars);
+            for (int l = 0; l < app->race->laneCount; l++) markAllBarsDirty(app->race->lanes[l].bars);
+        }
+
+        if (app->raceMode) {
+            // every lane collects its sort thread's ops and replays replaySpeed of them
+            if (!updateRace(app->race, app->playing ? app->replaySpeed : 0)) app->playing = 0;
+        } else {
+            // SORT: collect what the sort thread produced since the last frame
+            drainWorker(app);
+
+            // REPLAY: advance by replaySpeed ops per frame
+            if (app->playing) advanceReplay(app);
+        }
 
         // DRAWING
-        renderApp(app, -1, -1);
+        renderApp(app, app->highlight1, app->highlight2);
+
+        // keep a steady frame time whatever the budget cost
+        Uint32 elapsed = SDL_GetTicks() - frameStart;
+        if (elapsed < FRAME_MS) SDL_Delay(FRAME_MS - elapsed);
+    }
+}
+
+int runRecording(App_Window* app, int algorithm, FrameWriter* writer, int holdFrames) {
+    app->selectedAlgorithm = algorithm;
+    if (startSortWorker(app->worker, algorithm, app->array, app->size, selectRank(app->selectK, app->size),
+                        app->stats, app->arena) != 0) {
+        fprintf(stderr, "Failed to start the sort.\n");
+        return -1;
+    }
+    resetTrace(app->trace, app->array, app->size);
+    resetAccessMap(app->access, app->size);
+    app->replayCursor = 0;
+    app->playing = 1;
+
+    long long frames = 0;
+    while (app->playing) {
+        // every frame shows replaySpeed ops, however fast the sort thread is
+        while (app->trace->count < app->replayCursor + (size_t)app->replaySpeed && !sortFinished(app)
+               && !app->trace->failed) {
+            size_t before = app->trace->count;
+            drainWorker(app);
+            if (app->trace->count == before) SDL_Delay(1);
+        }
+        drainWorker(app);
 
-        SDL_Delay(16);
+        advanceReplay(app);
+        renderApp(app, app->highlight1, app->highlight2);
+        if (writeFrame(writer, app->frame->pixels, app->frame->pitch) != 0) return -1;
+        frames++;
+        if (frames % 600 == 0) {
+            fprintf(stderr, "\rRecording: %lld frames, op %zu", frames, app->replayCursor);
+        }
+    }
+    // the sorted array stays on screen for a moment
+    for (int f = 0; f < holdFrames; f++) {
+        if (writeFrame(writer, app->frame->pixels, app->frame->pitch) != 0) return -1;
+    }
+    fprintf(stderr, "\rRecording: %lld frames, %zu ops\n", frames + holdFrames, app->replayCursor);
+    return 0;
+}
+
+// Keypad digits act as the digit keys
+static int keypadDigit(SDL_Keycode key) {
+    switch (key) {
+        case SDLK_KP_0: return '0';
+        case SDLK_KP_1: return '1';
+        case SDLK_KP_2: return '2';
+        case SDLK_KP_3: return '3';
+        case SDLK_KP_4: return '4';
+        case SDLK_KP_5: return '5';
+        case SDLK_KP_6: return '6';
+        case SDLK_KP_7: return '7';
+        case SDLK_KP_8: return '8';
+        case SDLK_KP_9: return '9';
+        default: return (int)key;
     }
 }
 
@@ -87,81 +343,75 @@ int handleEvents(int* running) {
             *running = 0;
             running=0;  // no action
         }
+
+        // The window was resized (by the user or the window manager)
+        if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+            return 90;
+        }
         
        // Action with keyboard
         if (event.type == SDL_KEYDOWN) {
             switch (event.key.keysym.sym) {
-                // case '1'
-                case SDLK_1:
-                case SDLK_KP_1:
-                    printf("Key 1 pressed: Requesting Bubble Sort\n");
-                    return 1; // actionCode for case
-
-                // case '2'
-                case SDLK_2:
-                case SDLK_KP_2:
-                    printf("Key 2 pressed: Requesting Selection Sort\n");
-                    return 2; // actionCode for case
-                
-                // case '3'
-                case SDLK_3:
-                case SDLK_KP_3:
-                    printf("Key 3 pressed: Requesting Insertion Sort\n");
-                    return 3; // actionCode for case
-                
-                // case '4'
-                case SDLK_4:
-                case SDLK_KP_4:
-                    printf("Key 4 pressed: Requesting Quick Sort\n");
-                    return 4; // actionCode for case
-
                 // 'r' to unsort the window
                 case SDLK_r:
                     printf("Key R pressed: Requesting array reset\n");
                     return 99; // actionCode for case
 
+                case SDLK_d:
+                    printf("Key D pressed: Requesting next input shape\n");
+                    return 70;
+
+                // 'n' = 10x more elements, Shift+'n' = 10x fewer
+                case SDLK_n:
+                    if (event.key.keysym.mod & KMOD_SHIFT) {
+                        printf("Key Shift+N pressed: Requesting a smaller array\n");
+                        return 81;
+                    }
+                    printf("Key N pressed: Requesting a larger array\n");
+                    return 80;
+
                 case SDLK_s:
-                    printf("Key S pressed: Starting Sort\n");
+                    printf("Key S pressed: Starting / Resuming Sort\n");
                     return 100; // actionCode for case
 
                 case SDLK_e:
-                    printf("Key E pressed: Stopping Sort\n");
+                    printf("Key E pressed: Pausing Sort\n");
                     return 50;
+
+                case SDLK_c:
+                    printf("Key C pressed: Toggling race mode\n");
+                    return 75;
+
+                case SDLK_h:
+                    printf("Key H pressed: Toggling the access heatmap\n");
+                    return 85;
+
+                // replay controls
+                case SDLK_LEFT:
+                    return 60;
+                case SDLK_RIGHT:
+                    return 61;
+                case SDLK_UP:
+                    return 62;
+                case SDLK_DOWN:
+                    return 63;
+                case SDLK_HOME:
+                    return 64;
+                case SDLK_END:
+                    return 65;
+
+                // the algorithm keys come from the registry (registry.h)
+                default: {
+                    int id = findAlgorithmByKey(keypadDigit(event.key.keysym.sym));
+                    if (id != 0) {
+                        const AlgorithmInfo* info = algorithmInfo(id);
+                        printf("Key %c pressed: Requesting %s\n", info->key, info->label);
+                        return id; // actionCode = algorithm id
+                    }
+                    break;
+                }
             }
         }   
     }
     return 0; // no action
 }
-
-//creates a random shuffled array of numbers
-int* createRandomArray(int size, int maxValue) {
-    
-    int* array = (int*)malloc(size * sizeof(int));
-
-    // Always check if memory allocation was successful
-    if (array == NULL) {
-        return NULL; // Return NULL (error) if malloc failed
-    }
-
-    //loop to fill the array
-    for (int i = 0; i < size; i++) {
-       
-        //new 'random', lead to have a perfect line after the sort and not an irregular line
-        array[i] = (int)(((double)i / (size - 1)) * (maxValue - 1)) + 1;
-        //array[i] = (rand() % maxValue) + 1;  // We add +1 to avoid 0-height bars (values from 1 to maxValue) // OLD RANDOM
-    }
-    // Shuffle
-    // Start from last and shuffle
-    for (int i = size - 1; i > 0; i--) {
-        int j = rand() % (i + 1); 
-        // switch array[i] with index j
-        int temp = array[i];
-        array[i] = array[j];
-        array[j] = temp;
-    }
-    // We return the pointer to the array so main.c can use it.
-    return array;
-}
-
-
-
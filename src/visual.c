@@ -1,13 +1,20 @@
 #include "visual.h"
-#include "main.h"   // For global constants (N, WINDOW_WIDTH, etc.)
-#include "utils.h"  // For createRandomArray (part of init)
+#include "main.h"   // For App_Window, AppConfig and MENU_WIDTH
+#include "utils.h"  // For createAppArray (part of init)
 #include "stats.h"
+#include "race.h"   // For the race lanes
+#include "introsort.h" // For selectRank and SELECT_DISCARD_COLOR
+#include "registry.h"  // For the menu rows
+#include "strsort.h"   // For the keys of the string sorts
+#include <math.h>   // For log (heatmap scale)
 #include <stdio.h>  // For error messages
 #include <stdlib.h> // For malloc/free
+#include <string.h> // For memset
+#include <time.h>   // For time() (first seed)
 #include <SDL2/SDL.h>
 
 //init all SDL/TTF systems and creates the app struct
-App_Window* initAppVisuals() {
+App_Window* initAppVisuals(const AppConfig* config) {
     // Allocate memory for the App struct itself
     App_Window* app = (App_Window*)malloc(sizeof(App_Window));
     if (app == NULL) {
@@ -16,13 +23,28 @@ App_Window* initAppVisuals() {
     }
     // Set pointers to NULL initially for safe cleanup
     app->window = NULL;
+    app->frame = NULL;
     app->renderer = NULL;
     app->font = NULL;
+    app->atlas = NULL;
+    app->bars = NULL;
     app->array = NULL;
+    app->owners = NULL;
+    app->stats = NULL;
+    app->trace = NULL;
+    app->worker = NULL;
+    app->arena = NULL;
+    app->race = NULL;
+    app->access = NULL;
+    app->accessTexture = NULL;
+    app->size = config->size;
+    app->maxValue = config->maxValue;
+    app->windowWidth = config->windowWidth;
+    app->windowHeight = config->windowHeight;
 
 
-    // Initialize SDL
-    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+    // Initialize SDL (headless: no video subsystem, the software renderer needs none)
+    if (SDL_Init(config->headless ? 0 : SDL_INIT_VIDEO) != 0) {
         fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
         cleanupAppVisuals(app); // Call cleanup (handles partial init)
         return NULL;
@@ -35,20 +57,33 @@ App_Window* initAppVisuals() {
         return NULL;
     }
 
-    // Create Window
-    app->window = SDL_CreateWindow(
-        "Project C - Sorting Visualization",
-        SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-        WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN
-    );
-    if (app->window == NULL) {
-        fprintf(stderr, "Window creation failed: %s\n", SDL_GetError());
-        cleanupAppVisuals(app);
-        return NULL;
-    }
+    if (config->headless) {
+        // Offscreen surface: the same drawing code renders the frames to record
+        app->frame = SDL_CreateRGBSurfaceWithFormat(0, app->windowWidth, app->windowHeight, 32,
+                                                    SDL_PIXELFORMAT_ARGB8888);
+        if (app->frame == NULL) {
+            fprintf(stderr, "Offscreen surface creation failed: %s\n", SDL_GetError());
+            cleanupAppVisuals(app);
+            return NULL;
+        }
+        app->renderer = SDL_CreateSoftwareRenderer(app->frame);
+    } else {
+        // Create Window
+        app->window = SDL_CreateWindow(
+            "Project C - Sorting Visualization",
+            SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+            app->windowWidth, app->windowHeight, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE
+        );
+        if (app->window == NULL) {
+            fprintf(stderr, "Window creation failed: %s\n", SDL_GetError());
+            cleanupAppVisuals(app);
+            return NULL;
+        }
+        SDL_SetWindowMinimumSize(app->window, MIN_WINDOW_WIDTH, MIN_WINDOW_HEIGHT);
 
-    // Create Renderer
-    app->renderer = SDL_CreateRenderer(app->window, -1, SDL_RENDERER_ACCELERATED);
+        // Create Renderer
+        app->renderer = SDL_CreateRenderer(app->window, -1, SDL_RENDERER_ACCELERATED);
+    }
     if (app->renderer == NULL) {
         fprintf(stderr, "Renderer creation failed: %s\n", SDL_GetError());
         cleanupAppVisuals(app);
@@ -63,9 +98,28 @@ App_Window* initAppVisuals() {
         return NULL;
     }
 
+    // Build the glyph atlas once (no text rasterization per frame)
+    app->atlas = createGlyphAtlas(app->renderer, app->font);
+    if (app->atlas == NULL) {
+        cleanupAppVisuals(app);
+        return NULL;
+    }
+
+    // Bar rendering buffers
+    app->bars = createBarCache();
+    if (app->bars == NULL) {
+        fprintf(stderr, "Failed to create bar cache.\n");
+        cleanupAppVisuals(app);
+        return NULL;
+    }
+
     // Create Array (Data is initialized along with visuals here)
-    app->array = createRandomArray(N, WINDOW_HEIGHT); // 50px margin
-    if (app->array == NULL) {
+    // the seed is printed so that an interesting input can be generated again
+    app->distribution = DATASET_SHUFFLED;
+    app->seed = (uint64_t)time(NULL);
+    // (with the worker colors of the parallel sorts, none yet)
+    printf("Array seed: %llu\n", (unsigned long long)app->seed);
+    if (createAppArray(app) != 0) {
         fprintf(stderr, "Failed to create array (malloc failed).\n");
         cleanupAppVisuals(app);
         return NULL;
@@ -79,9 +133,57 @@ App_Window* initAppVisuals() {
         return NULL;
     }
 
+    // Scratch memory of the sorts (grows on the first runs, then reused)
+    app->arena = createArena(0);
+    if (app->arena == NULL){
+        fprintf(stderr, "Failed to create scratch arena.\n");
+        cleanupAppVisuals(app);
+        return NULL;
+    }
+
+    // Trace of the operations (filled when a sort starts)
+    app->trace = createTrace();
+    if (app->trace == NULL){
+        fprintf(stderr, "Failed to create trace struct.\n");
+        cleanupAppVisuals(app);
+        return NULL;
+    }
+
+    // Sort thread (idle until 'S')
+    app->worker = createSortWorker(1 << 16);
+    if (app->worker == NULL){
+        fprintf(stderr, "Failed to create sort worker.\n");
+        cleanupAppVisuals(app);
+        return NULL;
+    }
+
+    // Access pattern of the sorts (filled with the trace)
+    app->access = createAccessMap();
+    if (app->access == NULL){
+        fprintf(stderr, "Failed to create access map.\n");
+        cleanupAppVisuals(app);
+        return NULL;
+    }
+
+    // Race lanes (none until picked in race mode)
+    app->race = createRace();
+    if (app->race == NULL){
+        fprintf(stderr, "Failed to create race struct.\n");
+        cleanupAppVisuals(app);
+        return NULL;
+    }
+
     // Set initial state
     app->running = 1;
+    app->raceMode = 0;
+    app->showAccess = config->showAccess;
+    app->selectK = config->selectK;
     app->selectedAlgorithm = 0;
+    app->replayCursor = 0;
+    app->replaySpeed = 4;
+    app->playing = 0;
+    app->highlight1 = -1;
+    app->highlight2 = -1;
 
     printf("SDL & TTF initialization successful!\n");
     return app;
@@ -91,11 +193,21 @@ void cleanupAppVisuals(App_Window* app) {
     if (app == NULL) return; 
 
     freeStats(app->stats);
+    freeTrace(app->trace);
+    freeSortWorker(app->worker); // stops the sort thread first
+    freeArena(app->arena);       // after the worker: its last run may still use it
+    freeRace(app->race);         // before the renderer: the lanes own bar textures
+    freeAccessMap(app->access);
+    if (app->accessTexture) SDL_DestroyTexture(app->accessTexture);
     // Free all resources in reverse order of creation
     // Check if pointers are not NULL before freeing/destroying
     if (app->array) free(app->array);
+    free(app->owners);
+    freeBarCache(app->bars);
+    freeGlyphAtlas(app->atlas);
     if (app->font) TTF_CloseFont(app->font);
     if (app->renderer) SDL_DestroyRenderer(app->renderer);
+    if (app->frame) SDL_FreeSurface(app->frame);
     if (app->window) SDL_DestroyWindow(app->window);
     
     // Quit SDL subsystems only after destroying components
@@ -107,37 +219,26 @@ void cleanupAppVisuals(App_Window* app) {
     printf("Cleanup complete.\n"); 
 }
 
-// Helper function to draw text
-void drawText(SDL_Renderer* renderer, TTF_Font* font, const char* text, 
+// Helper function to draw a static line (menu entries), with a border when selected
+void drawText(SDL_Renderer* renderer, GlyphAtlas* atlas, const char* text, 
               int x, int y, SDL_Color color, int isSelected) 
 {
-    SDL_Surface* surface = TTF_RenderText_Solid(font, text, color);
-    if (surface == NULL) return; 
-
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    if (texture == NULL) {
-        SDL_FreeSurface(surface);
-        return; 
-    }
-
-    SDL_Rect destRect = { x, y, surface->w, surface->h };
-    SDL_RenderCopy(renderer, texture, NULL, &destRect);
+    int w = 0, h = 0;
+    drawStaticText(renderer, atlas, text, x, y, color, &w, &h);
 
     if (isSelected) {
         SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-        SDL_Rect borderRect = { destRect.x - 2, destRect.y - 2, destRect.w + 4, destRect.h + 4 };
+        SDL_Rect borderRect = { x - 2, y - 2, w + 4, h + 4 };
         SDL_RenderDrawRect(renderer, &borderRect);
     }
-
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
 }
 
 // Draw the right-hand menu
-void drawLegend(SDL_Renderer* renderer, TTF_Font* font, int selectedAlgorithm) {
-    int menuX = 610; 
+void drawLegend(SDL_Renderer* renderer, GlyphAtlas* atlas, int selectedAlgorithm, const Race* race,
+                int distribution, int size, int k, int windowWidth, int windowHeight) {
+    int menuX = windowWidth - MENU_WIDTH + 10;
     
-    SDL_Rect menuBg = { menuX - 10, 0, 200, WINDOW_HEIGHT };
+    SDL_Rect menuBg = { menuX - 10, 0, MENU_WIDTH, windowHeight };
     SDL_SetRenderDrawColor(renderer, 50, 50, 50, 255); // Dark grey
     SDL_RenderFillRect(renderer, &menuBg);
 
@@ -146,21 +247,71 @@ void drawLegend(SDL_Renderer* renderer, TTF_Font* font, int selectedAlgorithm) {
     SDL_Color red = {255, 0, 0, 255};
     SDL_Color green = {0, 255, 127, 255};
 
-    drawText(renderer, font, "1: Bubble Sort", menuX, 40, white, (selectedAlgorithm == 1));
-    drawText(renderer, font, "2: Selection Sort", menuX, 70, white, (selectedAlgorithm == 2));
-    drawText(renderer, font, "3: Insertion Sort", menuX, 100, white, (selectedAlgorithm == 3));
-    drawText(renderer, font, "4: Quick Sort", menuX, 130, white, (selectedAlgorithm == 4));
+    // in race mode every algorithm with a lane is selected
+    int selected[ALGO_MAX + 1] = {0};
+    if (race != NULL) {
+        for (int l = 0; l < race->laneCount; l++) selected[race->lanes[l].algorithm] = 1;
+    } else if (algorithmInfo(selectedAlgorithm) != NULL) {
+        selected[selectedAlgorithm] = 1;
+    }
+
+    // one row per algorithm with a key (registry.h), closer together as
+    // plugins add rows; past 18 rows the last one counts the rest
+    int rows = 0;
+    for (int id = 1; id <= algorithmCount(); id++) {
+        if (algorithmInfo(id)->key != 0) rows++;
+    }
+    int spacing = (rows * 25 <= LEGEND_ROWS_HEIGHT) ? 25 : LEGEND_ROWS_HEIGHT / rows;
+    if (spacing < 18) spacing = 18;
+    int shown = (rows * spacing <= LEGEND_ROWS_HEIGHT) ? rows : LEGEND_ROWS_HEIGHT / spacing - 1;
+    int row = 0;
+    int selection = 0; // a selection is picked: k is shown with N
+    for (int id = 1; id <= algorithmCount(); id++) {
+        const AlgorithmInfo* info = algorithmInfo(id);
+        if (info->key == 0) continue;
+        if (selected[id] && (info->flags & ALGO_SELECTION)) selection = 1;
+        if (row == shown) continue;
+        char rowText[64];
+        snprintf(rowText, sizeof(rowText), "%c: %s", info->key, info->label);
+        int y = 20 + row * spacing;
+        int w = drawAtlasText(renderer, atlas, rowText, menuX, y, white);
+        if (selected[id]) {
+            SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+            SDL_Rect borderRect = { menuX - 2, y - 2, w + 4, atlas->lineHeight + 4 };
+            SDL_RenderDrawRect(renderer, &borderRect);
+        }
+        row++;
+    }
+    if (shown < rows) {
+        char moreText[64];
+        sprintf(moreText, "+%d more (--algo)", rows - shown);
+        drawAtlasText(renderer, atlas, moreText, menuX, 20 + shown * spacing, white);
+    }
+
+    char sizeText[64];
+    if (race != NULL) sprintf(sizeText, "N: %d  Race %d/%d", size, race->laneCount, RACE_MAX_LANES);
+    else if (selection) sprintf(sizeText, "N: %d  k: %d", size, k);
+    else sprintf(sizeText, "N: %d", size);
+    drawAtlasText(renderer, atlas, sizeText, menuX, 355, yellow);
+
+    drawText(renderer, atlas, "S: Start / Resume", menuX, 382, green, 0);
+    drawText(renderer, atlas, "E: Pause Sort", menuX, 409, red, 0);
+    drawText(renderer, atlas, "R: Reset Array", menuX, 436, yellow, 0);
+
+    char inputText[64];
+    sprintf(inputText, "D: %s", datasetName(distribution));
+    drawAtlasText(renderer, atlas, inputText, menuX, 463, yellow);
 
-    drawText(renderer, font, "S: Start Sort", menuX, 200, green, 0);
-    drawText(renderer, font, "E: Stop Sort", menuX, 230, red, 0);
-    drawText(renderer, font, "R: Reset Array", menuX, 260, yellow, 0);
+    drawText(renderer, atlas, "Left/Right: Step", menuX, 500, white, 0);
+    drawText(renderer, atlas, "Up/Down: Speed", menuX, 530, white, 0);
+    drawText(renderer, atlas, "Home/End: Jump", menuX, 560, white, 0);
 }
 
 // Draw the top left performance menu
-void drawStats(SDL_Renderer* renderer, TTF_Font* font, Stats_t* stats) {
+void drawStats(SDL_Renderer* renderer, GlyphAtlas* atlas, Stats_t* stats) {
     
     // Define stats box position
-    SDL_Rect statsBg = { 10, 10, 250, 85 };
+    SDL_Rect statsBg = { 10, 10, 250, 135 };
     
     // 2. Draw semi-transparent background
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND); // Enable transparency
@@ -175,6 +326,8 @@ void drawStats(SDL_Renderer* renderer, TTF_Font* font, Stats_t* stats) {
     char timeText[100];
     char compText[100];
     char accessText[100];
+    char auxText[100];
+    char runText[100];
     
     //start time accumulated
     double displayTime = stats->executionTime;
@@ -190,37 +343,488 @@ void drawStats(SDL_Renderer* renderer, TTF_Font* font, Stats_t* stats) {
     sprintf(timeText,   "Execution time : %.5f s", displayTime);
     sprintf(compText,   "Comparisons : %lld", stats->comparisons);
     sprintf(accessText, "Memory accesses : %lld", stats->memoryAccesses);
+    // scratch buffers of the run (arena.h): peak in use at once, number taken
+    if (stats->auxPeakBytes >= (1LL << 20)) {
+        sprintf(auxText, "Aux memory : %.1f MB, %lld allocs", stats->auxPeakBytes / 1048576.0, stats->auxAllocations);
+    } else {
+        sprintf(auxText, "Aux memory : %.1f KB, %lld allocs", stats->auxPeakBytes / 1024.0, stats->auxAllocations);
+    }
+
+    // order found in the input by the adaptive sorts (adaptive.h), or the
+    // characters the string sorts read (strsort.h)
+    if (stats->charComparisons > 0) sprintf(runText, "Char compares : %lld", stats->charComparisons);
+    else sprintf(runText, "Runs : %lld, gallops : %lld", stats->naturalRuns, stats->gallopHits);
+
+    // Draw the text (changes every frame: drawn from the glyph atlas)
+    drawAtlasText(renderer, atlas, timeText,   20, 20, white);
+    drawAtlasText(renderer, atlas, compText,   20, 45, white);
+    drawAtlasText(renderer, atlas, accessText, 20, 70, white);
+    drawAtlasText(renderer, atlas, auxText,    20, 95, white);
+    drawAtlasText(renderer, atlas, runText,    20, 120, white);
+
+    // Hardware counters, under the replay box (only those that were measured)
+    static const char* labels[HW_COUNTER_COUNT] = {
+        "Cycles", "Instructions", "Branch misses", "L1D misses", "LLC misses", "dTLB misses",
+    };
+    int lines = 0;
+    for (int c = 0; c < HW_COUNTER_COUNT; c++) lines += (stats->hardwareValid >> c) & 1;
+    if (lines == 0) return; // no counters on this machine (or no sort yet)
+
+    SDL_Rect hardwareBg = { 10, 205, 330, 10 + 25 * lines }; // wider: IPC after the instructions
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
+    SDL_RenderFillRect(renderer, &hardwareBg);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+    int y = 215;
+    for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+        if (!((stats->hardwareValid >> c) & 1)) continue;
+        char hardwareText[100];
+        if (c == HW_INSTRUCTIONS && (stats->hardwareValid & (1u << HW_CYCLES)) && stats->hardware[HW_CYCLES] > 0) {
+            sprintf(hardwareText, "%s : %lld (IPC %.2f)", labels[c], stats->hardware[c],
+                    (double)stats->hardware[c] / stats->hardware[HW_CYCLES]);
+        } else {
+            sprintf(hardwareText, "%s : %lld", labels[c], stats->hardware[c]);
+        }
+        drawAtlasText(renderer, atlas, hardwareText, 20, y, white);
+        y += 25;
+    }
+}
+
+// Draw the replay position under the stats box
+void drawTimeline(SDL_Renderer* renderer, GlyphAtlas* atlas, const Trace* trace, size_t cursor, int speed) {
+    SDL_Rect timelineBg = { 10, 150, 250, 50 };
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
+    SDL_RenderFillRect(renderer, &timelineBg);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+    SDL_Color white = {255, 255, 255, 255};
+    char stepText[100];
+    sprintf(stepText, "Step %zu / %zu  x%d", cursor, trace->count, speed);
+    drawAtlasText(renderer, atlas, stepText, 20, 155, white);
+
+    // Progress bar: full width = whole trace
+    SDL_Rect track = { 20, 185, 230, 8 };
+    SDL_SetRenderDrawColor(renderer, 90, 90, 90, 255);
+    SDL_RenderFillRect(renderer, &track);
+    if (trace->count > 0) {
+        SDL_Rect done = track;
+        done.w = (int)((double)cursor / trace->count * track.w);
+        SDL_SetRenderDrawColor(renderer, 0, 255, 127, 255);
+        SDL_RenderFillRect(renderer, &done);
+    }
+}
+
+// Width in pixels of 'text' drawn from the atlas
+static int atlasTextWidth(const GlyphAtlas* atlas, const char* text) {
+    int width = 0;
+    for (const char* p = text; *p != '\0'; p++) {
+        int c = (unsigned char)*p;
+        if (c < ATLAS_FIRST_CHAR || c > ATLAS_LAST_CHAR) c = '?';
+        width += atlas->glyphs[c - ATLAS_FIRST_CHAR].advance;
+    }
+    return width;
+}
+
+void drawStringKeys(SDL_Renderer* renderer, GlyphAtlas* atlas, const int* array, int size,
+                    int highlight1, int highlight2, int bottom) {
+    int highlights[2] = { highlight1, highlight2 };
+    char lines[2][STRING_KEY_MAX + 16];
+    int count = 0, width = 0;
+    for (int h = 0; h < 2; h++) {
+        int index = highlights[h];
+        if (index < 0 || index >= size || (h == 1 && index == highlight1)) continue;
+        char key[STRING_KEY_MAX];
+        formatStringKey(array[index], stringShape(), key);
+        snprintf(lines[count], sizeof(lines[count]), "[%d] %s", index, key);
+        int w = atlasTextWidth(atlas, lines[count]);
+        if (w > width) width = w;
+        count++;
+    }
+    if (count == 0) return;
+
+    SDL_Rect keysBg = { 10, bottom - 10 - 25 * count, width + 20, 25 * count };
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
+    SDL_RenderFillRect(renderer, &keysBg);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+    SDL_Color white = {255, 255, 255, 255};
+    for (int l = 0; l < count; l++) drawAtlasText(renderer, atlas, lines[l], 20, keysBg.y + 25 * l, white);
+}
+
+// Bar cache: scratch rects for the batched path, per-column min/max for the aggregated path
+BarCache* createBarCache() {
+    BarCache* bars = (BarCache*)malloc(sizeof(BarCache));
+    if (bars == NULL) return NULL;
+    memset(bars, 0, sizeof(BarCache));
+    bars->allDirty = 1;
+    return bars;
+}
+
+void freeBarCache(BarCache* bars) {
+    if (bars == NULL) return;
+    if (bars->texture) SDL_DestroyTexture(bars->texture);
+    free(bars->rects);
+    free(bars->sortedRects);
+    free(bars->colMin);
+    free(bars->colMax);
+    free(bars->dirty);
+    free(bars);
+}
+
+void markAllBarsDirty(BarCache* bars) {
+    bars->allDirty = 1;
+}
 
-    // Draw the text
-    drawText(renderer, font, timeText,   20, 20, white, 0);
-    drawText(renderer, font, compText,   20, 45, white, 0);
-    drawText(renderer, font, accessText, 20, 70, white, 0);
+void markBarsDirty(BarCache* bars, int index, int size) {
+    if (bars->columns == 0 || index < 0 || index >= size) return;
+    int column = (int)((long long)index * bars->columns / size);
+    bars->dirty[column] = 1;
+    bars->anyDirty = 1;
 }
 
-// Draw the sorting bars
-void drawArray(SDL_Renderer* renderer, int* array, int size, int highlight1, int highlight2) {
-    int sortZoneWidth = 600; 
-    int windowHeight = WINDOW_HEIGHT; 
-    float barWidth = (float)sortZoneWidth / size;
+void markTraceDirty(BarCache* bars, const Trace* trace, size_t from, size_t to, int size) {
+    if (to > trace->count) to = trace->count;
+    if (bars->columns == 0) return; // the column buffers start all dirty
+    // one flag per op, whatever the speed: replaying already costs O(ops), and
+    // the rescan then only reads the columns these ops touched (a full rescan
+    // is O(N) per frame, too much at 10^7 elements)
+    for (size_t k = from; k < to; k++) {
+        TraceOp op = trace->ops[k];
+        unsigned type = op.head >> TRACE_TYPE_SHIFT;
+        if (type == TRACE_COMPARE || type == TRACE_READ) continue; // nothing moved
+        markBarsDirty(bars, (int)(op.head & TRACE_INDEX_MASK), size);
+        if (type == TRACE_SWAP) markBarsDirty(bars, (int)op.arg, size);
+    }
+}
+
+// Colors of the parallel workers (owner id - 1), white when no owner.
+// Id 12 (SELECT_DISCARD_COLOR) is dim: ranges a selection dropped.
+static const SDL_Color ownerColors[TRACE_OWNER_COLORS] = {
+    {  80, 160, 255, 255 }, { 255, 170,  60, 255 }, { 190, 100, 255, 255 }, {  60, 220, 220, 255 },
+    { 255, 110, 180, 255 }, { 170, 220,  60, 255 }, { 255, 220, 100, 255 }, { 120, 120, 255, 255 },
+    { 100, 200, 140, 255 }, { 220, 140, 100, 255 }, { 150, 180, 220, 255 }, { 230, 120, 230, 255 },
+    {  70,  70,  70, 255 }, {  90, 160, 160, 255 }, { 200, 200, 200, 255 }, { 160, 100, 120, 255 },
+};
+
+// Height in pixels of a bar of 'value' (1 .. maxValue fills 0 .. zoneHeight)
+static inline int barHeight(int value, int maxValue, int zoneHeight) {
+    if (value <= 0) return 0;
+    if (value >= maxValue) return zoneHeight;
+    return (int)((long long)value * zoneHeight / maxValue);
+}
 
+// size <= pixel width: every bar is a float rect, submitted in one batched call
+// per color (one for white, plus one per worker color for the parallel sorts).
+static void drawBarsBatched(SDL_Renderer* renderer, BarCache* bars, int* array, const unsigned char* owners,
+                            int size, int maxValue, int zoneWidth, int zoneHeight, int highlight1, int highlight2) {
+    if (size > bars->rectCapacity) {
+        SDL_FRect* grown = (SDL_FRect*)realloc(bars->rects, size * sizeof(SDL_FRect));
+        if (grown == NULL) return;
+        bars->rects = grown;
+        grown = (SDL_FRect*)realloc(bars->sortedRects, size * sizeof(SDL_FRect));
+        if (grown == NULL) return;
+        bars->sortedRects = grown;
+        bars->rectCapacity = size;
+    }
+
+    // bars per color, then where each color starts in sortedRects
+    int count[TRACE_OWNER_COLORS + 1] = {0};
+    int start[TRACE_OWNER_COLORS + 1];
+    float barWidth = (float)zoneWidth / size; // kept as float: no zero-width bars
     for (int i = 0; i < size; i++) {
-        int barHeight = array[i];
-        SDL_Rect bar;
-        bar.x = (int)(i * barWidth);
-        bar.w = (int)barWidth;
-        bar.y = windowHeight - barHeight; 
-        bar.h = barHeight;
-
-        if (i == highlight1) {
-            SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); // Red
-        } else if (i == highlight2) {
-            SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255); // Green
+        SDL_FRect* bar = &bars->rects[i];
+        bar->x = i * barWidth;
+        bar->w = barWidth;
+        int height = barHeight(array[i], maxValue, zoneHeight);
+        bar->y = (float)(zoneHeight - height);
+        bar->h = (float)height;
+        count[owners ? owners[i] : 0]++;
+    }
+
+    if (count[0] == size) {
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White
+        SDL_RenderFillRectsF(renderer, bars->rects, size);
+    } else {
+        start[0] = 0;
+        for (int c = 1; c <= TRACE_OWNER_COLORS; c++) start[c] = start[c - 1] + count[c - 1];
+        int fill[TRACE_OWNER_COLORS + 1];
+        memcpy(fill, start, sizeof(fill));
+        for (int i = 0; i < size; i++) {
+            bars->sortedRects[fill[owners[i]]++] = bars->rects[i];
+        }
+
+        for (int c = 0; c <= TRACE_OWNER_COLORS; c++) {
+            if (count[c] == 0) continue;
+            if (c == 0) SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+            else SDL_SetRenderDrawColor(renderer, ownerColors[c - 1].r, ownerColors[c - 1].g, ownerColors[c - 1].b, 255);
+            SDL_RenderFillRectsF(renderer, bars->sortedRects + start[c], count[c]);
+        }
+    }
+
+    // highlights drawn on top
+    if (highlight1 >= 0 && highlight1 < size) {
+        SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); // Red
+        SDL_RenderFillRectF(renderer, &bars->rects[highlight1]);
+    }
+    if (highlight2 >= 0 && highlight2 < size) {
+        SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255); // Green
+        SDL_RenderFillRectF(renderer, &bars->rects[highlight2]);
+    }
+}
+
+// size > pixel width: one column per pixel showing the min and max of its elements,
+// written into a streaming texture. Only columns touched since the last frame
+// are rescanned, so the cost follows the pixel width and the replay speed.
+static void drawBarsAggregated(SDL_Renderer* renderer, BarCache* bars, int* array, int size, int maxValue,
+                               int zoneWidth, int zoneHeight, int highlight1, int highlight2) {
+    // (re)allocate the column buffers and texture when the zone changes
+    if (bars->columns != zoneWidth || bars->textureHeight != zoneHeight || bars->texture == NULL) {
+        if (bars->texture) SDL_DestroyTexture(bars->texture);
+        free(bars->colMin);
+        free(bars->colMax);
+        free(bars->dirty);
+        bars->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                          zoneWidth, zoneHeight);
+        bars->colMin = (int*)malloc(zoneWidth * sizeof(int));
+        bars->colMax = (int*)malloc(zoneWidth * sizeof(int));
+        bars->dirty = (unsigned char*)calloc(zoneWidth, 1);
+        if (!bars->texture || !bars->colMin || !bars->colMax || !bars->dirty) {
+            bars->columns = 0; // retried next frame
+            return;
+        }
+        bars->columns = zoneWidth;
+        bars->textureHeight = zoneHeight;
+        bars->allDirty = 1;
+    }
+
+    int highlightColumn1 = (highlight1 >= 0 && highlight1 < size) ? (int)((long long)highlight1 * zoneWidth / size) : -1;
+    int highlightColumn2 = (highlight2 >= 0 && highlight2 < size) ? (int)((long long)highlight2 * zoneWidth / size) : -1;
+
+    // rescan dirty columns
+    if (bars->allDirty || bars->anyDirty) {
+        for (int c = 0; c < zoneWidth; c++) {
+            if (!bars->allDirty && !bars->dirty[c]) continue;
+            bars->dirty[c] = 0;
+
+            long long lo = (long long)c * size / zoneWidth;
+            long long hi = (long long)(c + 1) * size / zoneWidth;
+            int lowest = array[lo], highest = array[lo];
+            for (long long i = lo + 1; i < hi; i++) {
+                if (array[i] < lowest) lowest = array[i];
+                if (array[i] > highest) highest = array[i];
+            }
+            bars->colMin[c] = barHeight(lowest, maxValue, zoneHeight);
+            bars->colMax[c] = barHeight(highest, maxValue, zoneHeight);
+        }
+        bars->allDirty = 0;
+        bars->anyDirty = 0;
+    }
+
+    // write the columns: white up to the min, grey between min and max
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(bars->texture, NULL, &pixels, &pitch) != 0) return;
+    for (int y = 0; y < zoneHeight; y++) {
+        Uint32* row = (Uint32*)((Uint8*)pixels + y * pitch);
+        int height = zoneHeight - y; // height of this row above the bottom
+        for (int c = 0; c < zoneWidth; c++) {
+            Uint32 color = 0xFF000000; // black
+            if (height <= bars->colMax[c]) {
+                if (c == highlightColumn1) color = 0xFFFF0000;      // Red
+                else if (c == highlightColumn2) color = 0xFF00FF00; // Green
+                else if (height <= bars->colMin[c]) color = 0xFFFFFFFF; // White
+                else color = 0xFF808080; // Grey: spread inside the column
+            }
+            row[c] = color;
+        }
+    }
+    SDL_UnlockTexture(bars->texture);
+
+    SDL_Rect dest = { 0, 0, zoneWidth, zoneHeight };
+    SDL_RenderCopy(renderer, bars->texture, NULL, &dest);
+}
+
+// Draw the sorting bars (owners: worker colors, may be NULL; only used while the array fits the zone)
+void drawArray(SDL_Renderer* renderer, BarCache* bars, int* array, const unsigned char* owners, int size,
+               int maxValue, int zoneWidth, int zoneHeight, int highlight1, int highlight2) {
+    if (zoneWidth < 1 || zoneHeight < 1) return;
+
+    if (size <= zoneWidth) {
+        drawBarsBatched(renderer, bars, array, owners, size, maxValue, zoneWidth, zoneHeight, highlight1, highlight2);
+    } else {
+        drawBarsAggregated(renderer, bars, array, size, maxValue, zoneWidth, zoneHeight, highlight1, highlight2);
+    }
+}
+
+// Draw one race lane per cell: 1 row up to 3 lanes, 2 rows above
+void drawRace(SDL_Renderer* renderer, GlyphAtlas* atlas, const Race* race, int* input, int inputSize,
+              int maxValue, int zoneWidth, int zoneHeight) {
+    if (race->laneCount == 0) return;
+    int rows = race->laneCount <= 3 ? 1 : 2;
+    int columns = (race->laneCount + rows - 1) / rows;
+    int cellWidth = zoneWidth / columns;
+    int cellHeight = zoneHeight / rows;
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Color green = {0, 255, 127, 255};
+
+    for (int l = 0; l < race->laneCount; l++) {
+        const RaceLane* lane = &race->lanes[l];
+        SDL_Rect cell = { (l % columns) * cellWidth, (l / columns) * cellHeight, cellWidth, cellHeight };
+        SDL_RenderSetViewport(renderer, &cell); // drawing below is relative to the cell
+
+        // a lane shows the shared input until the race starts
+        int started = lane->trace->keyframeCount > 0;
+        if (started) {
+            drawArray(renderer, lane->bars, lane->array, lane->owners, lane->size, maxValue,
+                      cellWidth, cellHeight, lane->highlight1, lane->highlight2);
+        } else {
+            markAllBarsDirty(lane->bars); // the input may have been regenerated
+            drawArray(renderer, lane->bars, input, NULL, inputSize, maxValue, cellWidth, cellHeight, -1, -1);
+        }
+
+        // label: name and finish place, then time and throughput of the sort thread
+        int rank = raceLaneRank(race, l);
+        char nameText[64];
+        char rateText[100];
+        if (rank > 0) sprintf(nameText, "#%d %s", rank, algorithmInfo(lane->algorithm)->label);
+        else sprintf(nameText, "%s", algorithmInfo(lane->algorithm)->label);
+        double seconds = lane->stats->executionTime;
+        if (!started) {
+            sprintf(rateText, "Ready");
+        } else if (rank > 0) {
+            // elements per second: comparable between algorithms
+            sprintf(rateText, "%.2f ms  %.1f M elem/s", seconds * 1000.0,
+                    seconds > 0 ? lane->size / seconds / 1e6 : 0.0);
         } else {
-            SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White
+            // counted operations per second while it runs
+            sprintf(rateText, "%.2f ms  %.1f M ops/s", seconds * 1000.0,
+                    seconds > 0 ? (lane->stats->comparisons + lane->stats->memoryAccesses) / seconds / 1e6 : 0.0);
         }
-        
-        SDL_RenderFillRect(renderer, &bar);
+
+        SDL_Rect labelBg = { 6, 6, 250, 56 };
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
+        SDL_RenderFillRect(renderer, &labelBg);
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+        drawAtlasText(renderer, atlas, nameText, 12, 10, rank > 0 ? green : white);
+        drawAtlasText(renderer, atlas, rateText, 12, 35, white);
+
+        SDL_Rect border = { 0, 0, cellWidth, cellHeight };
+        SDL_SetRenderDrawColor(renderer, 90, 90, 90, 255);
+        SDL_RenderDrawRect(renderer, &border);
     }
+    SDL_RenderSetViewport(renderer, NULL);
+}
+
+/*
+----------------------------------------------------
+ ACCESS PATTERN PANEL
+----------------------------------------------------
+ Heatmap (time left to right, index top to bottom, reads in cyan and
+ writes in red, log scale) with the replay position, and the stride and
+ reuse histograms on its right.
+----------------------------------------------------
+*/
+// Brightness of a count, log scale against the largest one
+static inline int heatLevel(uint64_t count, double logMax) {
+    if (count == 0 || logMax <= 0.0) return 0;
+    int level = (int)(64 + 191 * log((double)count) / logMax);
+    return level > 255 ? 255 : level;
+}
+
+// log2 histogram as bars in 'area', tallest bin at full height
+static void drawHistogram(SDL_Renderer* renderer, GlyphAtlas* atlas, const long long* bins, long long extra,
+                          const char* title, SDL_Rect area, SDL_Color color) {
+    SDL_SetRenderDrawColor(renderer, 25, 25, 25, 255);
+    SDL_RenderFillRect(renderer, &area);
+    SDL_Color white = {255, 255, 255, 255};
+    drawAtlasText(renderer, atlas, title, area.x + 4, area.y + 2, white);
+
+    int count = ACCESS_HISTOGRAM_BINS + (extra >= 0 ? 1 : 0); // extra: one more bar at the end
+    long long largest = extra > 0 ? extra : 1;
+    for (int b = 0; b < ACCESS_HISTOGRAM_BINS; b++) {
+        if (bins[b] > largest) largest = bins[b];
+    }
+    int top = area.y + 28;
+    int height = area.h - 32;
+    if (height <= 0) return;
+    float width = (float)(area.w - 8) / count;
+    for (int b = 0; b < count; b++) {
+        long long value = (b < ACCESS_HISTOGRAM_BINS) ? bins[b] : extra;
+        int h = (int)((double)value / largest * height);
+        SDL_FRect bar = { area.x + 4 + b * width, (float)(top + height - h), width > 2 ? width - 1 : width, (float)h };
+        if (b == ACCESS_HISTOGRAM_BINS) SDL_SetRenderDrawColor(renderer, 150, 150, 150, 255); // first touches
+        else SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 255);
+        SDL_RenderFillRectF(renderer, &bar);
+    }
+}
+
+void drawAccessMap(SDL_Renderer* renderer, GlyphAtlas* atlas, const AccessMap* map, SDL_Texture** texture,
+                   size_t cursor, SDL_Rect area) {
+    SDL_SetRenderDrawColor(renderer, 15, 15, 15, 255);
+    SDL_RenderFillRect(renderer, &area);
+    SDL_Color white = {255, 255, 255, 255};
+
+    int histogramWidth = area.w / 3;
+    SDL_Rect heat = { area.x + 4, area.y + 28, area.w - histogramWidth - 12, area.h - 32 };
+    char title[128];
+    sprintf(title, "Reads %llu  Writes %llu", (unsigned long long)map->readCount,
+            (unsigned long long)map->writeCount);
+    drawAtlasText(renderer, atlas, title, area.x + 4, area.y + 2, white);
+
+    if (*texture == NULL) {
+        *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                     ACCESS_TIME_BUCKETS, ACCESS_INDEX_BUCKETS);
+    }
+    if (*texture != NULL && map->rows > 0 && heat.w > 0 && heat.h > 0) {
+        uint64_t largest = 1;
+        for (int i = 0; i < ACCESS_TIME_BUCKETS * map->rows; i++) {
+            if (map->reads[i] > largest) largest = map->reads[i];
+            if (map->writes[i] > largest) largest = map->writes[i];
+        }
+        double logMax = log((double)largest);
+        if (logMax <= 0.0) logMax = 1.0; // every count is 1
+
+        void* pixels;
+        int pitch;
+        if (SDL_LockTexture(*texture, NULL, &pixels, &pitch) == 0) {
+            for (int r = 0; r < ACCESS_INDEX_BUCKETS; r++) {
+                Uint32* row = (Uint32*)((Uint8*)pixels + r * pitch);
+                for (int c = 0; c < ACCESS_TIME_BUCKETS; c++) {
+                    Uint32 red = 0, cyan = 0;
+                    if (r < map->rows) {
+                        red = (Uint32)heatLevel(map->writes[c * map->rows + r], logMax);
+                        cyan = (Uint32)heatLevel(map->reads[c * map->rows + r], logMax);
+                    }
+                    row[c] = 0xFF000000u | (red > cyan ? red : cyan) << 16 | cyan << 8 | cyan;
+                }
+            }
+            SDL_UnlockTexture(*texture);
+        }
+        // only the rows in use, the time axis as far as the sort went
+        SDL_Rect source = { 0, 0, map->columns > 0 ? map->columns : 1, map->rows };
+        SDL_RenderCopy(renderer, *texture, &source, &heat);
+
+        // replay position
+        uint64_t spanOps = (uint64_t)source.w * map->opsPerColumn;
+        if (spanOps > 0 && cursor > 0) {
+            int x = heat.x + (int)((double)cursor / spanOps * heat.w);
+            if (x > heat.x + heat.w - 1) x = heat.x + heat.w - 1;
+            SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255);
+            SDL_RenderDrawLine(renderer, x, heat.y, x, heat.y + heat.h - 1);
+        }
+    }
+
+    SDL_Rect strideArea = { area.x + area.w - histogramWidth - 4, area.y, histogramWidth, area.h / 2 - 2 };
+    SDL_Rect reuseArea = { strideArea.x, area.y + area.h / 2 + 2, histogramWidth, area.h - area.h / 2 - 2 };
+    SDL_Color cyan = {0, 200, 255, 255};
+    SDL_Color orange = {255, 150, 0, 255};
+    drawHistogram(renderer, atlas, map->strides, -1, "Stride (log2)", strideArea, cyan);
+    drawHistogram(renderer, atlas, map->reuses, map->coldLines, "Reuse (log2 ops)", reuseArea, orange);
 }
 
 // Render everything
@@ -228,8 +832,32 @@ void renderApp(App_Window* app, int highlight1, int highlight2)
 {    
     SDL_SetRenderDrawColor(app->renderer, 0, 0, 0, 255);
     SDL_RenderClear(app->renderer);
-    drawArray(app->renderer, app->array, N, highlight1, highlight2);
-    drawLegend(app->renderer, app->font, app->selectedAlgorithm);
-    drawStats(app->renderer, app->font, app->stats);
+    if (app->raceMode) {
+        // one cell per lane instead of the array, stats and timeline
+        drawRace(app->renderer, app->atlas, app->race, app->array, app->size, arrayMaxValue(app),
+                 app->windowWidth - MENU_WIDTH, app->windowHeight);
+        drawLegend(app->renderer, app->atlas, app->selectedAlgorithm, app->race, app->distribution, app->size,
+                   selectRank(app->selectK, app->size), app->windowWidth, app->windowHeight);
+        SDL_RenderPresent(app->renderer);
+        return;
+    }
+    // the bars take the window minus the menu, values scaled to its height
+    // (its upper 3/5 when the access panel is shown below them)
+    int zoneWidth = app->windowWidth - MENU_WIDTH;
+    int zoneHeight = app->showAccess ? app->windowHeight * 3 / 5 : app->windowHeight;
+    drawArray(app->renderer, app->bars, app->array, app->owners, app->size, arrayMaxValue(app),
+              zoneWidth, zoneHeight, highlight1, highlight2);
+    if (app->showAccess) {
+        SDL_Rect panel = { 0, zoneHeight, zoneWidth, app->windowHeight - zoneHeight };
+        drawAccessMap(app->renderer, app->atlas, app->access, &app->accessTexture, app->replayCursor, panel);
+    }
+    const AlgorithmInfo* info = algorithmInfo(app->selectedAlgorithm);
+    if (info != NULL && (info->keyTypes & KEY_STRING)) {
+        drawStringKeys(app->renderer, app->atlas, app->array, app->size, highlight1, highlight2, zoneHeight);
+    }
+    drawLegend(app->renderer, app->atlas, app->selectedAlgorithm, NULL, app->distribution, app->size,
+               selectRank(app->selectK, app->size), app->windowWidth, app->windowHeight);
+    drawStats(app->renderer, app->atlas, app->stats);
+    drawTimeline(app->renderer, app->atlas, app->trace, app->replayCursor, app->replaySpeed);
     SDL_RenderPresent(app->renderer);
-}
\ No newline at end of file
+}
@@ -0,0 +1,321 @@
+#include "worker.h"
+#include "registry.h"
+#include <stdio.h>  // For error messages
+#include <stdlib.h> // For malloc/free
+#include <string.h> // For memset and memcpy
+
+#define WORKER_BATCH 1024 // ops per stepSort() call between flag checks
+
+// Live counters of a direct sort, published at every flush (under sinkLock).
+// The sort thread (pool worker 0) knows its own counters as they grow; a
+// parallel sort only sums its workers' counters at the end, so until then
+// the flushed ops stand in for them (a compare is 1 comparison + 2 accesses,
+// a swap 4 accesses, a write or a read 1). Both only grow; the exact counts replace
+// them when the sort returns.
+static void publishDirectStats(SortWorker* worker, const DirectOpBuffer* buffer) {
+    for (int o = 0; o < buffer->count; o++) {
+        unsigned type = buffer->ops[o].head >> TRACE_TYPE_SHIFT;
+        if (type == TRACE_COMPARE) {
+            worker->tracedComparisons++;
+            worker->tracedAccesses += 2;
+        } else if (type == TRACE_SWAP) {
+            worker->tracedAccesses += 4;
+        } else if (type == TRACE_WRITE || type == TRACE_READ) {
+            worker->tracedAccesses++;
+        }
+    }
+    long long comparisons = worker->tracedComparisons;
+    long long accesses = worker->tracedAccesses;
+    if (poolWorkerId() == 0) {
+        if (worker->local.comparisons > comparisons) comparisons = worker->local.comparisons;
+        if (worker->local.memoryAccesses > accesses) accesses = worker->local.memoryAccesses;
+    }
+    if (comparisons > atomic_load_explicit(&worker->comparisons, memory_order_relaxed)) {
+        atomic_store_explicit(&worker->comparisons, comparisons, memory_order_relaxed);
+    }
+    if (accesses > atomic_load_explicit(&worker->memoryAccesses, memory_order_relaxed)) {
+        atomic_store_explicit(&worker->memoryAccesses, accesses, memory_order_relaxed);
+    }
+    long long elapsedNs = (long long)((SDL_GetPerformanceCounter() - worker->directStart) * 1000000000.0
+                                      / SDL_GetPerformanceFrequency());
+    atomic_store_explicit(&worker->elapsedNs, elapsedNs - worker->blockedNs, memory_order_relaxed);
+}
+
+// Moves a pool worker's buffered ops into the ring. The lock is released
+// while the ring is full or paused, so the other workers keep sorting until
+// their own buffer fills. Once stopped, ops are dropped.
+static void flushDirectOps(SortWorker* worker, DirectOpBuffer* buffer) {
+    size_t pushed = 0;
+    int waiting = 0;
+    SDL_LockMutex(worker->sinkLock);
+    publishDirectStats(worker, buffer);
+    while (!atomic_load_explicit(&worker->stop, memory_order_relaxed)) {
+        if (!atomic_load_explicit(&worker->paused, memory_order_relaxed)) {
+            pushed += ringPush(worker->ring, buffer->ops + pushed, buffer->count - pushed);
+        }
+        if (pushed == (size_t)buffer->count) break;
+        if (!waiting) {
+            waiting = 1;
+            if (worker->waiters++ == 0) worker->waitStart = SDL_GetPerformanceCounter();
+        }
+        SDL_UnlockMutex(worker->sinkLock);
+        SDL_Delay(1);
+        SDL_LockMutex(worker->sinkLock);
+    }
+    if (waiting && --worker->waiters == 0) {
+        worker->blockedNs += (long long)((SDL_GetPerformanceCounter() - worker->waitStart) * 1000000000.0
+                                         / SDL_GetPerformanceFrequency());
+    }
+    SDL_UnlockMutex(worker->sinkLock);
+    buffer->count = 0;
+}
+
+// Pool sync hook: the calling worker's ops reach the ring before a task it
+// spawned can be stolen and before a task it ran is seen as done.
+static void syncDirectOps(void* context) {
+    SortWorker* worker = (SortWorker*)context;
+    DirectOpBuffer* buffer = &worker->directOps[poolWorkerId()];
+    if (buffer->count > 0) flushDirectOps(worker, buffer);
+}
+
+// OpSink of the direct sorts: the calling pool worker's buffer.
+static void pushDirectOp(void* context, TraceOp op) {
+    SortWorker* worker = (SortWorker*)context;
+    if (atomic_load_explicit(&worker->stop, memory_order_relaxed)) return;
+
+    DirectOpBuffer* buffer = &worker->directOps[poolWorkerId()];
+    buffer->ops[buffer->count++] = op;
+    if (buffer->count == DIRECT_OP_BATCH) flushDirectOps(worker, buffer);
+}
+
+// Hardware counts of the run so far -> window thread
+static void publishHardware(SortWorker* worker) {
+    if (worker->perf.opened == 0) return;
+    Stats_t counts;
+    resetStats(&counts);
+    perfRead(&worker->perf, &counts);
+    for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+        atomic_store_explicit(&worker->hardware[c], counts.hardware[c], memory_order_relaxed);
+    }
+    atomic_store_explicit(&worker->hardwareValid, counts.hardwareValid, memory_order_relaxed);
+}
+
+// Thread body of the direct sorts: one call, live counters published at every
+// flush (publishDirectStats), the exact ones at the end.
+static void runDirectSort(SortWorker* worker) {
+    OpSink sink = { pushDirectOp, worker };
+    int size = worker->directSize;
+    // small tasks so that every worker gets a range even with a few hundred bars
+    int cutoff = size / (4 * worker->pool->threadCount);
+    if (cutoff < 8) cutoff = 8;
+
+    // every pool worker is counted (the ops pushed into the ring are counted too)
+    perfOpen(&worker->perf, worker->pool);
+    Uint64 start = SDL_GetPerformanceCounter();
+    worker->directStart = start;
+    worker->tracedComparisons = 0;
+    worker->tracedAccesses = 0;
+    worker->blockedNs = 0;
+    worker->waiters = 0;
+    for (int w = 0; w < worker->pool->threadCount; w++) worker->directOps[w].count = 0;
+    perfEnable(&worker->perf);
+    const AlgorithmInfo* info = algorithmInfo(worker->algorithm);
+    SortContext context = { worker->pool, worker->arena, worker->selectK, cutoff };
+    if (info->run(worker->directTab, size, &context, &worker->local, &sink) != 0) {
+        fprintf(stderr, "%s: %s.\n", info->label, info->failure ? info->failure : "failed");
+    }
+    // every task is done: only the ops after the last join are left buffered
+    for (int w = 0; w < worker->pool->threadCount; w++) {
+        if (worker->directOps[w].count > 0) flushDirectOps(worker, &worker->directOps[w]);
+    }
+    perfDisable(&worker->perf);
+    long long elapsedNs = (long long)((SDL_GetPerformanceCounter() - start) * 1000000000.0
+                                      / SDL_GetPerformanceFrequency());
+
+    atomic_store_explicit(&worker->comparisons, worker->local.comparisons, memory_order_relaxed);
+    atomic_store_explicit(&worker->memoryAccesses, worker->local.memoryAccesses, memory_order_relaxed);
+    atomic_store_explicit(&worker->elapsedNs, elapsedNs - worker->blockedNs, memory_order_relaxed);
+    atomic_store_explicit(&worker->auxPeakBytes, worker->local.auxPeakBytes, memory_order_relaxed);
+    atomic_store_explicit(&worker->auxAllocations, worker->local.auxAllocations, memory_order_relaxed);
+    atomic_store_explicit(&worker->naturalRuns, worker->local.naturalRuns, memory_order_relaxed);
+    atomic_store_explicit(&worker->gallopHits, worker->local.gallopHits, memory_order_relaxed);
+    atomic_store_explicit(&worker->charComparisons, worker->local.charComparisons, memory_order_relaxed);
+    publishHardware(worker);
+    perfClose(&worker->perf);
+}
+
+// Thread body: step, publish, push, until done or stopped.
+static int sortWorkerMain(void* data) {
+    SortWorker* worker = (SortWorker*)data;
+    SortMachine* machine = worker->machine;
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    long long elapsedNs = 0;
+
+    if (worker->directTab != NULL) {
+        runDirectSort(worker);
+        atomic_store_explicit(&worker->finished, 1, memory_order_release);
+        return 0;
+    }
+
+    perfOpen(&worker->perf, NULL);
+    while (!atomic_load_explicit(&worker->stop, memory_order_relaxed)) {
+        if (atomic_load_explicit(&worker->paused, memory_order_relaxed)) {
+            SDL_Delay(1);
+            continue;
+        }
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        perfEnable(&worker->perf);
+        int done = stepSort(machine, WORKER_BATCH);
+        perfDisable(&worker->perf);
+        elapsedNs += (long long)((SDL_GetPerformanceCounter() - start) * 1000000000.0 / frequency);
+        publishHardware(worker);
+
+        atomic_store_explicit(&worker->comparisons, worker->local.comparisons, memory_order_relaxed);
+        atomic_store_explicit(&worker->memoryAccesses, worker->local.memoryAccesses, memory_order_relaxed);
+        atomic_store_explicit(&worker->elapsedNs, elapsedNs, memory_order_relaxed);
+
+        // hand the batch to the window thread, waiting only while the ring is full
+        size_t pushed = 0;
+        while (pushed < machine->outCount && !atomic_load_explicit(&worker->stop, memory_order_relaxed)) {
+            pushed += ringPush(worker->ring, machine->out + pushed, machine->outCount - pushed);
+            if (pushed < machine->outCount) SDL_Delay(1);
+        }
+
+        if (done) break;
+    }
+    perfClose(&worker->perf);
+
+    atomic_store_explicit(&worker->finished, 1, memory_order_release);
+    return 0;
+}
+
+SortWorker* createSortWorker(size_t ringCapacity) {
+    SortWorker* worker = (SortWorker*)malloc(sizeof(SortWorker));
+    if (worker == NULL) return NULL;
+    memset(worker, 0, sizeof(SortWorker));
+
+    worker->machine = createSortMachine(WORKER_BATCH);
+    worker->ring = createOpRing(ringCapacity);
+    worker->poolThreads = poolCoreCount();
+    worker->pool = createThreadPool(worker->poolThreads); // one worker per core
+    worker->sinkLock = SDL_CreateMutex();
+    if (worker->pool != NULL) worker->directOps = (DirectOpBuffer*)calloc(worker->pool->threadCount, sizeof(DirectOpBuffer));
+    if (worker->machine == NULL || worker->ring == NULL || worker->pool == NULL || worker->sinkLock == NULL
+        || worker->directOps == NULL) {
+        freeSortWorker(worker);
+        return NULL;
+    }
+    poolSetSyncHook(worker->pool, syncDirectOps, worker);
+    atomic_init(&worker->finished, 1);
+    return worker;
+}
+
+int setSortWorkerThreads(SortWorker* worker, int threads) {
+    stopSortWorker(worker);
+    if (threads <= 0) threads = poolCoreCount();
+    if (threads > POOL_MAX_THREADS) threads = POOL_MAX_THREADS;
+    if (threads == worker->poolThreads) return 0;
+
+    ThreadPool* pool = createThreadPool(threads);
+    DirectOpBuffer* directOps = pool ? (DirectOpBuffer*)calloc(pool->threadCount, sizeof(DirectOpBuffer)) : NULL;
+    if (directOps == NULL) {
+        freeThreadPool(pool);
+        return -1; // the current pool stays
+    }
+    freeThreadPool(worker->pool);
+    free(worker->directOps);
+    worker->pool = pool;
+    worker->directOps = directOps;
+    worker->poolThreads = threads;
+    poolSetSyncHook(worker->pool, syncDirectOps, worker);
+    return 0;
+}
+
+int startSortWorker(SortWorker* worker, int algorithm, const int* array, int size, int k, const Stats_t* stats,
+                    Arena* arena) {
+    stopSortWorker(worker);
+    arenaReset(arena); // the previous run is over: its buffers are free again
+    worker->arena = arena;
+
+    resetStats(&worker->local);
+    worker->base = *stats;
+    worker->algorithm = algorithm;
+    worker->selectK = k;
+
+    if (algorithmInfo(algorithm)->machine == 0) {
+        // direct sorts (every one but the step machines, plugins too): one plain call
+        worker->directTab = (int*)arenaAlloc(arena, size * sizeof(int), NULL); // the input, not scratch
+        if (worker->directTab == NULL) return -1;
+        memcpy(worker->directTab, array, size * sizeof(int));
+        worker->directSize = size;
+    } else if (startSort(worker->machine, algorithmInfo(algorithm)->machine, array, size, &worker->local) != 0) {
+        return -1;
+    }
+
+    atomic_store(&worker->comparisons, 0);
+    atomic_store(&worker->memoryAccesses, 0);
+    atomic_store(&worker->elapsedNs, 0);
+    for (int c = 0; c < HW_COUNTER_COUNT; c++) atomic_store(&worker->hardware[c], 0);
+    atomic_store(&worker->hardwareValid, 0);
+    atomic_store(&worker->auxPeakBytes, 0);
+    atomic_store(&worker->auxAllocations, 0);
+    atomic_store(&worker->naturalRuns, 0);
+    atomic_store(&worker->gallopHits, 0);
+    atomic_store(&worker->charComparisons, 0);
+    atomic_store(&worker->paused, 0);
+    atomic_store(&worker->stop, 0);
+    atomic_store(&worker->finished, 0);
+
+    worker->thread = SDL_CreateThread(sortWorkerMain, "sort-worker", worker);
+    if (worker->thread == NULL) {
+        fprintf(stderr, "Failed to create the sort thread: %s\n", SDL_GetError());
+        atomic_store(&worker->finished, 1);
+        return -1;
+    }
+    return 0;
+}
+
+void pauseSortWorker(SortWorker* worker, int paused) {
+    atomic_store_explicit(&worker->paused, paused, memory_order_relaxed);
+}
+
+void stopSortWorker(SortWorker* worker) {
+    if (worker->thread != NULL) {
+        atomic_store(&worker->stop, 1);
+        SDL_WaitThread(worker->thread, NULL);
+        worker->thread = NULL;
+    }
+    ringClear(worker->ring);
+    stopSort(worker->machine);
+    arenaFree(worker->arena, worker->directTab, worker->directSize * sizeof(int), NULL);
+    worker->directTab = NULL;
+}
+
+void readSortWorkerStats(SortWorker* worker, Stats_t* stats) {
+    stats->comparisons = worker->base.comparisons + atomic_load_explicit(&worker->comparisons, memory_order_relaxed);
+    stats->memoryAccesses = worker->base.memoryAccesses + atomic_load_explicit(&worker->memoryAccesses, memory_order_relaxed);
+    stats->executionTime = worker->base.executionTime + atomic_load_explicit(&worker->elapsedNs, memory_order_relaxed) / 1e9;
+    for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+        stats->hardware[c] = worker->base.hardware[c] + atomic_load_explicit(&worker->hardware[c], memory_order_relaxed);
+    }
+    stats->hardwareValid = worker->base.hardwareValid | atomic_load_explicit(&worker->hardwareValid, memory_order_relaxed);
+    long long auxPeak = atomic_load_explicit(&worker->auxPeakBytes, memory_order_relaxed);
+    stats->auxPeakBytes = auxPeak > worker->base.auxPeakBytes ? auxPeak : worker->base.auxPeakBytes;
+    stats->auxAllocations = worker->base.auxAllocations + atomic_load_explicit(&worker->auxAllocations, memory_order_relaxed);
+    stats->naturalRuns = worker->base.naturalRuns + atomic_load_explicit(&worker->naturalRuns, memory_order_relaxed);
+    stats->gallopHits = worker->base.gallopHits + atomic_load_explicit(&worker->gallopHits, memory_order_relaxed);
+    stats->charComparisons = worker->base.charComparisons
+                             + atomic_load_explicit(&worker->charComparisons, memory_order_relaxed);
+}
+
+void freeSortWorker(SortWorker* worker) {
+    if (worker == NULL) return;
+    if (worker->ring != NULL && worker->machine != NULL) stopSortWorker(worker);
+    freeSortMachine(worker->machine);
+    freeOpRing(worker->ring);
+    freeThreadPool(worker->pool);
+    free(worker->directOps);
+    if (worker->sinkLock) SDL_DestroyMutex(worker->sinkLock);
+    free(worker);
+}